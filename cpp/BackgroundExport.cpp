@@ -0,0 +1,243 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <stdio.h>
+#include <memory>
+#include <streambuf>
+
+#include "../include/BackgroundExport.h"
+#include "../include/Logger.h"
+#include "../include/MapsExporter.h"
+#include "../include/Tracer.h"
+#include "../include/WorldData.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ Local types
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Stream buffer that hands each line written by the logger of the export
+// thread to the BackgroundExport object
+//----------------------------------------------------------------------------//
+class BackgroundLogBuffer : public std::streambuf
+{
+  BackgroundExport& _owner;
+  std::string       _line;
+
+public:
+  BackgroundLogBuffer(BackgroundExport& owner)
+    : _owner(owner)
+  {
+  }
+
+protected:
+  int overflow(int c)
+  {
+    if (c == traits_type::eof())
+      return traits_type::not_eof(c);
+
+    if ((c == '\n') || (c == '\r'))
+    {
+      _owner.add_line(_line, c == '\r');
+      _line.clear();
+    }
+    else
+      _line += (char)c;
+
+    return c;
+  }
+};
+
+/*****************************************************************************
+ Class methods
+*****************************************************************************/
+
+BackgroundExport::BackgroundExport()
+  : _thread(nullptr),
+    _state(IDLE),
+    _start_time(0),
+    _end_time(0),
+    _world_data(nullptr),
+    _maps(0),
+    _maps_raw(0),
+    _maps_hm(0)
+{
+}
+
+//----------------------------------------------------------------------------//
+// Destructor. The export thread uses this object, so wait for it
+//----------------------------------------------------------------------------//
+BackgroundExport::~BackgroundExport()
+{
+  this->wait();
+}
+
+//----------------------------------------------------------------------------//
+// Start the export thread
+//----------------------------------------------------------------------------//
+bool BackgroundExport::start(WorldData* world_data,          // World data to render
+                             const std::string& remove_file, // Snapshot to delete when done, or ""
+                             uint32_t maps,                  // Graphical maps to generate
+                             uint32_t maps_raw,              // Raw maps to generate
+                             uint32_t maps_hm,               // Height maps to generate
+                             const ExportOptions& options    // How to export them
+                             )
+{
+  if (this->is_running())
+    return false;
+
+  // The previous export thread has ended, but it must be joined
+  this->wait();
+
+  _world_data      = world_data;
+  _remove_file     = remove_file;
+  _maps            = maps;
+  _maps_raw        = maps_raw;
+  _maps_hm         = maps_hm;
+  _options         = options;
+
+  {
+    tthread::lock_guard<tthread::mutex> guard(_mutex);
+    _state      = RUNNING;
+    _start_time = Tracer::now();
+    _end_time   = 0;
+    _lines.clear();
+    _progress.clear();
+  }
+
+  _thread = new tthread::thread(run, (void*)this);
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Export thread. Renders the maps with its own exporter and logger
+//----------------------------------------------------------------------------//
+void BackgroundExport::run(void* data)
+{
+  BackgroundExport* self = (BackgroundExport*)data;
+
+  BackgroundLogBuffer log_buffer(*self);
+  std::ostream        log_stream(&log_buffer);
+  bool                ok = false;
+
+  {
+    Logger logger(log_stream);
+
+    // Too big for the stack of the thread
+    std::unique_ptr<MapsExporter> maps_exporter(new MapsExporter);
+    maps_exporter->set_logger(&logger);
+    maps_exporter->set_world_data(self->_world_data);
+
+    ok = maps_exporter->export_maps(self->_maps,     // Graphical maps
+                                    self->_maps_raw, // Raw maps
+                                    self->_maps_hm,  // Height maps
+                                    self->_options,  // How to export them
+                                    logger
+                                    );
+  }
+
+  tthread::lock_guard<tthread::mutex> guard(self->_mutex);
+  self->_state    = ok ? FINISHED : FAILED;
+  self->_end_time = Tracer::now();
+}
+
+//----------------------------------------------------------------------------//
+// Return true while the export thread is working
+//----------------------------------------------------------------------------//
+bool BackgroundExport::is_running()
+{
+  tthread::lock_guard<tthread::mutex> guard(_mutex);
+  return _state == RUNNING;
+}
+
+//----------------------------------------------------------------------------//
+// Write the state of the export and what it logged since the last call
+//----------------------------------------------------------------------------//
+void BackgroundExport::status(std::ostream& out)
+{
+  tthread::lock_guard<tthread::mutex> guard(_mutex);
+
+  if (_state == IDLE)
+  {
+    out << "No background export has been started" << std::endl;
+    return;
+  }
+
+  for (size_t i = 0; i < _lines.size(); ++i)
+    out << _lines[i] << std::endl;
+  _lines.clear();
+
+  int64_t end     = (_state == RUNNING) ? Tracer::now() : _end_time;
+  int64_t seconds = (end - _start_time) / 1000000000;
+
+  switch (_state)
+  {
+    case RUNNING:
+      if (!_progress.empty())
+        out << _progress << std::endl;
+      out << "Background export running for " << seconds << " s" << std::endl;
+      break;
+    case FINISHED:
+      out << "Background export finished in " << seconds << " s" << std::endl;
+      break;
+    default:
+      out << "Background export failed after " << seconds << " s" << std::endl;
+      break;
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Wait until the export thread ends. The snapshot file can only be deleted
+// once the world data stops mapping it
+//----------------------------------------------------------------------------//
+void BackgroundExport::wait()
+{
+  if (_thread == nullptr)
+    return;
+
+  _thread->join();
+  delete _thread;
+  _thread = nullptr;
+
+  delete _world_data;
+  _world_data = nullptr;
+
+  if (!_remove_file.empty())
+    remove(_remove_file.c_str());
+  _remove_file.clear();
+}
+
+//----------------------------------------------------------------------------//
+// Keep a line logged by the export thread
+//----------------------------------------------------------------------------//
+void BackgroundExport::add_line(const std::string& line,
+                                bool progress
+                                )
+{
+  tthread::lock_guard<tthread::mutex> guard(_mutex);
+
+  if (progress)
+    _progress = line;
+  else if (!line.empty())
+    _lines.push_back(line);
+}
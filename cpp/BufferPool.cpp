@@ -0,0 +1,183 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <tinythread.h>
+
+#include <map>
+#include <set>
+#include <string.h>
+
+#include "../include/BufferPool.h"
+
+using namespace exportmaps_plugin;
+
+namespace
+{
+  // Pooled buffers indexed by their size. Several maps of the same kind
+  // have the same size, so there can be more than one buffer for a size
+  typedef std::multimap<size_t, std::vector<unsigned char> > PooledBuffers;
+
+  PooledBuffers    pooled_buffers;
+  uint64_t         pooled_size = 0;
+  std::set<size_t> acquired_sizes; // Acquired since the start of the export
+  tthread::mutex   pool_mutex;     // Maps are created and written from several threads
+}
+
+//----------------------------------------------------------------------------//
+// Take a buffer of the wanted size from the pool or allocate a new one.
+// A reused buffer is cleared, as maps expect a zeroed image like the one
+// returned by resize()
+//----------------------------------------------------------------------------//
+void BufferPool::acquire(std::vector<unsigned char>& buffer, // buffer to fill
+                         size_t size                         // size in bytes
+                         )
+{
+  recycle(buffer);
+
+  {
+    tthread::lock_guard<tthread::mutex> guard(pool_mutex);
+
+    acquired_sizes.insert(size);
+
+    PooledBuffers::iterator it = pooled_buffers.find(size);
+    if (it != pooled_buffers.end())
+    {
+      buffer.swap(it->second);
+      pooled_buffers.erase(it);
+      pooled_size -= size;
+    }
+  }
+
+  if (buffer.empty())
+    buffer.resize(size);
+  else
+    // The pages are already mapped, so this is just a memory write
+    memset(&buffer[0], 0, size);
+}
+
+//----------------------------------------------------------------------------//
+// Keep the storage of a buffer for a later acquire()
+//----------------------------------------------------------------------------//
+void BufferPool::recycle(std::vector<unsigned char>& buffer // buffer no longer used
+                         )
+{
+  if (buffer.empty())
+    return;
+
+  // Only the size is used as key, so drop any spare capacity
+  if (buffer.capacity() != buffer.size())
+    std::vector<unsigned char>(buffer).swap(buffer);
+
+  size_t size = buffer.size();
+
+  tthread::lock_guard<tthread::mutex> guard(pool_mutex);
+
+  PooledBuffers::iterator it = pooled_buffers.insert(std::make_pair(size, std::vector<unsigned char>()));
+  it->second.swap(buffer);
+  pooled_size += size;
+}
+
+//----------------------------------------------------------------------------//
+// Free the biggest buffers until the pool is small enough
+//----------------------------------------------------------------------------//
+uint64_t BufferPool::trim(uint64_t max_bytes // bytes that can remain in the pool
+                          )
+{
+  PooledBuffers freed;
+  uint64_t      freed_size = 0;
+
+  {
+    tthread::lock_guard<tthread::mutex> guard(pool_mutex);
+
+    while ((pooled_size > max_bytes) && !pooled_buffers.empty())
+    {
+      PooledBuffers::iterator biggest = --pooled_buffers.end();
+      size_t size = biggest->first;
+
+      PooledBuffers::iterator it = freed.insert(std::make_pair(size, std::vector<unsigned char>()));
+      it->second.swap(biggest->second);
+      pooled_buffers.erase(biggest);
+
+      pooled_size -= size;
+      freed_size  += size;
+    }
+  }
+
+  // The memory is returned to the OS here, outside the lock, when freed
+  // goes out of scope
+  return freed_size;
+}
+
+//----------------------------------------------------------------------------//
+// Start recording the sizes used by an export
+//----------------------------------------------------------------------------//
+void BufferPool::start_export()
+{
+  tthread::lock_guard<tthread::mutex> guard(pool_mutex);
+  acquired_sizes.clear();
+}
+
+//----------------------------------------------------------------------------//
+// Free the buffers of the sizes the export didn't use
+//----------------------------------------------------------------------------//
+uint64_t BufferPool::evict_unused()
+{
+  PooledBuffers freed;
+  uint64_t      freed_size = 0;
+
+  {
+    tthread::lock_guard<tthread::mutex> guard(pool_mutex);
+
+    if (acquired_sizes.empty())
+      return 0;
+
+    PooledBuffers::iterator it = pooled_buffers.begin();
+    while (it != pooled_buffers.end())
+    {
+      if (acquired_sizes.count(it->first) != 0)
+      {
+        ++it;
+        continue;
+      }
+
+      size_t size = it->first;
+
+      PooledBuffers::iterator freed_it = freed.insert(std::make_pair(size, std::vector<unsigned char>()));
+      freed_it->second.swap(it->second);
+      pooled_buffers.erase(it++);
+
+      pooled_size -= size;
+      freed_size  += size;
+    }
+  }
+
+  // The memory is returned to the OS here, outside the lock
+  return freed_size;
+}
+
+//----------------------------------------------------------------------------//
+// Bytes held by the pool
+//----------------------------------------------------------------------------//
+uint64_t BufferPool::pooled_bytes()
+{
+  tthread::lock_guard<tthread::mutex> guard(pool_mutex);
+  return pooled_size;
+}
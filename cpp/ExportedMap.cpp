@@ -20,10 +20,15 @@
 // https://github.com/ragundo/exportmaps
 
 #include <math.h>
+#include <string.h>
 #include <iostream>
 #include <fstream>
 
+#include "../include/BufferPool.h"
 #include "../include/ExportedMap.h"
+#include "../include/RawContainer.h"
+#include "../include/TilePyramid.h"
+#include "../include/Tracer.h"
 
 using namespace exportmaps_plugin;
 
@@ -39,21 +44,31 @@ ExportedMapBase::ExportedMapBase()
 // Constructor
 //----------------------------------------------------------------------------//
 ExportedMapBase::ExportedMapBase(const std::string filename, // name of the file that will store the map
-                                 int world_width,            // world width in world coordinates
-                                 int world_height,           // world height in world coordinates
+                                 const MapWindow& window,    // part of the world covered by the map
                                  MapType type,               // Graphical map type or NONE
                                  MapTypeRaw type_raw,        // Raw map type or NONE_RAW
                                  MapTypeHeightMap type_hm    // Heightmap type or NONE_HM
                                  )
     : _filename(filename),
-      _width(world_width*16),
-      _height(world_height*16),
+      _width(window.width*16),
+      _height(window.height*16),
+      _origin_x(window.x*16),
+      _origin_y(window.y*16),
       _type(type),
       _type_raw(type_raw),
       _type_hm(type_hm)
 {
 }
 
+//----------------------------------------------------------------------------//
+// Destructor
+//----------------------------------------------------------------------------//
+ExportedMapBase::~ExportedMapBase()
+{
+  // Keep the image for the next export
+  BufferPool::recycle(_image);
+}
+
 //----------------------------------------------------------------------------//
 // Returns the map type (biome, elevation, etc)
 //----------------------------------------------------------------------------//
@@ -70,6 +85,32 @@ MapTypeRaw ExportedMapBase::get_type_raw()
   return _type_raw;
 }
 
+//----------------------------------------------------------------------------//
+// By default a map can't be split in tiles, so write it as a single file
+//----------------------------------------------------------------------------//
+int ExportedMapBase::write_tiles_to_disk(unsigned int num_threads // number of encoding threads
+                                         )
+{
+  return write_to_disk();
+}
+
+//----------------------------------------------------------------------------//
+// By default a map can't be loaded from a previous export
+//----------------------------------------------------------------------------//
+bool ExportedMapBase::load_previous(const std::string& filename // file of the previous export
+                                    )
+{
+  return false;
+}
+
+//----------------------------------------------------------------------------//
+// Returns the name of the file where the map will be saved
+//----------------------------------------------------------------------------//
+const std::string& ExportedMapBase::get_filename()
+{
+  return _filename;
+}
+
 //----------------------------------------------------------------------------//
 // Return true if the map type is graphical
 //----------------------------------------------------------------------------//
@@ -98,21 +139,19 @@ ExportedMapDF::ExportedMapDF()
 // Constructor
 //----------------------------------------------------------------------------//
 ExportedMapDF::ExportedMapDF(const std::string filename, // name of the file that will store the map
-                             int world_width,            // world width in world coordinates
-                             int world_height,           // world height in world coordinates
+                             const MapWindow& window,    // part of the world covered by the map
                              MapType type                // The map type to be draw (biome, elevation, etc)
                              )
   : ExportedMapBase(filename,
-                    world_width,
-                    world_height,
+                    window,
                     type,
                     MapTypeRaw::NONE_RAW,
                     MapTypeHeightMap::NONE_HM
                     )
 {
   // Each world tile has 16 * 16 embark pixels. Each pixel needs 4 bytes
-  // so resize the image to its correct size
-  _image.resize(world_width * world_height * 16 * 16 * 4); // 4 = RGBA for PNG
+  // so get an image of its correct size
+  BufferPool::acquire(_image, (size_t)window.width * window.height * 16 * 16 * 4); // 4 = RGBA for PNG
 }
 
 //----------------------------------------------------------------------------//
@@ -128,10 +167,9 @@ void ExportedMapDF::write_world_pixel(int pos_x,     // pixel world coordinate x
                                       RGB_color& rgb // Pixel color
                                       )
 {
-  int index_png = pos_y * 16 * _height +
-                  pos_x * 16          +
-                  py         * _height +
-                  px;
+  size_t index_png;
+  if (!pixel_index(pos_x * 16 + px, pos_y * 16 + py, index_png))
+    return;
 
   _image[4*index_png + 0] = std::get<0>(rgb);
   _image[4*index_png + 1] = std::get<1>(rgb);
@@ -147,16 +185,9 @@ void ExportedMapDF::write_embark_pixel(int px,        // Pixel embark coordinate
                                        RGB_color& rgb // Pixel color
                                        )
 {
-  // Compute world coordinates
-  int dpy = py >> 4;
-  int dpx = px >> 4;
-  int mpy = py % 16;
-  int mpx = px % 16;
-
-  int index_png = dpy * 16 * _height +
-                  dpx * 16          +
-                  mpy      * _height +
-                  mpx;
+  size_t index_png;
+  if (!pixel_index(px, py, index_png))
+    return;
 
   _image[4*index_png + 0] = std::get<0>(rgb);
   _image[4*index_png + 1] = std::get<1>(rgb);
@@ -166,7 +197,8 @@ void ExportedMapDF::write_embark_pixel(int px,        // Pixel embark coordinate
 
 //----------------------------------------------------------------------------//
 // Write a "thick" point of a line.
-// A thick line has a center pixel and two border pixels
+// A thick line has a center pixel and two border pixels.
+// The pixels out of the map are clipped
 //----------------------------------------------------------------------------//
 void ExportedMapDF::write_thick_line_point(int px,                  // Pixel embark coordinate x
                                            int py,                  // Pixel embark coordinate y
@@ -174,27 +206,20 @@ void ExportedMapDF::write_thick_line_point(int px,                  // Pixel emb
                                            RGB_color& color_border  // Border color
                                            )
 {
-  // Compute world coordinates
-  int dpy = py >> 4;
-  int dpx = px >> 4;
-  int mpy = py % 16;
-  int mpx = px % 16;
-
-  int index_png = dpy * 16 * _height +
-                  dpx * 16          +
-                  mpy      * _height +
-                  mpx;
-
   unsigned char r_center = std::get<0>(color_center);
   unsigned char g_center = std::get<1>(color_center);
   unsigned char b_center = std::get<2>(color_center);
 
+  size_t index_png;
 
   // Draw the center pixel
-  _image[4*index_png + 0] = r_center;
-  _image[4*index_png + 1] = g_center;
-  _image[4*index_png + 2] = b_center;
-  _image[4*index_png + 3] = 255;    // Solid color
+  if (pixel_index(px, py, index_png))
+  {
+    _image[4*index_png + 0] = r_center;
+    _image[4*index_png + 1] = g_center;
+    _image[4*index_png + 2] = b_center;
+    _image[4*index_png + 3] = 255;    // Solid color
+  }
 
   unsigned char r_border = std::get<0>(color_border);
   unsigned char g_border = std::get<1>(color_border);
@@ -202,107 +227,28 @@ void ExportedMapDF::write_thick_line_point(int px,                  // Pixel emb
 
   // Now draw a rectangle around the center pixel using the
   // border color, but check that we don't overwrite previous
-  // center pixels of the line
-  if (!((_image[4*index_png + 4 + 0] == r_center) &&
-        (_image[4*index_png + 4 + 1] == g_center) &&
-        (_image[4*index_png + 4 + 2] == b_center)
-       )
-     )
-  {
-    _image[4*index_png + 4 + 0] = r_border;
-    _image[4*index_png + 4 + 1] = g_border;
-    _image[4*index_png + 4 + 2] = b_border;
-    _image[4*index_png + 4 + 3] = 255;    // Solid color
-  }
+  // center pixels of the line. First the same line, then the
+  // line above and the line below
+  static const int border[8][2] = { { 1, 0}, {-1, 0},
+                                    { 1,-1}, { 0,-1}, {-1,-1},
+                                    { 1, 1}, { 0, 1}, {-1, 1} };
 
-  if (!((_image[4*index_png - 4 + 0] == r_center) &&
-        (_image[4*index_png - 4 + 1] == g_center) &&
-        (_image[4*index_png - 4 + 2] == b_center)
-       )
-     )
+  for (int i = 0; i < 8; ++i)
   {
-    _image[4*index_png - 4 + 0] = r_border;
-    _image[4*index_png - 4 + 1] = g_border;
-    _image[4*index_png - 4 + 2] = b_border;
-    _image[4*index_png - 4 + 3] = 255;    // Solid color
-  }
+    if (!pixel_index(px + border[i][0], py + border[i][1], index_png))
+      continue;
 
-  // Go up one line
-  index_png -= this->_width;
-
-  if (!((_image[4*index_png + 4 + 0] == r_center) &&
-        (_image[4*index_png + 4 + 1] == g_center) &&
-        (_image[4*index_png + 4 + 2] == b_center)
+    if (!((_image[4*index_png + 0] == r_center) &&
+          (_image[4*index_png + 1] == g_center) &&
+          (_image[4*index_png + 2] == b_center)
+         )
        )
-     )
-  {
-    _image[4*index_png + 4 + 0] = r_border;
-    _image[4*index_png + 4 + 1] = g_border;
-    _image[4*index_png + 4 + 2] = b_border;
-    _image[4*index_png + 4 + 3] = 255;    // Solid color
-  }
-
-  if (!((_image[4*index_png + 0 + 0] == r_center) &&
-        (_image[4*index_png + 0 + 1] == g_center) &&
-        (_image[4*index_png + 0 + 2] == b_center)
-       )
-     )
-  {
-    _image[4*index_png + 0 + 0] = r_border;
-    _image[4*index_png + 0 + 1] = g_border;
-    _image[4*index_png + 0 + 2] = b_border;
-    _image[4*index_png + 0 + 3] = 255;    // Solid color
-  }
-
-  if (!((_image[4*index_png - 4 + 0] == r_center) &&
-        (_image[4*index_png - 4 + 1] == g_center) &&
-        (_image[4*index_png - 4 + 2] == b_center)
-       )
-     )
-  {
-    _image[4*index_png - 4 + 0] = r_border;
-    _image[4*index_png - 4 + 1] = g_border;
-    _image[4*index_png - 4 + 2] = b_border;
-    _image[4*index_png - 4 + 3] = 255;    // Solid color
-  }
-
-  // Go down two lines
-  index_png += this->_width * 2;
-
-  if (!((_image[4*index_png + 4 + 0] == r_center) &&
-        (_image[4*index_png + 4 + 1] == g_center) &&
-        (_image[4*index_png + 4 + 2] == b_center)
-       )
-     )
-  {
-    _image[4*index_png + 4 + 0] = r_border;
-    _image[4*index_png + 4 + 1] = g_border;
-    _image[4*index_png + 4 + 2] = b_border;
-    _image[4*index_png + 4 + 3] = 255;    // Solid color
-  }
-
-  if (!((_image[4*index_png + 0 + 0] == r_center) &&
-        (_image[4*index_png + 0 + 1] == g_center) &&
-        (_image[4*index_png + 0 + 2] == b_center)
-       )
-     )
-  {
-    _image[4*index_png + 0 + 0] = r_border;
-    _image[4*index_png + 0 + 1] = g_border;
-    _image[4*index_png + 0 + 2] = b_border;
-    _image[4*index_png + 0 + 3] = 255;    // Solid color
-  }
-
-  if (!((_image[4*index_png - 4 + 0] == r_center) &&
-        (_image[4*index_png - 4 + 1] == g_center) &&
-        (_image[4*index_png - 4 + 2] == b_center)
-       )
-     )
-  {
-    _image[4*index_png - 4 + 0] = r_border;
-    _image[4*index_png - 4 + 1] = g_border;
-    _image[4*index_png - 4 + 2] = b_border;
-    _image[4*index_png - 4 + 3] = 255;    // Solid color
+    {
+      _image[4*index_png + 0] = r_border;
+      _image[4*index_png + 1] = g_border;
+      _image[4*index_png + 2] = b_border;
+      _image[4*index_png + 3] = 255;    // Solid color
+    }
   }
 }
 
@@ -326,6 +272,8 @@ void ExportedMapDF::write_data(int pos_x,
 //----------------------------------------------------------------------------//
 int ExportedMapDF::write_to_disk()
 {
+  TraceSpan trace_span("png encode");
+
   //Encode from raw pixels to disk with a single function call
   //The image argument has width * height RGBA pixels or width * height * 4 bytes
   return lodepng::encode(_filename,
@@ -335,6 +283,48 @@ int ExportedMapDF::write_to_disk()
                          );
 }
 
+//----------------------------------------------------------------------------//
+// Write the map as a tile pyramid. The directory takes the name of the
+// PNG file without the extension
+//----------------------------------------------------------------------------//
+int ExportedMapDF::write_tiles_to_disk(unsigned int num_threads // number of encoding threads
+                                       )
+{
+  std::string directory = _filename;
+  size_t extension = directory.rfind(".png");
+  if (extension != std::string::npos)
+    directory.erase(extension);
+  directory += "-tiles";
+
+  // The pyramid takes the full size image as its deepest level
+  TilePyramid pyramid(directory, _image, _width, _height);
+
+  return pyramid.write_to_disk(num_threads);
+}
+
+//----------------------------------------------------------------------------//
+// Decode a PNG file of a previous export. The decoded image replaces the
+// empty one, that goes back to the pool
+//----------------------------------------------------------------------------//
+bool ExportedMapDF::load_previous(const std::string& filename // file of the previous export
+                                  )
+{
+  TraceSpan trace_span("png decode");
+
+  std::vector<unsigned char> previous;
+  unsigned int width  = 0;
+  unsigned int height = 0;
+
+  if ((lodepng::decode(previous, width, height, filename) != 0) ||
+      ((int)width  != _width) ||
+      ((int)height != _height))
+    return false;
+
+  _image.swap(previous);
+  BufferPool::recycle(previous);
+  return true;
+}
+
 
 
 /*****************************************************************************
@@ -342,24 +332,94 @@ ExportedMapRaw methods
 *****************************************************************************/
 
 ExportedMapRaw::ExportedMapRaw()
+  : _samples(nullptr),
+    _sample_type(RawSampleType::SAMPLE_INT16),
+    _container(nullptr)
 {
 }
 
 ExportedMapRaw::ExportedMapRaw(const std::string filename, // name of the file that will store the map
-                               int world_width,            // world width in world coordinates
-                               int world_height,           // world height in world coordinates
+                               const MapWindow& window,    // part of the world covered by the map
                                MapTypeRaw type_raw         // The raw map type to be written (biome, elevation, etc)
                                )
   : ExportedMapBase(filename,
-                    world_width,
-                    world_height,
+                    window,
                     MapType::NONE,
                     type_raw,
                     MapTypeHeightMap::NONE_HM
-                    )
+                    ),
+    _samples(nullptr),
+    _sample_type(RawSampleType::SAMPLE_INT16),
+    _container(nullptr)
+{
+  // Each world tile has 16 * 16 entries. Each entry needs 2 bytes
+  size_t data_size = (size_t)window.width * window.height * 16 * 16 * 2;
+
+  // Create the output file with its final size: 8 bytes of header
+  // (width and height) followed by the samples
+  if (_file.open(_filename, 8 + data_size))
+  {
+    unsigned char* header = _file.data();
+
+    // Use little endian format (LSB first, MSB last)
+    for (int i = 0; i < 4; ++i)
+    {
+      header[i + 0] = (unsigned char)((unsigned int)_width  >> (8*i));
+      header[i + 4] = (unsigned char)((unsigned int)_height >> (8*i));
+    }
+
+    // DF only runs in little endian x86 machines, so the samples can be
+    // written in native format
+    _samples = header + 8;
+  }
+  else
+    // The file can't be mapped. Keep the samples in memory
+    BufferPool::acquire(_image, data_size);
+}
+
+//----------------------------------------------------------------------------//
+// Constructor for a map stored as a layer of a container.
+// The storage is attached later by the container
+//----------------------------------------------------------------------------//
+ExportedMapRaw::ExportedMapRaw(RawContainer* container,      // container where the map is stored
+                               const std::string layer_name, // name of the layer in the container
+                               const MapWindow& window,      // part of the world covered by the map
+                               MapTypeRaw type_raw,          // The raw map type to be written (biome, elevation, etc)
+                               int min_value,                // minimum value that will be written
+                               int max_value                 // maximum value that will be written
+                               )
+  : ExportedMapBase(layer_name,
+                    window,
+                    MapType::NONE,
+                    type_raw,
+                    MapTypeHeightMap::NONE_HM
+                    ),
+    _samples(nullptr),
+    _sample_type(RawSampleType::SAMPLE_INT16),
+    _container(container)
+{
+  _container->add_layer(this, layer_name, type_raw, min_value, max_value);
+}
+
+//----------------------------------------------------------------------------//
+// Use an external buffer to store the samples
+//----------------------------------------------------------------------------//
+void ExportedMapRaw::attach_samples(unsigned char* samples,  // start of the buffer
+                                    RawSampleType sample_type // type of each sample
+                                    )
 {
-    // Each world tile has 16 * 16 entries. Each entry needs 2 bytes
-    _image.resize(world_width * world_height * 16 * 16 * 2);
+  _samples     = samples;
+  _sample_type = sample_type;
+}
+
+//----------------------------------------------------------------------------//
+// Destructor
+// If the map was never written to disk (an error happened), the partially
+// filled output file is removed
+//----------------------------------------------------------------------------//
+ExportedMapRaw::~ExportedMapRaw()
+{
+  _file.close(true);
 }
 
 //----------------------------------------------------------------------------//
@@ -409,23 +469,25 @@ void ExportedMapRaw::write_data(int pos_x,         // pixel world coordinate x
                                 int value          // value to be written to the file
                                 )
 {
-  int index_buffer = pos_y * 16 * _height +
-                     pos_x * 16           +
-                     py         * _height +
-                     px;
+  size_t index_buffer;
+  if (!pixel_index(pos_x * 16 + px, pos_y * 16 + py, index_buffer))
+    return;
 
-  if (value < 0)
+  if (_samples != nullptr)
   {
-   value = value + 65536;
+    // Write directly to the mapped file or the container layer
+    switch (_sample_type)
+    {
+      case RawSampleType::SAMPLE_UINT8:  ((uint8_t*) _samples)[index_buffer] = (uint8_t) value; break;
+      case RawSampleType::SAMPLE_UINT16: ((uint16_t*)_samples)[index_buffer] = (uint16_t)value; break;
+      default:                           ((int16_t*) _samples)[index_buffer] = (int16_t) value; break;
+    }
+    return;
   }
-  float f = (float)value/256;
-
-  unsigned char lsb = (value <= 255 ? value : value % 256);
-  unsigned char msb = (value <= 255 ? 0     : (unsigned int)floor(f));
 
   // Use little endian format (LSB first, MSB last)
-  _image[2*index_buffer + 0] = lsb;
-  _image[2*index_buffer + 1] = msb;
+  _image[2*index_buffer + 0] = (unsigned char)(value & 0xFF);
+  _image[2*index_buffer + 1] = (unsigned char)((value >> 8) & 0xFF);
 }
 
 //----------------------------------------------------------------------------//
@@ -441,7 +503,20 @@ void write_little_endian(std::ostream& outs, // The stream where to write
 
 int ExportedMapRaw::write_to_disk()
 {
+  // The container writes all its layers at once
+  if (_container != nullptr)
+    return 0;
+
+  if (_file.is_open())
+  {
+    // The data is already in the file. Unmap it so the OS writes it back
+    _file.close();
+    _samples = nullptr;
+    return 0;
+  }
+
   // Write the buffer to the fstream
+  TraceSpan trace_span("raw write");
   std::ofstream outfile(_filename, std::ios::out | std::ios::binary);
 
   write_little_endian(outfile,
@@ -461,6 +536,39 @@ int ExportedMapRaw::write_to_disk()
   return 0;
 }
 
+//----------------------------------------------------------------------------//
+// Copy the samples of a raw file of a previous export, if it has the same
+// size. Maps stored in a container can't be loaded
+//----------------------------------------------------------------------------//
+bool ExportedMapRaw::load_previous(const std::string& filename // file of the previous export
+                                   )
+{
+  if (_container != nullptr)
+    return false;
+
+  MappedFile previous;
+  if (!previous.open_read(filename))
+    return false;
+
+  size_t data_size = (size_t)_width * _height * 2;
+  const unsigned char* header = previous.data();
+
+  unsigned int width  = 0;
+  unsigned int height = 0;
+  if (previous.size() == 8 + data_size)
+    for (int i = 0; i < 4; ++i)
+    {
+      width  |= (unsigned int)header[i + 0] << (8*i);
+      height |= (unsigned int)header[i + 4] << (8*i);
+    }
+
+  if (((int)width != _width) || ((int)height != _height))
+    return false;
+
+  memcpy((_samples != nullptr) ? _samples : &_image[0], header + 8, data_size);
+  return true;
+}
+
 
 /*****************************************************************************
 ExportedMapHM methods
@@ -474,21 +582,19 @@ ExportedMapHM::ExportedMapHM()
 // Constructor
 //----------------------------------------------------------------------------//
 ExportedMapHM::ExportedMapHM(const std::string filename, // name of the file that will store the map
-                             int world_width,            // world width in world coordinates
-                             int world_height,           // world height in world coordinates
+                             const MapWindow& window,    // part of the world covered by the map
                              MapTypeHeightMap type       // The heightmap type
                              )
   : ExportedMapBase(filename,
-                    world_width,
-                    world_height,
+                    window,
                     MapType::NONE,
                     MapTypeRaw::NONE_RAW,
                     type
                     )
 {
-  // Each world tile has 16 * 16 embark pixels. Each pixel needs 4 bytes
-  // so resize the image to its correct size
-  _image.resize(world_width * world_height * 16 * 16 * 4); // 4 = RGBA for PNG
+  // Each world tile has 16 * 16 embark pixels. Heightmaps are stored as a
+  // single 16 bit grey channel, so each pixel needs 2 bytes
+  BufferPool::acquire(_image, (size_t)window.width * window.height * 16 * 16 * 2); // 2 = 16 bit grey for PNG
 }
 
 //----------------------------------------------------------------------------//
@@ -504,15 +610,14 @@ void ExportedMapHM::write_world_pixel(int pos_x,     // pixel world coordinate x
                                       RGB_color& rgb // Pixel color
                                       )
 {
-  int index_png = pos_y * 16 * _height +
-                  pos_x * 16          +
-                  py         * _height +
-                  px;
-
-  _image[4*index_png + 0] = std::get<0>(rgb);
-  _image[4*index_png + 1] = std::get<1>(rgb);
-  _image[4*index_png + 2] = std::get<2>(rgb);
-  _image[4*index_png + 3] = 255;              // Solid color
+  // Heightmaps only have a grey channel, so take the red component
+  // and expand it to the full 16 bit range (255 -> 65535)
+  this->write_data(pos_x,
+                   pos_y,
+                   px,
+                   py,
+                   std::get<0>(rgb) * 257
+                   );
 }
 
 //----------------------------------------------------------------------------//
@@ -541,16 +646,26 @@ void ExportedMapHM::write_thick_line_point(int px,                  // Pixel emb
 
 
 //----------------------------------------------------------------------------//
-// Virtual method
-// The base class does nothing
+// Write a 16 bit height value to the heightmap.
+// The value must be already scaled to the range 0..65535
 //----------------------------------------------------------------------------//
-void ExportedMapHM::write_data(int pos_x,
-                               int pos_y,
-                               int px,
-                               int py,
-                               int value
+void ExportedMapHM::write_data(int pos_x,         // pixel world coordinate x
+                               int pos_y,         // pixel world coordinate y
+                               int px,            // Delta x (0..15)
+                               int py,            // Delta y (0..15)
+                               int value          // height value (0..65535)
                                )
 {
+  size_t index_png;
+  if (!pixel_index(pos_x * 16 + px, pos_y * 16 + py, index_png))
+    return;
+
+  if (value < 0)     value = 0;
+  if (value > 65535) value = 65535;
+
+  // PNG stores 16 bit samples in big endian format (MSB first, LSB last)
+  _image[2*index_png + 0] = (unsigned char)(value >> 8);
+  _image[2*index_png + 1] = (unsigned char)(value & 0xFF);
 }
 
 
@@ -559,14 +674,41 @@ void ExportedMapHM::write_data(int pos_x,
 //----------------------------------------------------------------------------//
 int ExportedMapHM::write_to_disk()
 {
+  TraceSpan trace_span("png encode");
+
   //Encode from raw pixels to disk with a single function call
-  //The image argument has width * height RGBA pixels or width * height * 4 bytes
+  //The image argument has width * height 16 bit grey pixels or width * height * 2 bytes
   return lodepng::encode(_filename,
                          _image,
                          _width,
-                         _height
+                         _height,
+                         LCT_GREY,
+                         16
                          );
 }
 
+//----------------------------------------------------------------------------//
+// Decode a 16 bit grayscale PNG of a previous export. lodepng returns the
+// samples in big endian format, as they are stored in the image
+//----------------------------------------------------------------------------//
+bool ExportedMapHM::load_previous(const std::string& filename // file of the previous export
+                                  )
+{
+  TraceSpan trace_span("png decode");
+
+  std::vector<unsigned char> previous;
+  unsigned int width  = 0;
+  unsigned int height = 0;
+
+  if ((lodepng::decode(previous, width, height, filename, LCT_GREY, 16) != 0) ||
+      ((int)width  != _width) ||
+      ((int)height != _height))
+    return false;
+
+  _image.swap(previous);
+  BufferPool::recycle(previous);
+  return true;
+}
+
 
 
@@ -20,58 +20,151 @@
 // https://github.com/ragundo/exportmaps
 
 #include <iomanip>
+#include <sstream>
 #include "../include/Logger.h"
+#include "../include/Tracer.h"
+
+// Line being built by each thread
+static thread_local std::string thread_line;
 
 //----------------------------------------------------------------------------//
 // Constructor
-// Store a reference to the DFHack console
+// Store a reference to the DFHack console, or to the standard output when
+// the maps are rendered outside DF. The calling thread is the only one
+// that will write to it
+//----------------------------------------------------------------------------//
+Logger::Logger(std::ostream& out)
+  : _out(out),
+    _pending(nullptr),
+    _owner(tthread::this_thread::get_id()),
+    _last_flush(0)
+{
+}
+
+//----------------------------------------------------------------------------//
+// Destructor
+// Write whatever is still queued
 //----------------------------------------------------------------------------//
-Logger::Logger(DFHack::color_ostream& out) : _out(out) {};
+Logger::~Logger()
+{
+  flush();
+}
 
 //----------------------------------------------------------------------------//
-// Logs a string to the DFHack console without adding a newline
+// Logs a string without ending the line
 //----------------------------------------------------------------------------//
 void Logger::log(std::string st)
 {
-  _out << st;
+  thread_line += st;
 }
 
 //----------------------------------------------------------------------------//
-// Logs a string to the DFHack console adding a newline
+// Logs a string adding a newline
 //----------------------------------------------------------------------------//
 void Logger::log_line(std::string st)
 {
-  _out << st << std::endl;
+  thread_line += st;
+  end_line('\n');
 }
 
 //----------------------------------------------------------------------------//
-// Logs a newline to the DFHack console
+// Logs a newline
 //----------------------------------------------------------------------------//
 void Logger::log_endl()
 {
-  _out << std::endl;
+  end_line('\n');
 }
 
 //----------------------------------------------------------------------------//
-// Logs a carriage return to the DFHack console
+// Logs a carriage return, so the next line is written over this one
 //----------------------------------------------------------------------------//
 void Logger::log_cr()
 {
-  _out << "\r" << std::flush;
+  end_line('\r');
 }
 
 //----------------------------------------------------------------------------//
-// Logs a integer number to the DFHack console
+// Logs a integer number
 //----------------------------------------------------------------------------//
 void Logger::log_number(unsigned int i)
 {
-  _out << i;
+  std::ostringstream number;
+  number << i;
+  thread_line += number.str();
 }
 
 //----------------------------------------------------------------------------//
-// Logs a integer number to the console using a maximum width
+// Logs a integer number using a minimum width
 //----------------------------------------------------------------------------//
 void Logger::log_number(unsigned int i, unsigned int width)
 {
-  _out << std::setw(width) << i;
+  std::ostringstream number;
+  number << std::setw(width) << i;
+  thread_line += number.str();
+}
+
+//----------------------------------------------------------------------------//
+// Queue the line built by this thread. If this is the thread that owns the
+// console and enough time has passed, write the queue
+//----------------------------------------------------------------------------//
+void Logger::end_line(char terminator)
+{
+  Message* message = new Message;
+  message->text.swap(thread_line);
+  message->text += terminator;
+
+  // Lock free push at the head of the queue
+  message->next = _pending.load(std::memory_order_relaxed);
+  while (!_pending.compare_exchange_weak(message->next,
+                                         message,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed
+                                         ))
+    ;
+
+  if (tthread::this_thread::get_id() == _owner)
+  {
+    int64_t now = exportmaps_plugin::Tracer::now();
+    if (now - _last_flush >= FLUSH_INTERVAL)
+    {
+      flush();
+      _last_flush = now;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Write all the queued lines to the console
+//----------------------------------------------------------------------------//
+void Logger::flush()
+{
+  // Take the whole queue at once and put it in the order it was logged
+  Message* message = _pending.exchange(nullptr, std::memory_order_acquire);
+  Message* ordered = nullptr;
+  while (message != nullptr)
+  {
+    Message* next = message->next;
+    message->next = ordered;
+    ordered       = message;
+    message       = next;
+  }
+
+  if (ordered == nullptr)
+    return;
+
+  while (ordered != nullptr)
+  {
+    Message* next = ordered->next;
+
+    // Skip the status lines replaced by a newer one
+    bool replaced = (ordered->text[ordered->text.size() - 1] == '\r') &&
+                    (next != nullptr) &&
+                    (next->text[next->text.size() - 1] == '\r');
+    if (!replaced)
+      _out << ordered->text;
+
+    delete ordered;
+    ordered = next;
+  }
+  _out << std::flush;
 }
@@ -0,0 +1,250 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+
+#include <stdint.h>
+#include "../include/MapRegistry.h"
+#include "../include/MapsExporter.h"
+#include "../include/Producer.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ External functions declaration
+ Here comes all the threads functions for the different maps.
+*****************************************************************************/
+extern void consumer_biome                     (void* arg);
+extern void consumer_drainage                  (void* arg);
+extern void consumer_elevation                 (void* arg);
+extern void consumer_elevation_water           (void* arg);
+extern void consumer_evilness                  (void* arg);
+extern void consumer_hydro                     (void* arg);
+extern void consumer_rainfall                  (void* arg);
+extern void consumer_region                    (void* arg);
+extern void consumer_salinity                  (void* arg);
+extern void consumer_savagery                  (void* arg);
+extern void consumer_temperature               (void* arg);
+extern void consumer_vegetation                (void* arg);
+extern void consumer_volcanism                 (void* arg);
+
+// These ones read DF directly and are not part of the headless renderer
+#ifndef EXPORTMAPS_HEADLESS
+extern void consumer_diplomacy                 (void* arg);
+extern void consumer_geology                   (void* arg);
+extern void consumer_nobility                  (void* arg);
+extern void consumer_sites                     (void* arg);
+extern void consumer_trading                   (void* arg);
+#else
+static void (* const consumer_diplomacy)(void*) = nullptr;
+static void (* const consumer_geology)  (void*) = nullptr;
+static void (* const consumer_nobility) (void*) = nullptr;
+static void (* const consumer_sites)    (void*) = nullptr;
+static void (* const consumer_trading)  (void*) = nullptr;
+#endif
+
+extern void consumer_biome_type_raw            (void* arg);
+extern void consumer_biome_region_raw          (void* arg);
+extern void consumer_drainage_raw              (void* arg);
+extern void consumer_elevation_raw             (void* arg);
+extern void consumer_elevation_water_raw       (void* arg);
+extern void consumer_evilness_raw              (void* arg);
+extern void consumer_hydro_raw                 (void* arg);
+extern void consumer_rainfall_raw              (void* arg);
+extern void consumer_salinity_raw              (void* arg);
+extern void consumer_savagery_raw              (void* arg);
+extern void consumer_temperature_raw           (void* arg);
+extern void consumer_vegetation_raw            (void* arg);
+extern void consumer_volcanism_raw             (void* arg);
+
+extern void consumer_elevation_heightmap       (void* arg);
+extern void consumer_elevation_water_heightmap (void* arg);
+
+/*****************************************************************************
+ Local types
+*****************************************************************************/
+
+// Fingerprint fields as bits
+static const uint32_t FP_TERRAIN     = 1u << TileFingerprints::FIELD_TERRAIN;
+static const uint32_t FP_BIOME_TYPE  = 1u << TileFingerprints::FIELD_BIOME_TYPE;
+static const uint32_t FP_REGION      = 1u << TileFingerprints::FIELD_REGION;
+static const uint32_t FP_TEMPERATURE = 1u << TileFingerprints::FIELD_TEMPERATURE;
+static const uint32_t FP_RAINFALL    = 1u << TileFingerprints::FIELD_RAINFALL;
+static const uint32_t FP_DRAINAGE    = 1u << TileFingerprints::FIELD_DRAINAGE;
+static const uint32_t FP_SAVAGERY    = 1u << TileFingerprints::FIELD_SAVAGERY;
+static const uint32_t FP_VOLCANISM   = 1u << TileFingerprints::FIELD_VOLCANISM;
+static const uint32_t FP_VEGETATION  = 1u << TileFingerprints::FIELD_VEGETATION;
+static const uint32_t FP_EVILNESS    = 1u << TileFingerprints::FIELD_EVILNESS;
+static const uint32_t FP_SALINITY    = 1u << TileFingerprints::FIELD_SALINITY;
+
+// Region details read by the maps that draw rivers over the terrain
+static const uint32_t DETAILS_TERRAIN = DETAILS_BIOME | DETAILS_ELEVATION | DETAILS_RIVERS;
+
+/*****************************************************************************
+ Local functions
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Create the producer of a map and the queue for its records
+//----------------------------------------------------------------------------//
+template<MapId id>
+static void create_map_slot(MapSlot& slot // where the map is kept
+                            )
+{
+  slot.producer.reset(new MapProducer<id>);
+  slot.queue.reset(new MapQueue<typename MapTraits<id>::record_type>);
+}
+
+/*****************************************************************************
+ The registry, in MapId order.
+ Geology has no map type bit yet, so it's never requested
+*****************************************************************************/
+static const MapInfo map_registry[MAP_COUNT] =
+{
+  // DF maps
+  { MAP_KIND_DF,  MapType::TEMPERATURE,     "temperature",     "write temperature",     "-tmp",
+    DETAILS_BIOME,     FIELD_TEMPERATURE,                   FP_TEMPERATURE,                false, 0, 0,
+    consumer_temperature,     create_map_slot<MAP_TEMPERATURE> },
+  { MAP_KIND_DF,  MapType::RAINFALL,        "rainfall",        "write rainfall",        "-rain",
+    DETAILS_BIOME,     FIELD_RAINFALL,                      FP_RAINFALL,                   false, 0, 0,
+    consumer_rainfall,        create_map_slot<MAP_RAINFALL> },
+  { MAP_KIND_DF,  MapType::REGION,          "region",          "write region",          "-rgn",
+    DETAILS_BIOME,     FIELD_REGION_ID,                     FP_REGION,                     false, 0, 0,
+    consumer_region,          create_map_slot<MAP_REGION> },
+  { MAP_KIND_DF,  MapType::DRAINAGE,        "drainage",        "write drainage",        "-drn",
+    DETAILS_BIOME,     FIELD_DRAINAGE,                      FP_DRAINAGE,                   false, 0, 0,
+    consumer_drainage,        create_map_slot<MAP_DRAINAGE> },
+  { MAP_KIND_DF,  MapType::SAVAGERY,        "savagery",        "write savagery",        "-sav",
+    DETAILS_BIOME,     FIELD_SAVAGERY,                      FP_SAVAGERY,                   false, 0, 0,
+    consumer_savagery,        create_map_slot<MAP_SAVAGERY> },
+  { MAP_KIND_DF,  MapType::VOLCANISM,       "volcanism",       "write volcanism",       "-vol",
+    DETAILS_BIOME,     FIELD_VOLCANISM,                     FP_VOLCANISM,                  false, 0, 0,
+    consumer_volcanism,       create_map_slot<MAP_VOLCANISM> },
+  { MAP_KIND_DF,  MapType::VEGETATION,      "vegetation",      "write vegetation",      "-veg",
+    DETAILS_BIOME,     FIELD_VEGETATION | FIELD_BIOME_TYPE, FP_VEGETATION | FP_BIOME_TYPE, false, 0, 0,
+    consumer_vegetation,      create_map_slot<MAP_VEGETATION> },
+  { MAP_KIND_DF,  MapType::EVILNESS,        "evilness",        "write evilness",        "-evil",
+    DETAILS_BIOME,     FIELD_EVILNESS,                      FP_EVILNESS,                   false, 0, 0,
+    consumer_evilness,        create_map_slot<MAP_EVILNESS> },
+  { MAP_KIND_DF,  MapType::SALINITY,        "salinity",        "write salinity",        "-sal",
+    DETAILS_BIOME,     FIELD_SALINITY,                      FP_SALINITY,                   false, 0, 0,
+    consumer_salinity,        create_map_slot<MAP_SALINITY> },
+  { MAP_KIND_DF,  MapType::HYDROSPHERE,     "hydro",           "write hydro",           "-hyd",
+    DETAILS_HYDRO,     0,                                   FP_TERRAIN,                    false, 0, 0,
+    consumer_hydro,           create_map_slot<MAP_HYDRO> },
+  { MAP_KIND_DF,  MapType::ELEVATION,       "elevation",       "write elevation",       "-el",
+    DETAILS_ELEVATION, 0,                                   FP_TERRAIN,                    false, 0, 0,
+    consumer_elevation,       create_map_slot<MAP_ELEVATION> },
+  { MAP_KIND_DF,  MapType::ELEVATION_WATER, "elevation_water", "write elevation_water", "-elw",
+    DETAILS_ELEVATION_WATER, 0,                             FP_TERRAIN,                    false, 0, 0,
+    consumer_elevation_water, create_map_slot<MAP_ELEVATION_WATER> },
+  { MAP_KIND_DF,  MapType::BIOME,           "biome",           "write biome",           "-bm",
+    DETAILS_BIOME,     FIELD_BIOME_TYPE,                    FP_BIOME_TYPE,                 false, 0, 0,
+    consumer_biome,           create_map_slot<MAP_BIOME> },
+  { MAP_KIND_DF,  MapType::NONE,            "geology",         "write geology",         "-geology",
+    DETAILS_BIOME | DETAILS_ELEVATION, 0,                   FP_TERRAIN,                    false, 0, 0,
+    consumer_geology,         create_map_slot<MAP_GEOLOGY> },
+  { MAP_KIND_DF,  MapType::TRADING,         "trading",         "write trading",         "-trd",
+    DETAILS_TERRAIN,   0,                                   FP_TERRAIN,                    true,  0, 0,
+    consumer_trading,         create_map_slot<MAP_TRADING> },
+  { MAP_KIND_DF,  MapType::NOBILITY,        "nobility",        "write nobility",        "-nob",
+    DETAILS_TERRAIN,   0,                                   FP_TERRAIN,                    true,  0, 0,
+    consumer_nobility,        create_map_slot<MAP_NOBILITY> },
+  { MAP_KIND_DF,  MapType::DIPLOMACY,       "diplomacy",       "write diplomacy",       "-dip",
+    DETAILS_TERRAIN,   0,                                   FP_TERRAIN,                    true,  0, 0,
+    consumer_diplomacy,       create_map_slot<MAP_DIPLOMACY> },
+  { MAP_KIND_DF,  MapType::SITES,           "sites",           "write sites",           "-str",
+    DETAILS_TERRAIN,   0,                                   FP_TERRAIN,                    true,  0, 0,
+    consumer_sites,           create_map_slot<MAP_SITES> },
+
+  // Raw maps
+  { MAP_KIND_RAW, MapTypeRaw::BIOME_TYPE_RAW,      "biome_type_raw",      "write biome_type_raw",      "-biome-type",
+    DETAILS_BIOME,     FIELD_BIOME_TYPE,                    FP_BIOME_TYPE,                 false, 0,         255,
+    consumer_biome_type_raw,      create_map_slot<MAP_BIOME_TYPE_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::BIOME_REGION_RAW,    "biome_region_raw",    "write biome_region_raw",    "-biome-region",
+    DETAILS_BIOME,     FIELD_REGION_ID,                     FP_REGION,                     false, 0,         RAW_MAX_LAST_REGION,
+    consumer_biome_region_raw,    create_map_slot<MAP_BIOME_REGION_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::DRAINAGE_RAW,        "drainage_raw",        "write drainage_raw",        "-drainage",
+    DETAILS_BIOME,     FIELD_DRAINAGE,                      FP_DRAINAGE,                   false, 0,         100,
+    consumer_drainage_raw,        create_map_slot<MAP_DRAINAGE_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::ELEVATION_RAW,       "elevation_raw",       "write elevation_raw",       "-elevation",
+    DETAILS_ELEVATION, 0,                                   FP_TERRAIN,                    false, INT16_MIN, INT16_MAX,
+    consumer_elevation_raw,       create_map_slot<MAP_ELEVATION_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::ELEVATION_WATER_RAW, "elevation_water_raw", "write elevation_water_raw", "-elevation-water",
+    DETAILS_ELEVATION_WATER, 0,                             FP_TERRAIN,                    false, INT16_MIN, INT16_MAX,
+    consumer_elevation_water_raw, create_map_slot<MAP_ELEVATION_WATER_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::EVILNESS_RAW,        "evilness_raw",        "write evilness_raw",        "-evilness",
+    DETAILS_BIOME,     FIELD_EVILNESS,                      FP_EVILNESS,                   false, 0,         100,
+    consumer_evilness_raw,        create_map_slot<MAP_EVILNESS_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::HYDROSPHERE_RAW,     "hydro_raw",           "write hydro_raw",           "-hydrology",
+    DETAILS_HYDRO,     0,                                   FP_TERRAIN,                    false, 0,         INT16_MAX,
+    consumer_hydro_raw,           create_map_slot<MAP_HYDRO_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::RAINFALL_RAW,        "rainfall_raw",        "write rainfall_raw",        "-rainfall",
+    DETAILS_BIOME,     FIELD_RAINFALL,                      FP_RAINFALL,                   false, 0,         100,
+    consumer_rainfall_raw,        create_map_slot<MAP_RAINFALL_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::SALINITY_RAW,        "salinity_raw",        "write salinity_raw",        "-salinity",
+    DETAILS_BIOME,     FIELD_SALINITY,                      FP_SALINITY,                   false, 0,         100,
+    consumer_salinity_raw,        create_map_slot<MAP_SALINITY_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::SAVAGERY_RAW,        "savagery_raw",        "write savagery_raw",        "-savagery",
+    DETAILS_BIOME,     FIELD_SAVAGERY,                      FP_SAVAGERY,                   false, 0,         100,
+    consumer_savagery_raw,        create_map_slot<MAP_SAVAGERY_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::TEMPERATURE_RAW,     "temperature_raw",     "write temperature_raw",     "-temperature",
+    DETAILS_BIOME,     FIELD_TEMPERATURE,                   FP_TEMPERATURE,                false, INT16_MIN, INT16_MAX,
+    consumer_temperature_raw,     create_map_slot<MAP_TEMPERATURE_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::VOLCANISM_RAW,       "volcanism_raw",       "write volcanism_raw",       "-volcanism",
+    DETAILS_BIOME,     FIELD_VOLCANISM,                     FP_VOLCANISM,                  false, 0,         100,
+    consumer_volcanism_raw,       create_map_slot<MAP_VOLCANISM_RAW> },
+  { MAP_KIND_RAW, MapTypeRaw::VEGETATION_RAW,      "vegetation_raw",      "write vegetation_raw",      "-vegetation",
+    DETAILS_BIOME,     FIELD_VEGETATION | FIELD_BIOME_TYPE, FP_VEGETATION | FP_BIOME_TYPE, false, 0,         100,
+    consumer_vegetation_raw,      create_map_slot<MAP_VEGETATION_RAW> },
+
+  // Heightmaps
+  { MAP_KIND_HM,  MapTypeHeightMap::ELEVATION_HM,       "elevation_hm",       "write elevation_hm",       "-elevation-heightmap",
+    DETAILS_ELEVATION, 0,                               FP_TERRAIN,                    false, 0, 0,
+    consumer_elevation_heightmap,       create_map_slot<MAP_ELEVATION_HM> },
+  { MAP_KIND_HM,  MapTypeHeightMap::ELEVATION_WATER_HM, "elevation_water_hm", "write elevation_water_hm", "-elevation-water-heightmap",
+    DETAILS_ELEVATION_WATER, 0,                         FP_TERRAIN,                    false, 0, 0,
+    consumer_elevation_water_heightmap, create_map_slot<MAP_ELEVATION_WATER_HM> }
+};
+
+/*****************************************************************************
+ Module functions
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Return how a map is requested, named, fed and generated
+//----------------------------------------------------------------------------//
+const MapInfo& exportmaps_plugin::map_info(MapId id // map to describe
+                                           )
+{
+  return map_registry[id];
+}
+
+//----------------------------------------------------------------------------//
+// Defined here, where the producer class is complete
+//----------------------------------------------------------------------------//
+MapSlot::MapSlot()
+  : percentage(0)
+{
+}
+
+MapSlot::~MapSlot()
+{
+}
@@ -19,24 +19,18 @@
 // You can always find the latest version of this plugin in Github
 // https://github.com/ragundo/exportmaps
 
+#include <algorithm>
 #include <list>
-#include <modules/World.h>
+#include <sstream>
+#include <iomanip>
 #include "../include/MapsExporter.h"
 #include "../include/RegionDetails.h"
 #include "../include/ExportedMap.h"
-#include <df/world.h>
-#include <df/world_data.h>
+#include "../include/Producer.h"
+#include "../include/Tracer.h"
 
 
 using namespace exportmaps_plugin;
-using namespace DFHack;
-
-
-/*****************************************************************************
-    External functions declaration
-*****************************************************************************/
-extern int  fill_world_region_details(int world_pos_x, int world_pos_y);
-extern void delete_world_region_details_vector();
 
 
 /*****************************************************************************
@@ -47,8 +41,8 @@ extern void delete_world_region_details_vector();
 /*****************************************************************************
     Main method.
     This is the method that manages all the process.
-    It visits all the world coordinates generating the region_details needed
-    to get from DF the data needed for each different map.
+    It visits all the world coordinates getting the region details needed
+    for each different map from the world data (DF or a snapshot).
     That data is put in one queue for each map type to be generated (producer)
     When the world has been visited completely, it puts a special marker in each
     queue to signal the consumers (threads) that there's no data left and that
@@ -62,98 +56,84 @@ bool MapsExporter::generate_maps(Logger& logger)
        )
         return false;   // There's nothing to generate
 
-    // Used for displaying percentages in the DFHack console for
-    // these maps
-    this->set_percentage_diplomacy(0);
-    this->set_percentage_nobility(0);
-    this->set_percentage_sites(0);
-    this->set_percentage_trade(0);
+    // Record the time spent in each stage if asked to
+    if (!export_options.trace_file.empty())
+    {
+        Tracer::start();
+        Tracer::set_thread_name("producer");
+    }
+    int64_t start_time = Tracer::now();
+
+    // With -incremental, draw over the files of the previous export
+    // and only sweep the world tiles that changed
+    bool only_changed_tiles = this->load_previous_maps(logger);
 
     logger.log_line("Starting threads");
 
     // start the threads, one for each map to generate
     this->setup_threads();
 
-    // Store the world coordinates of the current region, as the region_details are already generated
-    std::set<int> current_region_x_coords;
-    std::set<int> current_region_y_coords;
-
-    for (unsigned int u = 0; u < df::global::world->world_data->region_details.size(); ++u)
-    {
-        current_region_x_coords.insert(df::global::world->world_data->region_details[u]->pos.x);
-        current_region_y_coords.insert(df::global::world->world_data->region_details[u]->pos.y);
-    }
-
     // No error
     bool exit_by_error = false;
 
-    // Iterate over the whole world
-    for (int y = 0; y < df::global::world->world_data->world_height; ++y)
+    // Region details of the current world coordinate
+    SnapshotRegionDetails rd;
+
+    // Progress shown in the console
+    uint64_t total_tiles    = only_changed_tiles ? changed_tile_count :
+                                                   (uint64_t)map_window.width * map_window.height;
+    uint64_t tiles_produced = 0;
+    int64_t  last_progress  = start_time;
+
+    // World tiles that don't need their region details, only when all the
+    // maps take each pixel from the region map
+    uint32_t uniform_fields = this->uniform_tile_fields();
+    uint64_t uniform_tiles  = 0;
+
+    // Iterate over the part of the world covered by the maps
+    for (int y = map_window.y; (y < map_window.y + map_window.height) && !exit_by_error; ++y)
     {
-        for (int x = 0; x < df::global::world->world_data->world_width; ++x)
+        for (int x = map_window.x; x < map_window.x + map_window.width; ++x)
         {
-            logger.log("Processing world coordinates:["); logger.log_number(x, 3); logger.log(","); logger.log_number(y, 3);
-            logger.log("]"); logger.log_cr();
-
-            df::world_region_details* ptr_rd;
-            bool delete_region = true; // New generated region must be deleted after processing it
+            if (only_changed_tiles && !changed_tiles[(size_t)y * m_world_data->world_width() + x])
+                continue;
+
+            // Get the region details of this world coordinate, generating them
+            // if needed. If they can't be got finish as there were problems.
+            // They aren't needed when the maps would fill the tile with a
+            // single value anyway
+            bool got_region_details = true;
+            if ((uniform_fields != 0) && this->is_uniform_tile(x, y, uniform_fields))
+            {
+                this->uniform_region_details(x, y, rd);
+                uniform_tiles++;
+            }
+            else
+            {
+                TraceSpan trace_span("region_details");
+                got_region_details = m_world_data->region_details(x, y, rd);
+            }
 
-            // Check if this world coordinate is one from the currente embark
-            if (current_region_x_coords.count(x))
+            if (!got_region_details)
             {
-                if (current_region_y_coords.count(y))
-                {
-                    for (unsigned int k = 0;
-                            k < df::global::world->world_data->region_details.size();
-                            ++k
-                        )
-                        if (df::global::world->world_data->region_details[k]->pos.x == x)
-                            if (df::global::world->world_data->region_details[k]->pos.y == y)
-                            {
-                                // For the current embark, the region_details are already present
-                                // in world.world_data.region_details vector, so there's no need
-                                // to generate nor destroy them
-                                ptr_rd = df::global::world->world_data->region_details[k];
-                                delete_region = false;
-                                break;
-                            }
-                }
+                exit_by_error = true;
+                break;
             }
 
-            if (delete_region) // for on-demand generated ones
+            // With a memory budget, don't let the queues grow past their limit
+            if (max_queued_tiles != 0)
+                this->wait_for_queues(tiles_produced);
+
+            // Push the data into the different queues
+            this->push_data(rd, x, y);
+            tiles_produced++;
+
+            // Update the status line a few times per second
+            int64_t now = Tracer::now();
+            if (now - last_progress >= PROGRESS_INTERVAL)
             {
-                // size before inserting the new element
-                int previous = df::global::world->world_data->region_details.size();
-
-                // generate a new region details a push in the vector
-                fill_world_region_details(x, y);
-
-                // Check the new size of the vector
-                int new_size = df::global::world->world_data->region_details.size();
-
-                // The new size must be the original + 1. If not there was an error
-                if ((new_size == 0) || (new_size == previous))
-                {
-                    delete_region = false; // don't delete anything
-                    exit_by_error = true;  // finish the plugin execution as there were problems
-                }
-                else // Everything ok. Use the new generated region details
-                    ptr_rd = df::global::world->world_data->region_details[new_size - 1];
-
-                // Push the data into the different queues
-                if (!exit_by_error)
-                    this->push_data(ptr_rd, x, y);
-
-                // Remove the generated region details
-                if (delete_region)
-                {
-                    // delete_world_region_details(ptr_rd);
-                    delete ptr_rd;
-
-                    // Remove also the entry in the vector
-                    df::global::world->world_data->region_details.erase(df::global::world->world_data->region_details.begin() +
-                                                                        df::global::world->world_data->region_details.size() - 1);
-                }
+                this->display_progress(logger, tiles_produced, total_tiles, start_time);
+                last_progress = now;
             }
         }
     }
@@ -164,31 +144,57 @@ bool MapsExporter::generate_maps(Logger& logger)
     {
         logger.log_endl();
         logger.log_line("World map visited");
+
+        if (uniform_tiles != 0)
+        {
+            std::ostringstream message;
+            message << "Uniform world tiles: " << uniform_tiles << " /" << total_tiles
+                    << " without region details";
+            logger.log_line(message.str());
+        }
     }
 
     // Signal no more data to the threads
     this->push_end();
 
-    // Trading, diplomacy, nobility and specially sites map can be slow to generate
-    // so show a progress counter to inform the user
-    this->display_progress_special_maps(&logger);
-
-
-    // Wait for the consumers to finish
+    // Wait for the consumers to finish, showing their progress. Trading,
+    // diplomacy, nobility and specially sites map can be slow to generate
+    // after the last world tile
     logger.log_line("Waiting for threads to finish");
-    this->wait_for_threads();
+    {
+        TraceSpan trace_span("wait_for_threads");
+        this->wait_for_consumers(logger, tiles_produced, total_tiles, start_time);
+        this->wait_for_threads();
+    }
+
+    // Show how each map performed, to know which ones are slowing the export
+    this->display_metrics_summary(logger);
 
     // Write the generated maps to disk
     if (!exit_by_error)
     {
         logger.log_line("Writing maps to disk: ");
         this->write_maps_to_disk(logger);
+
+        // Remember the files written for the next incremental export
+        if (incremental)
+            this->record_map_files();
     }
 
     // Free resources
     logger.log_line("Clean up resources");
     this->cleanup();
 
+    // Write the spans recorded during the whole process
+    if (Tracer::is_enabled())
+    {
+        Tracer::record("generate_maps", start_time, Tracer::now());
+
+        logger.log_line("Writing trace file");
+        if (!Tracer::write(export_options.trace_file))
+            logger.log_line("ERROR writing the trace file");
+    }
+
     if (!exit_by_error)
     {
         logger.log_line("Done.");
@@ -196,400 +202,219 @@ bool MapsExporter::generate_maps(Logger& logger)
     else
         logger.log_line("ERROR generating maps");
 
+    logger.flush();
+
     return !exit_by_error;
 }
 
 //----------------------------------------------------------------------------//
-// Methods to return the different maps from its smart pointer
+// Return a map from its smart pointer, nullptr if it isn't being generated
 //----------------------------------------------------------------------------//
-ExportedMapBase* MapsExporter::get_temperature_map()
-{
-    return temperature_map.get();
-}
-
-ExportedMapBase* MapsExporter::get_rainfall_map()
-{
-    return rainfall_map.get();
-}
-
-ExportedMapBase* MapsExporter::get_region_map()
+ExportedMapBase* MapsExporter::get_exported_map(MapId id // map to return
+                                                )
 {
-    return region_map.get();
+    return slots[id].map.get();
 }
 
-ExportedMapBase* MapsExporter::get_drainage_map()
-{
-    return drainage_map.get();
-}
-
-ExportedMapBase* MapsExporter::get_savagery_map()
-{
-    return savagery_map.get();
-}
-
-ExportedMapBase* MapsExporter::get_volcanism_map()
-{
-    return volcanism_map.get();
-}
-
-ExportedMapBase* MapsExporter::get_vegetation_map()
-{
-    return vegetation_map.get();
-}
-
-ExportedMapBase* MapsExporter::get_evilness_map()
-{
-    return evilness_map.get();
-}
-
-ExportedMapBase* MapsExporter::get_salinity_map()
-{
-    return salinity_map.get();
-}
-
-ExportedMapBase* MapsExporter::get_hydro_map()
-{
-    return hydro_map.get();
-}
-
-ExportedMapBase* MapsExporter::get_elevation_map()
-{
-    return elevation_map.get();
-}
-
-ExportedMapBase* MapsExporter::get_elevation_water_map()
-{
-    return elevation_water_map.get();
-}
-
-ExportedMapBase* MapsExporter::get_biome_map()
-{
-    return biome_map.get();
-}
-
-ExportedMapDF* MapsExporter::get_geology_map()
-{
-    return geology_map.get();
-}
-
-ExportedMapDF* MapsExporter::get_trading_map()
-{
-    return trading_map.get();
-}
-
-ExportedMapDF* MapsExporter::get_nobility_map()
+//----------------------------------------------------------------------------//
+// Live metrics of the consumer of a map
+//----------------------------------------------------------------------------//
+MapMetrics& MapsExporter::get_metrics(MapId id // map whose consumer is measured
+                                      )
 {
-    return nobility_map.get();
+    return slots[id].metrics;
 }
 
-ExportedMapDF* MapsExporter::get_diplomacy_map()
+//----------------------------------------------------------------------------//
+// Update the percentage of an overlay drawn after the last world tile
+//----------------------------------------------------------------------------//
+void MapsExporter::set_percentage(MapId id,      // map drawing the overlay
+                                  int percentage // of the overlay already drawn
+                                  )
 {
-    return diplomacy_map.get();
+    slots[id].percentage = percentage;
 }
 
-ExportedMapDF* MapsExporter::get_sites_map()
-{
-    return sites_map.get();
-}
+//----------------------------------------------------------------------------//
+// Clean the resources used
+//----------------------------------------------------------------------------//
 
-ExportedMapBase* MapsExporter::get_biome_type_raw_map()
+void MapsExporter::cleanup()
 {
-    return biome_type_raw_map.get();
-}
+    // Empty data queues if not already done
+    for (size_t i = 0; i < active_maps.size(); ++i)
+        slots[active_maps[i]].queue->clear();
 
-ExportedMapBase* MapsExporter::get_biome_region_raw_map()
-{
-    return biome_region_raw_map.get();
-}
+    // The metrics are set up again when the threads are started
+    active_metrics.clear();
 
-ExportedMapBase* MapsExporter::get_drainage_raw_map()
-{
-    return drainage_raw_map.get();
-}
+    // Destroy the generated maps
+    for (size_t i = 0; i < active_maps.size(); ++i)
+        slots[active_maps[i]].map.reset();
 
-ExportedMapBase* MapsExporter::get_elevation_raw_map()
-{
-    return elevation_raw_map.get();
-}
+    // The container must be destroyed after the raw maps that use it
+    raw_container.reset();
 
-ExportedMapBase* MapsExporter::get_elevation_water_raw_map()
-{
-    return elevation_water_raw_map.get();
+    // Destroy the generated producers and their queues
+    for (size_t i = 0; i < active_maps.size(); ++i)
+    {
+        slots[active_maps[i]].producer.reset();
+        slots[active_maps[i]].queue.reset();
+    }
+    active_maps.clear();
 }
 
-ExportedMapBase* MapsExporter::get_evilness_raw_map()
+//----------------------------------------------------------------------------//
+// Format a number of seconds as h:mm:ss
+//----------------------------------------------------------------------------//
+static std::string format_duration(double seconds)
 {
-    return evilness_raw_map.get();
-}
+    long long total = (long long)(seconds + 0.5);
 
-ExportedMapBase* MapsExporter::get_hydro_raw_map()
-{
-    return hydro_raw_map.get();
+    std::ostringstream result;
+    result << total / 3600 << ":"
+           << std::setw(2) << std::setfill('0') << (total / 60) % 60 << ":"
+           << std::setw(2) << std::setfill('0') << total % 60;
+    return result.str();
 }
 
-ExportedMapBase* MapsExporter::get_rainfall_raw_map()
-{
-    return rainfall_raw_map.get();
-}
+//----------------------------------------------------------------------------//
+// Display a single status line in the console with the progress of the
+// slowest map: world tiles processed, tiles per second and time left.
+// The maps with an overlay (sites, trading, nobility and diplomacy) show
+// its percentage once all their tiles are done
+//----------------------------------------------------------------------------//
+void MapsExporter::display_progress(Logger& logger,         // Where to write the status
+                                    uint64_t tiles_produced, // World tiles pushed into the queues
+                                    uint64_t total_tiles,    // World tiles of the whole world
+                                    int64_t start_time       // Tracer::now() when the export began
+                                    )
+{
+    double elapsed = (Tracer::now() - start_time) / 1e9;
+
+    // The slowest map is the one that decides when the export finishes
+    const MapMetrics* slowest       = nullptr;
+    uint64_t          slowest_tiles = tiles_produced;
+    for (size_t i = 0; i < active_metrics.size(); ++i)
+    {
+        uint64_t tiles = active_metrics[i]->tiles.load(std::memory_order_relaxed);
+        if ((slowest == nullptr) || (tiles < slowest_tiles))
+        {
+            slowest       = active_metrics[i];
+            slowest_tiles = tiles;
+        }
+    }
 
-ExportedMapBase* MapsExporter::get_salinity_raw_map()
-{
-    return salinity_raw_map.get();
-}
+    double rate = (elapsed > 0) ? slowest_tiles / elapsed : 0;
 
-ExportedMapBase* MapsExporter::get_savagery_raw_map()
-{
-    return savagery_raw_map.get();
-}
+    std::ostringstream status;
+    status << "Tiles " << slowest_tiles << "/" << total_tiles
+           << " - " << (uint64_t)rate << " tiles/s";
 
-ExportedMapBase* MapsExporter::get_temperature_raw_map()
-{
-    return temperature_raw_map.get();
-}
+    if (slowest != nullptr)
+        status << " - slowest: " << slowest->name << " (" << tiles_produced - slowest_tiles << " queued)";
 
-ExportedMapBase* MapsExporter::get_volcanism_raw_map()
-{
-    return volcanism_raw_map.get();
-}
+    if ((rate > 0) && (slowest_tiles < total_tiles))
+        status << " - ETA " << format_duration((total_tiles - slowest_tiles) / rate);
 
-ExportedMapBase* MapsExporter::get_vegetation_raw_map()
-{
-    return vegetation_raw_map.get();
-}
+    // Overlays drawn after the last world tile
+    for (size_t i = 0; i < active_maps.size(); ++i)
+    {
+        const MapSlot& slot = slots[active_maps[i]];
+        if (map_info(active_maps[i]).overlay && (slot.metrics.tiles == total_tiles) && !slot.metrics.finished)
+            status << " - " << slot.metrics.name << " " << std::max(0, (int)slot.percentage) << "%";
+    }
 
-ExportedMapBase* MapsExporter::get_elevation_hm_map()
-{
-    return elevation_hm_map.get();
-}
+    // Blank the rest of a previous longer line
+    status << "          ";
 
-ExportedMapBase* MapsExporter::get_elevation_water_hm_map()
-{
-    return elevation_water_hm_map.get();
+    logger.log(status.str());
+    logger.log_cr();
 }
 
 //----------------------------------------------------------------------------//
-// Methods to update the percentage
+// Keep the status line updated until every consumer has processed the end
+// marker
 //----------------------------------------------------------------------------//
-void MapsExporter::set_percentage_sites(int percentage)
+void MapsExporter::wait_for_consumers(Logger& logger,         // Where to write the status
+                                      uint64_t tiles_produced, // World tiles pushed into the queues
+                                      uint64_t total_tiles,    // World tiles of the whole world
+                                      int64_t start_time       // Tracer::now() when the export began
+                                      )
 {
-    this->percentage_sites = percentage;
-}
+    while (true)
+    {
+        bool finished = true;
+        for (size_t i = 0; i < active_metrics.size(); ++i)
+            finished = finished && active_metrics[i]->finished;
 
-void MapsExporter::set_percentage_trade(int percentage)
-{
-    this->percentage_trade = percentage;
-}
+        this->display_progress(logger, tiles_produced, total_tiles, start_time);
 
-void MapsExporter::set_percentage_nobility(int percentage)
-{
-    this->percentage_nobility = percentage;
-}
+        if (finished)
+            break;
 
-void MapsExporter::set_percentage_diplomacy(int percentage)
-{
-    this->percentage_diplomacy = percentage;
+        tthread::this_thread::sleep_for(tthread::chrono::milliseconds(PROGRESS_INTERVAL / 1000000));
+    }
+    logger.log_endl();
 }
 
 //----------------------------------------------------------------------------//
-// Clean the resources used
+// Wait until no consumer is max_queued_tiles or more tiles behind the producer
 //----------------------------------------------------------------------------//
-
-void MapsExporter::cleanup()
+void MapsExporter::wait_for_queues(uint64_t tiles_produced // World tiles pushed into the queues
+                                   )
 {
-    // Empty data queues if not already done
-    while (!temperature_queue.empty())         temperature_queue.pop();
-    while (!rainfall_queue.empty())            rainfall_queue.pop();
-    while (!region_queue.empty())              region_queue.pop();
-    while (!drainage_queue.empty())            drainage_queue.pop();
-    while (!savagery_queue.empty())            savagery_queue.pop();
-    while (!volcanism_queue.empty())           volcanism_queue.pop();
-    while (!vegetation_queue.empty())          vegetation_queue.pop();
-    while (!evilness_queue.empty())            evilness_queue.pop();
-    while (!salinity_queue.empty())            salinity_queue.pop();
-    while (!hydro_queue.empty())               hydro_queue.pop();
-    while (!elevation_queue.empty())           elevation_queue.pop();
-    while (!elevation_water_queue.empty())     elevation_water_queue.pop();
-    while (!biome_queue.empty())               biome_queue.pop();
-    while (!geology_queue.empty())             geology_queue.pop();
-    while (!trading_queue.empty())             trading_queue.pop();
-    while (!nobility_queue.empty())            nobility_queue.pop();
-    while (!diplomacy_queue.empty())           diplomacy_queue.pop();
-    while (!sites_queue.empty())               sites_queue.pop();
-
-    while (!biome_raw_type_queue.empty())      biome_raw_type_queue.pop();
-    while (!biome_raw_region_queue.empty())    biome_raw_region_queue.pop();
-    while (!drainage_raw_queue.empty())        drainage_raw_queue.pop();
-    while (!elevation_raw_queue.empty())       elevation_raw_queue.pop();
-    while (!elevation_water_raw_queue.empty()) elevation_water_raw_queue.pop();
-    while (!evilness_raw_queue.empty())        evilness_raw_queue.pop();
-    while (!hydro_raw_queue.empty())           hydro_raw_queue.pop();
-    while (!rainfall_raw_queue.empty())        rainfall_raw_queue.pop();
-    while (!salinity_raw_queue.empty())        salinity_raw_queue.pop();
-    while (!savagery_raw_queue.empty())        savagery_raw_queue.pop();
-    while (!temperature_raw_queue.empty())     temperature_raw_queue.pop();
-    while (!volcanism_raw_queue.empty())       volcanism_raw_queue.pop();
-    while (!vegetation_raw_queue.empty())      vegetation_raw_queue.pop();
-
-    while (!elevation_hm_queue.empty())        elevation_hm_queue.pop();
-    while (!elevation_water_hm_queue.empty())  elevation_water_hm_queue.pop();
+    while (true)
+    {
+        uint64_t slowest_tiles = tiles_produced;
+        for (size_t i = 0; i < active_metrics.size(); ++i)
+            slowest_tiles = std::min(slowest_tiles, (uint64_t)active_metrics[i]->tiles);
 
+        if (tiles_produced - slowest_tiles < max_queued_tiles)
+            return;
 
-    // Destroy the generated maps
-    biome_map.reset();
-    diplomacy_map.reset();
-    drainage_map.reset();
-    elevation_map.reset();
-    elevation_water_map.reset();
-    evilness_map.reset();
-    geology_map.reset();
-    hydro_map.reset();
-    nobility_map.reset();
-    rainfall_map.reset();
-    region_map.reset();
-    salinity_map.reset();
-    savagery_map.reset();
-    sites_map.reset();
-    temperature_map.reset();
-    trading_map.reset();
-    vegetation_map.reset();
-    volcanism_map.reset();
-
-    biome_type_raw_map.reset();
-    biome_region_raw_map.reset();
-    drainage_raw_map.reset();
-    elevation_raw_map.reset();
-    elevation_water_raw_map.reset();
-    evilness_raw_map.reset();
-    hydro_raw_map.reset();
-    rainfall_raw_map.reset();
-    salinity_raw_map.reset();
-    savagery_raw_map.reset();
-    temperature_raw_map.reset();
-    vegetation_raw_map.reset();
-    volcanism_raw_map.reset();
-
-    elevation_hm_map.reset();
-    elevation_water_hm_map.reset();
-
-    // Destroy the generated producers
-    biome_producer.reset();
-    diplomacy_producer.reset();
-    drainage_producer.reset();
-    elevation_producer.reset();
-    elevation_water_producer.reset();
-    evilness_producer.reset();
-    geology_producer.reset();
-    hydro_producer.reset();
-    nobility_producer.reset();
-    rainfall_producer.reset();
-    region_producer.reset();
-    salinity_producer.reset();
-    savagery_producer.reset();
-    sites_producer.reset();
-    temperature_producer.reset();
-    trading_producer.reset();
-    vegetation_producer.reset();
-    volcanism_producer.reset();
-
-    biome_type_raw_producer.reset();
-    biome_region_raw_producer.reset();
-    drainage_raw_producer.reset();
-    elevation_raw_producer.reset();
-    elevation_water_raw_producer.reset();
-    evilness_raw_producer.reset();
-    hydro_raw_producer.reset();
-    rainfall_raw_producer.reset();
-    salinity_raw_producer.reset();
-    savagery_raw_producer.reset();
-    temperature_raw_producer.reset();
-    vegetation_raw_producer.reset();
-    volcanism_raw_producer.reset();
-
-    elevation_hm_producer.reset();
-    elevation_water_hm_producer.reset();
+        tthread::this_thread::yield();
+    }
 }
 
 //----------------------------------------------------------------------------//
-// Display a progress counter in the console for the slowest maps to generate:
-// nobility, diplomacy, trading and specially sites map
+// Display a table with the metrics of each map, slowest first.
+// Busy is the time spent processing tiles and drawing overlays, wait the
+// time spent waiting for the producer
 //----------------------------------------------------------------------------//
-void MapsExporter::display_progress_special_maps(Logger* logger)
-{
-    return;
-    
-    if ((maps_to_generate & MapType::TRADING) ||
-            (maps_to_generate & MapType::NOBILITY) ||
-            (maps_to_generate & MapType::DIPLOMACY) ||
-            (maps_to_generate & MapType::SITES)
-       )
+void MapsExporter::display_metrics_summary(Logger& logger)
+{
+    std::vector<MapMetrics*> sorted(active_metrics.begin(), active_metrics.end());
+    std::sort(sorted.begin(),
+              sorted.end(),
+              [](const MapMetrics* a, const MapMetrics* b) { return a->busy_time > b->busy_time; }
+              );
+
+    std::ostringstream header;
+    header << std::left  << std::setw(22) << "Map"
+           << std::right << std::setw(10) << "Tiles"
+           << std::setw(12) << "Tiles/s"
+           << std::setw(10) << "Busy s"
+           << std::setw(10) << "Wait s"
+           << std::setw(11) << "Queue max";
+    logger.log_line(header.str());
+
+    for (size_t i = 0; i < sorted.size(); ++i)
     {
-        while (((this->percentage_trade     != -1) && (maps_to_generate & MapType::TRADING))   ||
-                ((this->percentage_sites     != -1) && (maps_to_generate & MapType::SITES))     ||
-                ((this->percentage_diplomacy != -1) && (maps_to_generate & MapType::DIPLOMACY)) ||
-                ((this->percentage_nobility  != -1) && (maps_to_generate & MapType::NOBILITY))
-              )
-        {
-            if (maps_to_generate & MapType::TRADING)
-            {
-                if (this->percentage_trade == -1)
-                {
-                    logger->log("Trading map:100% - ");
-                }
-                else
-                {
-                    logger->log("Trading map:");
-                    logger->log_number(this->percentage_trade, 3);
-                    logger->log("% - ");
-                }
-            }
-
-            if (maps_to_generate & MapType::NOBILITY)
-            {
-                if (this->percentage_nobility == -1)
-                {
-                    logger->log("Nobility map:100% - ");
-                }
-                else
-                {
-                    logger->log("Nobility map:");
-                    logger->log_number(this->percentage_nobility, 3);
-                    logger->log("% - ");
-                }
-            }
-
-            if (maps_to_generate & MapType::SITES)
-            {
-                if (this->percentage_sites == -1)
-                {
-                    logger->log("Sites map:100% - ");
-                }
-                else
-                {
-                    logger->log("Sites map:");
-                    logger->log_number(this->percentage_sites, 3);
-                    logger->log("% - ");
-                }
-            }
-
-            if (maps_to_generate & MapType::DIPLOMACY)
-            {
-                if (this->percentage_diplomacy == -1)
-                {
-                    logger->log("Diplomacy map:100% - ");
-                }
-                else
-                {
-                    logger->log("Diplomacy map:");
-                    logger->log_number(this->percentage_diplomacy, 3);
-                    logger->log("% - ");
-                }
-            }
-
-            logger->log_cr();
-        }
-        logger->log_endl();
+        const MapMetrics* metrics = sorted[i];
+        double busy = metrics->busy_time / 1e9;
+        double wait = metrics->wait_time / 1e9;
+
+        std::ostringstream row;
+        row << std::fixed << std::setprecision(2)
+            << std::left  << std::setw(22) << metrics->name
+            << std::right << std::setw(10) << metrics->tiles
+            << std::setw(12) << ((busy > 0) ? metrics->tiles / busy : 0.0)
+            << std::setw(10) << busy
+            << std::setw(10) << wait
+            << std::setw(11) << metrics->queue_high_water;
+        logger.log_line(row.str());
     }
-
 }
 
 void MapsExporter::set_logger(Logger* logger)
@@ -600,4 +425,13 @@ void MapsExporter::set_logger(Logger* logger)
 Logger* MapsExporter::get_logger()
 {
     return m_logger;
-}
\ No newline at end of file
+}
+void MapsExporter::set_world_data(WorldData* world_data)
+{
+    m_world_data = world_data;
+}
+
+WorldData* MapsExporter::get_world_data()
+{
+    return m_world_data;
+}
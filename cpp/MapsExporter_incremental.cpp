@@ -0,0 +1,276 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+#include <stdio.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include "../include/MapsExporter.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ Local functions
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Return the bits of the maps of a kind
+//----------------------------------------------------------------------------//
+static uint32_t& kind_bits(MapKind kind,       // kind of map
+                           uint32_t& maps,     // graphical maps
+                           uint32_t& maps_raw, // raw maps
+                           uint32_t& maps_hm   // heightmaps
+                           )
+{
+  if (kind == MAP_KIND_RAW) return maps_raw;
+  if (kind == MAP_KIND_HM)  return maps_hm;
+  return maps;
+}
+
+//----------------------------------------------------------------------------//
+// Return true if a file exists and can be read
+//----------------------------------------------------------------------------//
+static bool file_exists(const std::string& filename)
+{
+  std::ifstream infile(filename, std::ios::in | std::ios::binary);
+  return infile.good();
+}
+
+/*****************************************************************************
+ Class methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Name of the fingerprints file of the current world, next to the maps
+//----------------------------------------------------------------------------//
+std::string MapsExporter::fingerprints_file_name()
+{
+  return m_world_data->world_folder() + "-exportmaps.fingerprints";
+}
+
+//----------------------------------------------------------------------------//
+// Compare the world with the fingerprints saved by the previous export.
+// The maps whose fields didn't change in any world tile are removed from the
+// requested ones, as their previous file is still valid. The rest are drawn
+// over their previous file, only in the world tiles where something they read
+// changed, or generated whole if there's no previous file.
+// Returns false if the export can't be incremental
+//----------------------------------------------------------------------------//
+bool MapsExporter::plan_incremental(uint32_t& maps,               // Graphical maps to generate
+                                    uint32_t& maps_raw,           // Raw maps to generate
+                                    uint32_t& maps_hm,            // Height maps to generate
+                                    const ExportOptions& options, // How to export the maps
+                                    Logger& logger                // Progress output
+                                    )
+{
+  incremental = false;
+  patch_maps = patch_maps_raw = patch_maps_hm = 0;
+  changed_tiles.clear();
+  changed_tile_count = 0;
+
+  // The previous files must be plain files of the whole world
+  if (options.tiles || options.raw_container || options.rect)
+  {
+    logger.log_line("WARNING: -incremental can't be used with -tiles, -raw-container or -rect, exporting everything");
+    return false;
+  }
+
+  map_window = window_from_options(options);
+  int    width       = m_world_data->world_width();
+  int    height      = m_world_data->world_height();
+  size_t world_tiles = (size_t)width * height;
+
+  fingerprints.compute(*m_world_data);
+
+  bool has_previous = previous_fingerprints.load(fingerprints_file_name()) &&
+                      previous_fingerprints.same_size(fingerprints);
+
+  incremental = true;
+  changed_tiles.assign(world_tiles, 1);
+  changed_tile_count = world_tiles;
+
+  if (!has_previous)
+  {
+    logger.log_line("Incremental: no fingerprints of a previous export, exporting everything");
+    return true;
+  }
+
+  // Fields that changed in each world tile, spread to its neighbors as
+  // their pixels can read it
+  std::vector<uint32_t> changed_fields(world_tiles, 0);
+  for (int field = 0; field < TileFingerprints::FIELD_COUNT; ++field)
+    for (int y = 0; y < height; ++y)
+      for (int x = 0; x < width; ++x)
+        if (fingerprints.hash((TileFingerprints::Field)field, x, y) !=
+            previous_fingerprints.hash((TileFingerprints::Field)field, x, y))
+        {
+          for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ++ny)
+            for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); ++nx)
+              changed_fields[(size_t)ny * width + nx] |= 1u << field;
+        }
+
+  uint32_t any_changed = 0;
+  for (size_t i = 0; i < world_tiles; ++i)
+    any_changed |= changed_fields[i];
+
+  bool overlays_changed = (fingerprints.overlays() != previous_fingerprints.overlays());
+
+  // Decide what to do with each requested map
+  uint32_t update_fields = 0;     // Fields read by the maps to patch
+  bool     whole_world   = false; // A map must be generated whole
+  uint32_t unchanged     = 0;
+  uint32_t to_generate   = 0;
+
+  // The pixels of a world tile are taken from the tile itself or its 8
+  // neighbors. The overlay maps draw sites and routes across many tiles, so
+  // they can't be patched and are generated again whole if anything they
+  // read changed
+  for (int id = 0; id < MAP_COUNT; ++id)
+  {
+    const MapInfo&            info      = map_info((MapId)id);
+    TileFingerprints::MapKind kind      = (TileFingerprints::MapKind)info.kind;
+    uint32_t&                 requested = kind_bits(info.kind, maps, maps_raw, maps_hm);
+    if (!(requested & info.bit))
+      continue;
+
+    const std::string* previous_file = previous_fingerprints.file(kind, info.bit);
+    bool has_file = (previous_file != nullptr) && file_exists(*previous_file);
+
+    // The file of the previous export is still valid
+    if (has_file && !(any_changed & info.fingerprint_fields) && !(info.overlay && overlays_changed))
+    {
+      fingerprints.set_file(kind, info.bit, *previous_file);
+      requested &= ~info.bit;
+      unchanged++;
+      continue;
+    }
+
+    to_generate++;
+    if (!has_file || info.overlay)
+    {
+      whole_world = true;
+      continue;
+    }
+
+    kind_bits(info.kind, patch_maps, patch_maps_raw, patch_maps_hm) |= info.bit;
+    update_fields |= info.fingerprint_fields;
+
+    // The raw file is truncated when the new one is created with the same
+    // name, so keep the previous one apart until it's read
+    if ((info.kind == MAP_KIND_RAW) &&
+        (previous_file->compare(0, file_name_prefix().size() + 1, file_name_prefix() + "-") == 0))
+    {
+      std::string apart = *previous_file + ".previous";
+      if (rename(previous_file->c_str(), apart.c_str()) == 0)
+        previous_fingerprints.set_file(kind, info.bit, apart);
+    }
+  }
+
+  // Nothing left to generate (the maps without a consumer don't count)
+  if (to_generate == 0)
+    maps = maps_raw = maps_hm = 0;
+
+  // Only patch the maps when not every world tile has to be swept anyway
+  if (!whole_world)
+  {
+    changed_tile_count = 0;
+    for (size_t i = 0; i < world_tiles; ++i)
+    {
+      changed_tiles[i]    = (changed_fields[i] & update_fields) != 0;
+      changed_tile_count += changed_tiles[i];
+    }
+  }
+
+  std::ostringstream message;
+  message << "Incremental: " << unchanged << " maps unchanged, "
+          << changed_tile_count << " /" << world_tiles << " world tiles changed";
+  logger.log_line(message.str());
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Load the previous file of each map to patch. Returns true if only the
+// changed world tiles have to be generated, false if the whole world must be
+// swept because a map is generated whole or a file couldn't be read
+//----------------------------------------------------------------------------//
+bool MapsExporter::load_previous_maps(Logger& logger)
+{
+  if (!incremental || (changed_tile_count == changed_tiles.size()))
+    return false;
+
+  bool loaded = true;
+  for (size_t i = 0; i < active_maps.size(); ++i)
+  {
+    const MapInfo& info = map_info(active_maps[i]);
+
+    // A map generated whole in this wave needs every world tile
+    if (!(kind_bits(info.kind, patch_maps, patch_maps_raw, patch_maps_hm) & info.bit))
+      loaded = false;
+
+    const std::string* previous_file = previous_fingerprints.file((TileFingerprints::MapKind)info.kind, info.bit);
+    if (previous_file == nullptr)
+      continue;
+
+    ExportedMapBase* map = get_exported_map(active_maps[i]);
+    if (!map->load_previous(*previous_file))
+    {
+      logger.log_line("WARNING: can't read " + *previous_file + ", generating the whole world");
+      loaded = false;
+    }
+
+    // The previous raw file kept apart is not needed anymore
+    if (previous_file->size() > 9 &&
+        previous_file->compare(previous_file->size() - 9, 9, ".previous") == 0)
+      remove(previous_file->c_str());
+  }
+  return loaded;
+}
+
+//----------------------------------------------------------------------------//
+// Remember the files written for the maps of this wave
+//----------------------------------------------------------------------------//
+void MapsExporter::record_map_files()
+{
+  for (size_t i = 0; i < active_maps.size(); ++i)
+  {
+    const MapInfo& info = map_info(active_maps[i]);
+    fingerprints.set_file((TileFingerprints::MapKind)info.kind,
+                          info.bit,
+                          get_exported_map(active_maps[i])->get_filename()
+                          );
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Save the fingerprints of the world and the files of each map for the
+// next incremental export
+//----------------------------------------------------------------------------//
+void MapsExporter::save_fingerprints(Logger& logger)
+{
+  if (!incremental)
+    return;
+
+  if (!fingerprints.save(fingerprints_file_name()))
+    logger.log_line("ERROR writing " + fingerprints_file_name());
+
+  incremental = false;
+  changed_tiles.clear();
+}
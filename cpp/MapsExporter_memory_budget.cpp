@@ -0,0 +1,273 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+#include "../include/BufferPool.h"
+#include "../include/MapsExporter.h"
+#include "../include/RegionDetails.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ Local types
+*****************************************************************************/
+
+// Estimated memory used by one map, or by all the raw maps when they are
+// stored in the container, as they can't be split between files
+struct MapFootprint
+{
+  uint32_t maps;      // Graphical maps bits
+  uint32_t maps_raw;  // Raw maps bits
+  uint32_t maps_hm;   // Heightmaps bits
+  uint64_t resident;  // Bytes used while the world is swept
+  uint64_t write;     // Extra bytes used while the map is written to disk
+};
+
+// Maps that will be generated in the same sweep of the world
+struct MapWave
+{
+  uint32_t maps;
+  uint32_t maps_raw;
+  uint32_t maps_hm;
+  uint64_t resident;  // Sum of the resident bytes of its maps
+  uint64_t write;     // Maximum of the write bytes of its maps, as they're written one by one
+
+  uint64_t peak() const
+  {
+    return resident + write;
+  }
+};
+
+// Frees at the end of an export the pooled buffers of the sizes it didn't
+// use, whatever way the export returns
+struct BufferPoolExport
+{
+  BufferPoolExport()  { BufferPool::start_export(); }
+  ~BufferPoolExport() { BufferPool::evict_unused(); }
+};
+
+/*****************************************************************************
+ Local functions
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Estimate the memory used by each requested map.
+// Graphical maps keep a RGBA image and lodepng needs about as much again to
+// encode it. With -tiles the image becomes the deepest level of the pyramid,
+// and the levels above it add a third of its size.
+// Heightmaps keep 16 bit samples. Raw maps are mapped files, so they only
+// use address space, 2 bytes per sample at most.
+// Each map also has a queue, limited to MAX_QUEUED_TILES records
+//----------------------------------------------------------------------------//
+static std::vector<MapFootprint> estimate_footprints(uint32_t maps,
+                                                     uint32_t maps_raw,
+                                                     uint32_t maps_hm,
+                                                     const ExportOptions& options,
+                                                     uint64_t world_width,
+                                                     uint64_t world_height,
+                                                     uint64_t max_queued_tiles
+                                                     )
+{
+  uint64_t pixels = world_width * 16 * world_height * 16;
+  uint64_t queue  = max_queued_tiles * sizeof(TileDetails);
+
+  std::vector<MapFootprint> footprints;
+
+  // Graphical maps
+  for (int bit = 0; bit <= 16; ++bit)
+    if (maps & (1u << bit))
+    {
+      MapFootprint footprint = { 1u << bit, 0, 0, 4 * pixels + queue, 4 * pixels };
+      if (options.tiles)
+        footprint.write = 4 * pixels / 3;
+      footprints.push_back(footprint);
+    }
+
+  // Raw maps, together if they share the container
+  MapFootprint container = { 0, 0, 0, 0, 0 };
+  for (int bit = 0; bit <= 12; ++bit)
+    if (maps_raw & (1u << bit))
+    {
+      MapFootprint footprint = { 0, 1u << bit, 0, 2 * pixels + queue, 0 };
+      if (options.raw_container)
+      {
+        container.maps_raw |= footprint.maps_raw;
+        container.resident += footprint.resident;
+      }
+      else
+        footprints.push_back(footprint);
+    }
+  if (container.maps_raw != 0)
+    footprints.push_back(container);
+
+  // Heightmaps
+  for (int bit = 0; bit <= 1; ++bit)
+    if (maps_hm & (1u << bit))
+    {
+      MapFootprint footprint = { 0, 0, 1u << bit, 2 * pixels + queue, 2 * pixels };
+      footprints.push_back(footprint);
+    }
+
+  return footprints;
+}
+
+//----------------------------------------------------------------------------//
+// Split the maps into waves whose peak memory fits in the budget, biggest
+// maps first, putting each one in the first wave where it fits so the world
+// is swept as few times as possible. A map bigger than the budget gets a
+// wave of its own
+//----------------------------------------------------------------------------//
+static std::vector<MapWave> plan_waves(std::vector<MapFootprint> footprints,
+                                       uint64_t budget
+                                       )
+{
+  std::sort(footprints.begin(),
+            footprints.end(),
+            [](const MapFootprint& a, const MapFootprint& b) { return a.resident + a.write > b.resident + b.write; }
+            );
+
+  std::vector<MapWave> waves;
+  for (size_t i = 0; i < footprints.size(); ++i)
+  {
+    const MapFootprint& footprint = footprints[i];
+
+    size_t w = 0;
+    for (; w < waves.size(); ++w)
+      if (waves[w].resident + footprint.resident + std::max(waves[w].write, footprint.write) <= budget)
+        break;
+
+    if (w == waves.size())
+    {
+      MapWave wave = { 0, 0, 0, 0, 0 };
+      waves.push_back(wave);
+    }
+
+    waves[w].maps     |= footprint.maps;
+    waves[w].maps_raw |= footprint.maps_raw;
+    waves[w].maps_hm  |= footprint.maps_hm;
+    waves[w].resident += footprint.resident;
+    waves[w].write     = std::max(waves[w].write, footprint.write);
+  }
+  return waves;
+}
+
+//----------------------------------------------------------------------------//
+// The buffers kept from previous exports or waves count against the budget
+// too, so only keep what the next wave leaves free
+//----------------------------------------------------------------------------//
+static void trim_buffer_pool(uint64_t budget, // memory budget in bytes
+                             uint64_t peak    // peak memory of the next wave
+                             )
+{
+  BufferPool::trim(peak < budget ? budget - peak : 0);
+}
+
+/*****************************************************************************
+ Class methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Generate the requested maps and write them to disk.
+// Without a memory budget all the maps are generated in a single sweep of
+// the world. With -mem-budget they're split in waves, each one a sweep of
+// the world generating the maps that fit in the budget together, sharing
+// the region details of each world tile. With -preview the maps are rendered
+// from the region map only, at one pixel per world tile. With -incremental
+// only the maps and world tiles that changed since the previous export are
+// generated
+//----------------------------------------------------------------------------//
+bool MapsExporter::export_maps(uint32_t maps,                // Graphical maps to generate
+                               uint32_t maps_raw,            // Raw maps to generate
+                               uint32_t maps_hm,             // Height maps to generate
+                               const ExportOptions& options, // How to export the maps
+                               Logger& logger                // Progress output
+                               )
+{
+  BufferPoolExport pool_export;
+
+  // A preview doesn't sweep the region details at all
+  if (options.preview)
+  {
+    map_window = window_from_options(options);
+    return generate_preview(maps, maps_raw, maps_hm, logger);
+  }
+
+  // Skip the maps that didn't change since the previous export
+  incremental = false;
+  if (options.incremental && plan_incremental(maps, maps_raw, maps_hm, options, logger) &&
+      ((maps | maps_raw | maps_hm) == 0))
+  {
+    logger.log_line("All the maps are up to date");
+    save_fingerprints(logger);
+    return true;
+  }
+
+  MapWindow window = window_from_options(options);
+
+  uint64_t budget = (uint64_t)options.mem_budget_mb << 20;
+
+  std::vector<MapWave> waves;
+  if (budget != 0)
+    waves = plan_waves(estimate_footprints(maps,
+                                           maps_raw,
+                                           maps_hm,
+                                           options,
+                                           window.width,
+                                           window.height,
+                                           MAX_QUEUED_TILES
+                                           ),
+                       budget
+                       );
+
+  // A single sweep of the world
+  if (waves.size() <= 1)
+  {
+    if (!waves.empty())
+      trim_buffer_pool(budget, waves[0].peak());
+
+    setup_maps(maps, maps_raw, maps_hm, options);
+    bool ok = generate_maps(logger);
+    if (ok)
+      save_fingerprints(logger);
+    return ok;
+  }
+
+  bool ok = true;
+  for (size_t w = 0; (w < waves.size()) && ok; ++w)
+  {
+    std::ostringstream message;
+    message << "Memory budget: wave " << w + 1 << " /" << waves.size()
+            << ", about " << (waves[w].peak() >> 20) << " MB";
+    if (waves[w].peak() > budget)
+      message << " (WARNING: a single map doesn't fit in " << options.mem_budget_mb << " MB)";
+    logger.log_line(message.str());
+
+    trim_buffer_pool(budget, waves[w].peak());
+    setup_maps(waves[w].maps, waves[w].maps_raw, waves[w].maps_hm, options);
+    ok = generate_maps(logger);
+  }
+
+  if (ok)
+    save_fingerprints(logger);
+  return ok;
+}
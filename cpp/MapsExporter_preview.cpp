@@ -0,0 +1,356 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <fstream>
+#include <sstream>
+#include <string.h>
+#include <vector>
+#include "../include/MapsExporter.h"
+#include "../include/RegionDetails.h"
+#include "../include/util/lodepng.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ External functions
+ The same functions used by the consumers compute the value of each pixel
+*****************************************************************************/
+extern RGB_color RGB_from_biome_type(int biome_type);
+extern RGB_color RGB_from_drainage(int drainage);
+extern RGB_color RGB_from_elevation(int elevation);
+extern RGB_color RGB_from_evilness(int evilness);
+extern RGB_color RGB_from_rainfall(int rainfall);
+extern RGB_color RGB_from_region_type(int region_type);
+extern RGB_color RGB_from_salinity(int salinity);
+extern RGB_color RGB_from_savagery(int savagery);
+extern RGB_color RGB_from_temperature(int temperature);
+extern RGB_color RGB_from_vegetation(int vegetation, int biome_type);
+extern RGB_color RGB_from_volcanism(int volcanism);
+
+// Elevation respecting water map
+extern RGB_color RGB_from_elevation_water(const WaterElevation& water);
+
+// Hydrosphere map
+extern RGB_color RGB_from_watercourse(const Watercourse& watercourse);
+
+extern int elevation_water(const WaterElevation& water);
+
+extern int vegetation_value(int vegetation,
+                            int biome_type
+                            );
+
+extern void write_little_endian(std::ostream& outs,
+                                unsigned int value
+                                );
+
+/*****************************************************************************
+ Local types
+*****************************************************************************/
+
+// A map rendered at one pixel per world tile
+struct PreviewMap
+{
+  uint32_t                   bit;      // Map type bit
+  MapKind                    kind;     // Graphical, raw or heightmap
+  std::string                suffix;   // File name suffix, as in the full size map
+  std::vector<unsigned char> image;    // RGBA pixels, int16 samples or 16 bit grey pixels
+};
+
+/*****************************************************************************
+ Local functions
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Region details for the preview of a world tile: the whole tile belongs
+// to itself and has its world elevation. If a river crosses the tile, a
+// river segment is placed in the embark tile 0,0, the only one sampled
+//----------------------------------------------------------------------------//
+static void preview_region_details(WorldData* world_data,      // world to preview
+                                   int x,                      // world coordinate x
+                                   int y,                      // world coordinate y
+                                   SnapshotRegionDetails& rd   // destination
+                                   )
+{
+  const SnapshotRegionMapEntry& rme = world_data->region_map(x, y);
+
+  rd.pos_x = x;
+  rd.pos_y = y;
+
+  for (int i = 0; i < 17; ++i)
+    for (int j = 0; j < 17; ++j)
+    {
+      rd.elevation[i][j] = rme.elevation;
+      rd.biome[i][j]     = 5; // Center
+    }
+
+  for (int i = 0; i < 16; ++i)
+    for (int j = 0; j < 17; ++j)
+    {
+      rd.rivers_vertical_x_min[i][j]       = -30000;
+      rd.rivers_vertical_elevation[i][j]   = -30000;
+      rd.rivers_horizontal_y_min[j][i]     = -30000;
+      rd.rivers_horizontal_elevation[j][i] = -30000;
+    }
+
+  if (world_data->river_flow(x, y) != -1)
+  {
+    rd.rivers_horizontal_y_min[0][0]     = 0;
+    rd.rivers_horizontal_elevation[0][0] = rme.elevation;
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Color of a world tile in a graphical map
+//----------------------------------------------------------------------------//
+static RGB_color preview_color(uint32_t type,                      // graphical map type
+                               WorldData* world_data,              // world to preview
+                               int x,                              // world coordinate x
+                               int y,                              // world coordinate y
+                               RegionDetailsElevationWater& rdew   // region details of the world tile
+                               )
+{
+  const SnapshotRegionMapEntry& rme = world_data->region_map(x, y);
+
+  switch (type)
+  {
+    case MapType::TEMPERATURE:     return RGB_from_temperature(rme.temperature);
+    case MapType::RAINFALL:        return RGB_from_rainfall(rme.rainfall);
+    case MapType::DRAINAGE:        return RGB_from_drainage(rme.drainage);
+    case MapType::SAVAGERY:        return RGB_from_savagery(rme.savagery);
+    case MapType::VOLCANISM:       return RGB_from_volcanism(rme.volcanism);
+    case MapType::VEGETATION:      return RGB_from_vegetation(rme.vegetation, rme.biome_type);
+    case MapType::EVILNESS:        return RGB_from_evilness(rme.evilness);
+    case MapType::SALINITY:        return RGB_from_salinity(rme.salinity);
+    case MapType::ELEVATION:       return RGB_from_elevation(rme.elevation);
+    case MapType::BIOME:           return RGB_from_biome_type(rme.biome_type);
+
+    case MapType::HYDROSPHERE:     return RGB_from_watercourse(rdew.watercourse(0,
+                                                                                0,
+                                                                                rme.biome_type,
+                                                                                rme,
+                                                                                world_data->river_flow(x, y)
+                                                                                ));
+    case MapType::ELEVATION_WATER:
+    {
+      const SnapshotRegion* region = world_data->region(rme.region_id);
+      if (region == nullptr) break;
+      return RGB_from_elevation_water(rdew.water_elevation(0, 0, rme.biome_type, region));
+    }
+    case MapType::REGION:
+    {
+      const SnapshotRegion* region = world_data->region(rme.region_id);
+      if (region == nullptr) break;
+      return RGB_from_region_type(region->type);
+    }
+  }
+  return RGB_color(0,0,0);
+}
+
+//----------------------------------------------------------------------------//
+// Value of a world tile in a raw map
+//----------------------------------------------------------------------------//
+static int preview_value(uint32_t type,                      // raw map type
+                         WorldData* world_data,              // world to preview
+                         int x,                              // world coordinate x
+                         int y,                              // world coordinate y
+                         RegionDetailsElevationWater& rdew   // region details of the world tile
+                         )
+{
+  const SnapshotRegionMapEntry& rme = world_data->region_map(x, y);
+
+  switch (type)
+  {
+    case MapTypeRaw::TEMPERATURE_RAW:     return rme.temperature;
+    case MapTypeRaw::RAINFALL_RAW:        return rme.rainfall;
+    case MapTypeRaw::DRAINAGE_RAW:        return rme.drainage;
+    case MapTypeRaw::SAVAGERY_RAW:        return rme.savagery;
+    case MapTypeRaw::VOLCANISM_RAW:       return rme.volcanism;
+    case MapTypeRaw::VEGETATION_RAW:      return vegetation_value(rme.vegetation, rme.biome_type);
+    case MapTypeRaw::EVILNESS_RAW:        return rme.evilness;
+    case MapTypeRaw::SALINITY_RAW:        return rme.salinity;
+    case MapTypeRaw::ELEVATION_RAW:       return rme.elevation;
+    case MapTypeRaw::BIOME_TYPE_RAW:      return rme.biome_type;
+    case MapTypeRaw::BIOME_REGION_RAW:    return rme.region_id;
+    case MapTypeRaw::HYDROSPHERE_RAW:     return rdew.watercourse(0,
+                                                              0,
+                                                              rme.biome_type,
+                                                              rme,
+                                                              world_data->river_flow(x, y)
+                                                              ).value;
+    case MapTypeRaw::ELEVATION_WATER_RAW:
+    {
+      const SnapshotRegion* region = world_data->region(rme.region_id);
+      if (region == nullptr) break;
+      return elevation_water(rdew.water_elevation(0, 0, rme.biome_type, region));
+    }
+  }
+  return 0;
+}
+
+//----------------------------------------------------------------------------//
+// Height of a world tile in a heightmap, scaled to 0..65535
+//----------------------------------------------------------------------------//
+static int preview_height(uint32_t type,                      // heightmap type
+                          WorldData* world_data,              // world to preview
+                          int x,                              // world coordinate x
+                          int y,                              // world coordinate y
+                          RegionDetailsElevationWater& rdew   // region details of the world tile
+                          )
+{
+  const SnapshotRegionMapEntry& rme = world_data->region_map(x, y);
+  int max_world_elevation = world_data->max_elevation();
+  int elevation = rme.elevation;
+
+  if (type == MapTypeHeightMap::ELEVATION_WATER_HM)
+  {
+    const SnapshotRegion* region = world_data->region(rme.region_id);
+    if (region == nullptr) return 0;
+    elevation = elevation_water(rdew.water_elevation(0, 0, rme.biome_type, region));
+  }
+
+  int value = (max_world_elevation > 0) ? (elevation * 65535) / max_world_elevation : 0;
+  if (value < 0)     value = 0;
+  if (value > 65535) value = 65535;
+  return value;
+}
+
+//----------------------------------------------------------------------------//
+// Write a raw preview with the same format as a full size raw map
+//----------------------------------------------------------------------------//
+static bool write_raw_preview(const std::string& file_name,
+                              int width,
+                              int height,
+                              const std::vector<unsigned char>& samples
+                              )
+{
+  std::ofstream outfile(file_name, std::ios::out | std::ios::binary);
+  write_little_endian(outfile, width);
+  write_little_endian(outfile, height);
+  outfile.write((const char*)&samples[0], samples.size());
+  return outfile.good();
+}
+
+/*****************************************************************************
+ Class methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Render the maps at one pixel per world tile, straight from the region map.
+// No region details are generated and no threads are started, so a preview
+// of all the maps takes a fraction of a second. Embark level detail (river
+// courses, biome borders inside a world tile) is lost.
+// The sites, trading, nobility and diplomacy maps are not previewed.
+//----------------------------------------------------------------------------//
+bool MapsExporter::generate_preview(uint32_t maps,                // Graphical maps to generate
+                                    uint32_t maps_raw,            // Raw maps to generate
+                                    uint32_t maps_hm,             // Height maps to generate
+                                    Logger& logger                // Progress output
+                                    )
+{
+  int64_t start_time = Tracer::now();
+
+  int width  = map_window.width;
+  int height = map_window.height;
+  size_t tiles = (size_t)width * height;
+
+  if ((maps & DF_ONLY_MAPS) || (maps_raw & DF_ONLY_MAPS_RAW))
+    logger.log_line("Preview: the sites, trading, nobility and diplomacy maps are skipped");
+
+  // Maps to preview
+  std::vector<PreviewMap> previews;
+
+  // The overlays need the whole world and aren't previewed
+  uint32_t requested[3] = { maps, maps_raw, maps_hm };
+  for (int id = 0; id < MAP_COUNT; ++id)
+  {
+    const MapInfo& info = map_info((MapId)id);
+    if (info.overlay || !(requested[info.kind] & info.bit))
+      continue;
+
+    size_t     pixel_size = (info.kind == MAP_KIND_DF) ? 4 : 2;
+    PreviewMap preview    = { info.bit, info.kind, info.suffix, std::vector<unsigned char>(tiles * pixel_size) };
+    previews.push_back(preview);
+  }
+
+  // A single pass over the world fills all the maps
+  SnapshotRegionDetails rd;
+  for (int y = map_window.y; y < map_window.y + height; ++y)
+    for (int x = map_window.x; x < map_window.x + width; ++x)
+    {
+      preview_region_details(m_world_data, x, y, rd);
+      RegionDetailsElevationWater rdew(rd);
+
+      size_t index = (size_t)(y - map_window.y) * width + (x - map_window.x);
+
+      for (size_t i = 0; i < previews.size(); ++i)
+      {
+        PreviewMap& preview = previews[i];
+
+        if (preview.kind == MAP_KIND_DF)
+        {
+          RGB_color rgb = preview_color(preview.bit, m_world_data, x, y, rdew);
+          preview.image[4*index + 0] = std::get<0>(rgb);
+          preview.image[4*index + 1] = std::get<1>(rgb);
+          preview.image[4*index + 2] = std::get<2>(rgb);
+          preview.image[4*index + 3] = 255;  // Solid color
+        }
+        else if (preview.kind == MAP_KIND_RAW)
+        {
+          // Little endian int16, as in the full size raw maps
+          int value = preview_value(preview.bit, m_world_data, x, y, rdew);
+          preview.image[2*index + 0] = (unsigned char)(value & 0xFF);
+          preview.image[2*index + 1] = (unsigned char)((value >> 8) & 0xFF);
+        }
+        else
+        {
+          // PNG stores 16 bit samples in big endian format
+          int value = preview_height(preview.bit, m_world_data, x, y, rdew);
+          preview.image[2*index + 0] = (unsigned char)(value >> 8);
+          preview.image[2*index + 1] = (unsigned char)(value & 0xFF);
+        }
+      }
+    }
+
+  // Same names as the full size maps, with a "-preview" suffix
+  std::string base_name = file_name_prefix();
+
+  bool ok = true;
+  for (size_t i = 0; i < previews.size(); ++i)
+  {
+    PreviewMap& preview = previews[i];
+    std::string file_name = base_name + preview.suffix + "-preview";
+
+    if (preview.kind == MAP_KIND_DF)
+      ok &= lodepng::encode(file_name + ".png", preview.image, width, height) == 0;
+    else if (preview.kind == MAP_KIND_RAW)
+      ok &= write_raw_preview(file_name + ".raw", width, height, preview.image);
+    else
+      ok &= lodepng::encode(file_name + ".png", preview.image, width, height, LCT_GREY, 16) == 0;
+  }
+
+  std::ostringstream message;
+  message << "Preview: " << previews.size() << " maps in "
+          << (Tracer::now() - start_time) / 1000000 << " ms";
+  logger.log_line(message.str());
+  logger.flush();
+
+  return ok;
+}
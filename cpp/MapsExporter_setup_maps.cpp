@@ -19,16 +19,15 @@
 // You can always find the latest version of this plugin in Github
 // https://github.com/ragundo/exportmaps
 
+#include <algorithm>
 #include <iomanip>
+#include <sstream>
 #include <set>
-#include <modules/World.h>
 #include "../include/MapsExporter.h"
 #include "../include/RegionDetails.h"
 #include "../include/ExportedMap.h"
-#include <df/world.h>
-#include <df/world_data.h>
+#include "../include/RawContainer.h"
 
-using namespace DFHack;
 using namespace exportmaps_plugin;
 
 
@@ -36,697 +35,207 @@ using namespace exportmaps_plugin;
 // Set up the maps to be generated according to the command line parameters
 // that we got from DFHack console
 //----------------------------------------------------------------------------//
-void MapsExporter::setup_maps(uint32_t maps,     // Graphical maps to generate
-                              uint32_t maps_raw, // Raw maps to generate
-                              uint32_t maps_hm   // Height maps to generate
+void MapsExporter::setup_maps(uint32_t maps,                // Graphical maps to generate
+                              uint32_t maps_raw,            // Raw maps to generate
+                              uint32_t maps_hm,             // Height maps to generate
+                              const ExportOptions& options  // How to export the maps
                               )
 {
   // Copy the data received from DFHack command line
   maps_to_generate = maps;
   maps_to_generate_raw = maps_raw;
   maps_to_generate_hm = maps_hm;
+  export_options = options;
 
-  // Get the date elements
-  int year  = World::ReadCurrentYear();
-  int month = World::ReadCurrentMonth() + 1;
-  int day   = World::ReadCurrentDay();
+  // Bound the queues too when the memory is limited
+  max_queued_tiles = (options.mem_budget_mb != 0) ? MAX_QUEUED_TILES : 0;
 
+  // Part of the world covered by the maps
+  map_window = window_from_options(options);
 
-  // Compose date
-  std::stringstream ss_date;
-  ss_date << "-" << std::setfill('0') << std::setw(5) << year << "-" << std::setw(2) << month << "-" << std::setw(2) << day;
-  std::string current_date = ss_date.str();
-  std::string region_name = World::ReadWorldFolder();
+  // All the files start with the world folder and the date
+  std::string file_prefix = file_name_prefix();
 
-  if (maps_to_generate & MapType::TEMPERATURE)
+  // All the raw maps can be stored as layers of a single file
+  if (maps_raw && export_options.raw_container)
   {
     // Compose filename
     std::stringstream file_name;
-    file_name << region_name << current_date << "-tmp.png";
+    file_name << file_prefix << "-raw-layers.rawc";
 
-    temperature_producer.reset(new ProducerTemperature);
-    if (!temperature_producer) throw std::bad_alloc();
-
-    temperature_map.reset(new ExportedMapDF(file_name.str(),
-                                            df::global::world->world_data->world_width,
-                                            df::global::world->world_data->world_height,
-                                            MapType::TEMPERATURE
-                                            )
-                          );
-    if (!temperature_map) throw std::bad_alloc();
-  }
-
-//----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::RAINFALL)
-  {
-    // Compose filename
-    std::stringstream file_name;
-
-    file_name << region_name << current_date << "-rain.png";
-    rainfall_producer.reset(new ProducerRainfall);
-    if (!rainfall_producer) throw std::bad_alloc();
-
-    rainfall_map.reset(new ExportedMapDF(file_name.str(),
-                                         df::global::world->world_data->world_width,
-                                         df::global::world->world_data->world_height,
-                                         MapType::RAINFALL
-                                         )
-                       );
-
-    if (!rainfall_map) throw std::bad_alloc();
-  }
-
-  //----------------------------------------------------------------------------//
-
-    if (maps_to_generate & MapType::REGION)
-    {
-      // Compose filename
-      std::stringstream file_name;
-
-      file_name << region_name << current_date << "-rgn.png";
-      region_producer.reset(new ProducerRegion);
-      if (!region_producer) throw std::bad_alloc();
-
-      region_map.reset(new ExportedMapDF(file_name.str(),
-                                         df::global::world->world_data->world_width,
-                                         df::global::world->world_data->world_height,
-                                         MapType::REGION
-                                         )
-                       );
-
-      if (!region_map) throw std::bad_alloc();
-    }
-
-//----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::DRAINAGE)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-drn.png";
-
-    drainage_producer.reset(new ProducerDrainage);
-    if (!drainage_producer) throw std::bad_alloc();
-
-    drainage_map.reset(new ExportedMapDF(file_name.str(),
-                                         df::global::world->world_data->world_width,
-                                         df::global::world->world_data->world_height,
-                                         MapType::DRAINAGE
+    raw_container.reset(new RawContainer(file_name.str(),
+                                         map_window.width,
+                                         map_window.height,
+                                         export_options.raw_container_zlib
                                          )
-                       );
-
-    if (!drainage_map) throw std::bad_alloc();
-  }
-
-//----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::SAVAGERY)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-sav.png";
-
-    savagery_producer.reset(new ProducerSavagery);
-    if (!savagery_producer) throw std::bad_alloc();
-
-    savagery_map.reset(new ExportedMapDF(file_name.str(),
-                                         df::global::world->world_data->world_width,
-                                         df::global::world->world_data->world_height,
-                                         MapType::SAVAGERY
-                                         )
-                       );
-
-    if (!savagery_map) throw std::bad_alloc();
-  }
-
-//----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::VOLCANISM)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-vol.png";
-
-    volcanism_producer.reset(new ProducerVolcanism);
-    if (!volcanism_producer) throw std::bad_alloc();
-
-    volcanism_map.reset(new ExportedMapDF(file_name.str(),
-                                          df::global::world->world_data->world_width,
-                                          df::global::world->world_data->world_height,
-                                          MapType::VOLCANISM
-                                          )
                         );
 
-    if (!volcanism_map) throw std::bad_alloc();
+    if (!raw_container) throw std::bad_alloc();
   }
 
-//----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::VEGETATION)
+  // The maps to generate, in the order of the registry. A map whose consumer
+  // isn't part of this build can't be generated
+  active_maps.clear();
+  tile_details = 0;
+  for (int id = 0; id < MAP_COUNT; ++id)
   {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-veg.png";
-    vegetation_producer.reset(new ProducerVegetation);
-    if (!vegetation_producer) throw std::bad_alloc();
-
-    vegetation_map.reset(new ExportedMapDF(file_name.str(),
-                                           df::global::world->world_data->world_width,
-                                           df::global::world->world_data->world_height,
-                                           MapType::VEGETATION
-                                           )
-                         );
-
-    if (!vegetation_map) throw std::bad_alloc();
-  }
+    const MapInfo& info = map_info((MapId)id);
+    if (!is_map_requested((MapId)id) || (info.consumer == nullptr))
+      continue;
 
-//----------------------------------------------------------------------------//
+    MapSlot& slot = slots[id];
 
-  if (maps_to_generate & MapType::EVILNESS)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-evil.png";
-
-    evilness_producer.reset(new ProducerEvilness);
-    if (!evilness_producer) throw std::bad_alloc();
-
-    evilness_map.reset(new ExportedMapDF(file_name.str(),
-                                         df::global::world->world_data->world_width,
-                                         df::global::world->world_data->world_height,
-                                         MapType::EVILNESS
-                                         )
-                       );
-
-    if (!evilness_map) throw std::bad_alloc();
-  }
-
-//----------------------------------------------------------------------------//
+    // Producer and queue of the records for the consumer
+    info.create(slot);
+    if (!slot.producer || !slot.queue) throw std::bad_alloc();
 
-  if (maps_to_generate & MapType::SALINITY)
-  {
     // Compose filename
     std::stringstream file_name;
-    file_name << region_name << current_date << "-sal.png";
-
-    salinity_producer.reset(new ProducerSalinity);
-    if (!salinity_producer) throw std::bad_alloc();
-
-    salinity_map.reset(new ExportedMapDF(file_name.str(),
-                                         df::global::world->world_data->world_width,
-                                         df::global::world->world_data->world_height,
-                                         MapType::SALINITY
-                                         )
-                       );
+    file_name << file_prefix << info.suffix;
 
-    if (!salinity_map) throw std::bad_alloc();
-  }
-
-//----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::HYDROSPHERE)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-hyd.png";
-
-    hydro_producer.reset(new ProducerHydro);
-    if (!hydro_producer) throw std::bad_alloc();
+    switch (info.kind)
+    {
+    case MAP_KIND_DF:
+      file_name << ".png";
+      slot.map.reset(new ExportedMapDF(file_name.str(),
+                                       map_window,
+                                       (MapType)info.bit
+                                       )
+                     );
+      break;
+
+    case MAP_KIND_RAW:
+      file_name << ".raw";
+      slot.map.reset(create_raw_map(file_name.str(),
+                                    info.suffix + 1, // layer name, without the '-'
+                                    (MapTypeRaw)info.bit,
+                                    info.raw_min,
+                                    (info.raw_max == RAW_MAX_LAST_REGION) ? m_world_data->num_regions() - 1 :
+                                                                            info.raw_max
+                                    )
+                     );
+      break;
+
+    case MAP_KIND_HM:
+      file_name << ".png";
+      slot.map.reset(new ExportedMapHM(file_name.str(),
+                                       map_window,
+                                       (MapTypeHeightMap)info.bit
+                                       )
+                     );
+      break;
+    }
 
-    hydro_map.reset(new ExportedMapDF(file_name.str(),
-                                      df::global::world->world_data->world_width,
-                                      df::global::world->world_data->world_height,
-                                      MapType::HYDROSPHERE
-                                      )
-                    );
+    if (!slot.map) throw std::bad_alloc();
 
-    if (!hydro_map) throw std::bad_alloc();
+    active_maps.push_back((MapId)id);
+    tile_details |= info.details;
   }
 
-//----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::ELEVATION)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-el.png";
-    elevation_producer.reset(new ProducerElevation);
-    if (!elevation_producer) throw std::bad_alloc();
-
-    elevation_map.reset(new ExportedMapDF(file_name.str(),
-                                          df::global::world->world_data->world_width,
-                                          df::global::world->world_data->world_height,
-                                          MapType::ELEVATION
-                                          )
-                        );
-
-    if (!elevation_map) throw std::bad_alloc();
-  }
+  // Now that all the layers are known, allocate the container storage
+  if (raw_container)
+    raw_container->create();
+}
 
 //----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::ELEVATION_WATER)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-elw.png";
-    elevation_water_producer.reset(new ProducerElevationWater);
-    if (!elevation_water_producer) throw std::bad_alloc();
-
-    elevation_water_map.reset(new ExportedMapDF(file_name.str(),
-                                                df::global::world->world_data->world_width,
-                                                df::global::world->world_data->world_height,
-                                                MapType::ELEVATION_WATER
-                                                )
-                              );
-
-    if (!elevation_water_map) throw std::bad_alloc();
-  }
-
+// Check if a map was requested in the command line
 //----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::BIOME)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-bm.png";
-    biome_producer.reset(new ProducerBiome);
-    if (!biome_producer) throw std::bad_alloc();
-
-    biome_map.reset(new ExportedMapDF(file_name.str(),
-                                      df::global::world->world_data->world_width,
-                                      df::global::world->world_data->world_height,
-                                      MapType::BIOME
-                                      )
-                    );
-
-    if (!biome_map) throw std::bad_alloc();
-  }
+bool MapsExporter::is_map_requested(MapId id // map to check
+                                    )
+{
+  const MapInfo& info = map_info(id);
+  return (maps_of_kind(info.kind) & info.bit) != 0;
+}
 
 //----------------------------------------------------------------------------//
-/*
-    if (maps_to_generate & MapType::GEOLOGY)
-    {
-        // Compose filename
-        std::stringstream file_name;
-        file_name << region_name << current_date << "-geology.png";
-        geology_producer.reset(new ProducerGeology);
-        if (!geology_producer) throw std::bad_alloc();
-
-        geology_map.reset(new ExportedMapDF(file_name.str(),
-                                            df::global::world->world_data->world_width,
-                                            df::global::world->world_data->world_height,
-                                            MapType::GEOLOGY));
-        if (!geology_map) throw std::bad_alloc();
-    }
-*/
-
+// Maps of one kind to generate
 //----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::TRADING)
+uint32_t MapsExporter::maps_of_kind(MapKind kind // DF, raw or heightmap
+                                    )
+{
+  switch (kind)
   {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-trd.png";
-    trading_producer.reset(new ProducerTrading);
-    if (!trading_producer) throw std::bad_alloc();
-
-    trading_map.reset(new ExportedMapDF(file_name.str(),
-                                        df::global::world->world_data->world_width,
-                                        df::global::world->world_data->world_height,
-                                        MapType::TRADING
-                                        )
-                      );
-
-    if (!trading_map) throw std::bad_alloc();
+  case MAP_KIND_DF:  return maps_to_generate;
+  case MAP_KIND_RAW: return maps_to_generate_raw;
+  case MAP_KIND_HM:  return maps_to_generate_hm;
   }
+  return 0;
+}
 
 //----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::NOBILITY)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-nob.png";
-    nobility_producer.reset(new ProducerNobility);
-    if (!nobility_producer) throw std::bad_alloc();
-
-    nobility_map.reset(new ExportedMapDF(file_name.str(),
-                                         df::global::world->world_data->world_width,
-                                         df::global::world->world_data->world_height,
-                                         MapType::NOBILITY
-                                         )
-                       );
-
-    if (!nobility_map) throw std::bad_alloc();
-  }
-
+// Create a raw map. It will be written to its own file or, if requested
+// in the command line, as a layer of the raw maps container
 //----------------------------------------------------------------------------//
+ExportedMapRaw* MapsExporter::create_raw_map(const std::string file_name,  // name of the .raw file
+                                             const std::string layer_name, // name of the layer in the container
+                                             MapTypeRaw type_raw,          // raw map type
+                                             int min_value,                // minimum value written by the consumer
+                                             int max_value                 // maximum value written by the consumer
+                                             )
+{
+  if (raw_container)
+    return new ExportedMapRaw(raw_container.get(),
+                              layer_name,
+                              map_window,
+                              type_raw,
+                              min_value,
+                              max_value
+                              );
 
-  if (maps_to_generate & MapType::DIPLOMACY)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-dip.png";
-    diplomacy_producer.reset(new ProducerDiplomacy);
-    if (!diplomacy_producer) throw std::bad_alloc();
-
-    diplomacy_map.reset(new ExportedMapDF(file_name.str(),
-                                          df::global::world->world_data->world_width,
-                                          df::global::world->world_data->world_height,
-                                          MapType::DIPLOMACY
-                                          )
-                        );
-
-    if (!diplomacy_map) throw std::bad_alloc();
-  }
+  return new ExportedMapRaw(file_name,
+                            map_window,
+                            type_raw
+                            );
+}
 
 //----------------------------------------------------------------------------//
-
-  if (maps_to_generate & MapType::SITES)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-str.png";
-    sites_producer.reset(new ProducerSites);
-    if (!sites_producer) throw std::bad_alloc();
-
-    sites_map.reset(new ExportedMapDF(file_name.str(),
-                                      df::global::world->world_data->world_width,
-                                      df::global::world->world_data->world_height,
-                                      MapType::SITES
-                                      )
-                    );
-
-    if (!sites_map) throw std::bad_alloc();
-  }
-
-  ////////////////////////////////////
-  // Raw Maps
-  ////////////////////////////////////
-
-  if (maps_raw & MapTypeRaw::BIOME_TYPE_RAW)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-biome-type.raw";
-    biome_type_raw_producer.reset(new ProducerBiomeRawType);
-    if (!biome_type_raw_producer) throw std::bad_alloc();
-
-    biome_type_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                                df::global::world->world_data->world_width,
-                                                df::global::world->world_data->world_height,
-                                                MapTypeRaw::BIOME_TYPE_RAW
-                                                )
-                             );
-
-    if (!biome_type_raw_map) throw std::bad_alloc();
-  }
-
+// Part of the world covered by the maps: the rectangle given with -rect,
+// clipped to the world, or the whole world
 //----------------------------------------------------------------------------//
+MapWindow MapsExporter::window_from_options(const ExportOptions& options // how to export the maps
+                                            )
+{
+  int world_width  = m_world_data->world_width();
+  int world_height = m_world_data->world_height();
 
-  if (maps_raw & MapTypeRaw::BIOME_REGION_RAW)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-biome-region.raw";
-    biome_region_raw_producer.reset(new ProducerBiomeRawRegion);
-    if (!biome_region_raw_producer) throw std::bad_alloc();
-
-    biome_region_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                                  df::global::world->world_data->world_width,
-                                                  df::global::world->world_data->world_height,
-                                                  MapTypeRaw::BIOME_REGION_RAW
-                                                  )
-                               );
-
-    if (!biome_region_raw_map) throw std::bad_alloc();
-  }
-
- //----------------------------------------------------------------------------//
-
-  if (maps_raw & MapTypeRaw::DRAINAGE_RAW)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-drainage.raw";
-    drainage_raw_producer.reset(new ProducerDrainageRaw);
-    if (!drainage_raw_producer) throw std::bad_alloc();
-
-    drainage_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                              df::global::world->world_data->world_width,
-                                              df::global::world->world_data->world_height,
-                                              MapTypeRaw::DRAINAGE_RAW
-                                              )
-                           );
-
-    if (!drainage_raw_map) throw std::bad_alloc();
-  }
-
-  //----------------------------------------------------------------------------//
-
-    if (maps_to_generate_raw & MapTypeRaw::ELEVATION_RAW)
-    {
-      // Compose filename
-      std::stringstream file_name;
-      file_name << region_name << current_date << "-elevation.raw";
-      elevation_raw_producer.reset(new ProducerElevationRaw);
-      if (!elevation_raw_producer) throw std::bad_alloc();
-
-      elevation_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                                 df::global::world->world_data->world_width,
-                                                 df::global::world->world_data->world_height,
-                                                 MapTypeRaw::ELEVATION_RAW
-                                                 )
-                              );
-
-      if (!elevation_raw_map) throw std::bad_alloc();
-    }
-
-  //----------------------------------------------------------------------------//
-
-  if (maps_to_generate_raw & MapTypeRaw::ELEVATION_WATER_RAW)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-elevation-water.raw";
-    elevation_water_raw_producer.reset(new ProducerElevationWaterRaw);
-    if (!elevation_water_raw_producer) throw std::bad_alloc();
-
-    elevation_water_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                                     df::global::world->world_data->world_width,
-                                                     df::global::world->world_data->world_height,
-                                                     MapTypeRaw::ELEVATION_WATER_RAW
-                                                     )
-                                  );
-
-    if (!elevation_water_raw_map) throw std::bad_alloc();
-  }
-
-  //----------------------------------------------------------------------------//
-
-  if (maps_to_generate_raw & MapTypeRaw::EVILNESS_RAW)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-evilness.raw";
-
-    evilness_raw_producer.reset(new ProducerEvilnessRaw);
-    if (!evilness_raw_producer) throw std::bad_alloc();
-    evilness_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                              df::global::world->world_data->world_width,
-                                              df::global::world->world_data->world_height,
-                                              MapTypeRaw::EVILNESS_RAW
-                                              )
-                           );
-
-    if (!evilness_raw_map) throw std::bad_alloc();
-  }
-
-  //----------------------------------------------------------------------------//
-
-  if (maps_to_generate_raw & MapTypeRaw::HYDROSPHERE_RAW)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-hydrology.raw";
-
-    hydro_raw_producer.reset(new ProducerHydroRaw);
-    if (!hydro_raw_producer) throw std::bad_alloc();
-
-    hydro_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                           df::global::world->world_data->world_width,
-                                           df::global::world->world_data->world_height,
-                                           MapTypeRaw::HYDROSPHERE_RAW
-                                           )
-                        );
-    if (!hydro_raw_map) throw std::bad_alloc();
-  }
-
-  //----------------------------------------------------------------------------//
-
-  if (maps_to_generate_raw & MapTypeRaw::RAINFALL_RAW)
-  {
-    // Compose filename
-    std::stringstream file_name;
-
-    file_name << region_name << current_date << "-rainfall.raw";
-    rainfall_raw_producer.reset(new ProducerRainfallRaw);
-    if (!rainfall_raw_producer) throw std::bad_alloc();
-
-    rainfall_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                              df::global::world->world_data->world_width,
-                                              df::global::world->world_data->world_height,
-                                              MapTypeRaw::RAINFALL_RAW
-                                              )
-                           );
-
-    if (!rainfall_raw_map) throw std::bad_alloc();
-  }
-
-  //----------------------------------------------------------------------------//
+  MapWindow window = { 0, 0, world_width, world_height };
 
-  if (maps_to_generate_raw & MapTypeRaw::SALINITY_RAW)
+  if (options.rect)
   {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-salinity.raw";
-
-    salinity_raw_producer.reset(new ProducerSalinityRaw);
-    if (!salinity_raw_producer) throw std::bad_alloc();
-
-    salinity_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                              df::global::world->world_data->world_width,
-                                              df::global::world->world_data->world_height,
-                                              MapTypeRaw::SALINITY_RAW
-                                              )
-                           );
-    if (!salinity_raw_map) throw std::bad_alloc();
-  }
-
-  //----------------------------------------------------------------------------//
+    int x0 = std::max(std::min(options.rect_x0, options.rect_x1), 0);
+    int y0 = std::max(std::min(options.rect_y0, options.rect_y1), 0);
+    int x1 = std::min(std::max(options.rect_x0, options.rect_x1), world_width  - 1);
+    int y1 = std::min(std::max(options.rect_y0, options.rect_y1), world_height - 1);
 
-    if (maps_to_generate_raw & MapTypeRaw::SAVAGERY_RAW)
+    // A rectangle out of the world gets the whole world
+    if ((x0 <= x1) && (y0 <= y1))
     {
-      // Compose filename
-      std::stringstream file_name;
-      file_name << region_name << current_date << "-savagery.raw";
-
-      savagery_raw_producer.reset(new ProducerSavageryRaw);
-      if (!savagery_raw_producer) throw std::bad_alloc();
-
-      savagery_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                                df::global::world->world_data->world_width,
-                                                df::global::world->world_data->world_height,
-                                                MapTypeRaw::SAVAGERY_RAW
-                                                )
-                             );
-
-      if (!savagery_raw_map) throw std::bad_alloc();
+      window.x      = x0;
+      window.y      = y0;
+      window.width  = x1 - x0 + 1;
+      window.height = y1 - y0 + 1;
     }
-
-  //----------------------------------------------------------------------------//
-
-  if (maps_to_generate_raw & MapTypeRaw::TEMPERATURE_RAW)
-  {
-    // Compose filename
-    std::stringstream file_name;
-    file_name << region_name << current_date << "-temperature.raw";
-
-    temperature_raw_producer.reset(new ProducerTemperatureRaw);
-    if (!temperature_raw_producer) throw std::bad_alloc();
-
-    temperature_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                            df::global::world->world_data->world_width,
-                                            df::global::world->world_data->world_height,
-                                            MapTypeRaw::TEMPERATURE_RAW));
-    if (!temperature_raw_map) throw std::bad_alloc();
   }
-
-  //----------------------------------------------------------------------------//
-
-    if (maps_to_generate_raw & MapTypeRaw::VOLCANISM_RAW)
-    {
-      // Compose filename
-      std::stringstream file_name;
-      file_name << region_name << current_date << "-volcanism.raw";
-
-      volcanism_raw_producer.reset(new ProducerVolcanismRaw);
-      if (!volcanism_raw_producer) throw std::bad_alloc();
-
-      volcanism_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                                 df::global::world->world_data->world_width,
-                                                 df::global::world->world_data->world_height,
-                                                 MapTypeRaw::VOLCANISM_RAW
-                                                 )
-                              );
-
-      if (!volcanism_raw_map) throw std::bad_alloc();
-    }
-
-  //----------------------------------------------------------------------------//
-
-    if (maps_to_generate_raw & MapTypeRaw::VEGETATION_RAW)
-    {
-      // Compose filename
-      std::stringstream file_name;
-      file_name << region_name << current_date << "-vegetation.raw";
-      vegetation_raw_producer.reset(new ProducerVegetationRaw);
-      if (!vegetation_raw_producer) throw std::bad_alloc();
-
-      vegetation_raw_map.reset(new ExportedMapRaw(file_name.str(),
-                                                  df::global::world->world_data->world_width,
-                                                  df::global::world->world_data->world_height,
-                                                  MapTypeRaw::VEGETATION_RAW
-                                                  )
-                               );
-
-      if (!vegetation_raw_map) throw std::bad_alloc();
-    }
-
-
-  //----------------------------------------------------------------------------//
-
-    if (maps_to_generate_hm & MapTypeHeightMap::ELEVATION_HM)
-    {
-      // Compose filename
-      std::stringstream file_name;
-      file_name << region_name << current_date << "-elevation-heightmap.png";
-      elevation_hm_producer.reset(new ProducerElevationHeightMap);
-      if (!elevation_hm_producer) throw std::bad_alloc();
-
-      elevation_hm_map.reset(new ExportedMapHM(file_name.str(),
-                                               df::global::world->world_data->world_width,
-                                               df::global::world->world_data->world_height,
-                                               MapTypeHeightMap::ELEVATION_HM
-                                               )
-                             );
-
-      if (!elevation_hm_map) throw std::bad_alloc();
-    }
-
-  //----------------------------------------------------------------------------//
-
-    if (maps_to_generate_hm & MapTypeHeightMap::ELEVATION_WATER_HM)
-    {
-      // Compose filename
-      std::stringstream file_name;
-      file_name << region_name << current_date << "-elevation-water-heightmap.png";
-      elevation_water_hm_producer.reset(new ProducerElevationWaterHeightMap);
-      if (!elevation_water_hm_producer) throw std::bad_alloc();
-
-      elevation_water_hm_map.reset(new ExportedMapHM(file_name.str(),
-                                                     df::global::world->world_data->world_width,
-                                                     df::global::world->world_data->world_height,
-                                                     MapTypeHeightMap::ELEVATION_WATER_HM
-                                                     )
-                                   );
-
-      if (!elevation_water_hm_map) throw std::bad_alloc();
-    }
-
-
-
+  return window;
 }
 
+//----------------------------------------------------------------------------//
+// Start of the name of all the files: world folder and date, followed by
+// the rectangle when the maps only cover a part of the world
+//----------------------------------------------------------------------------//
+std::string MapsExporter::file_name_prefix()
+{
+  std::stringstream prefix;
+  prefix << m_world_data->world_folder()
+         << "-" << std::setfill('0') << std::setw(5) << m_world_data->year()
+         << "-" << std::setw(2) << m_world_data->month()
+         << "-" << std::setw(2) << m_world_data->day();
+
+  if ((map_window.width  != m_world_data->world_width()) ||
+      (map_window.height != m_world_data->world_height()))
+    prefix << "-rect-" << map_window.x << "-" << map_window.y
+           << "-" << map_window.x + map_window.width  - 1
+           << "-" << map_window.y + map_window.height - 1;
+
+  return prefix.str();
+}
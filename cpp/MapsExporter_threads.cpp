@@ -20,7 +20,6 @@
 // https://github.com/ragundo/exportmaps
 
 #include <set>
-#include <modules/World.h>
 #include "../include/Mac_compat.h"
 #include "../include/MapsExporter.h"
 #include "../include/RegionDetails.h"
@@ -29,49 +28,6 @@
 using namespace exportmaps_plugin;
 
 
-/*****************************************************************************
- External functions declaration
- Here comes all the threads functions for the different maps.
-*****************************************************************************/
-extern void consumer_biome                     (void* arg);
-extern void consumer_diplomacy                 (void* arg);
-extern void consumer_drainage                  (void* arg);
-extern void consumer_elevation                 (void* arg);
-extern void consumer_elevation_water           (void* arg);
-extern void consumer_evilness                  (void* arg);
-extern void consumer_geology                   (void* arg);
-extern void consumer_hydro                     (void* arg);
-extern void consumer_nobility                  (void* arg);
-extern void consumer_rainfall                  (void* arg);
-extern void consumer_region                    (void* arg);
-extern void consumer_salinity                  (void* arg);
-extern void consumer_savagery                  (void* arg);
-extern void consumer_sites                     (void* arg);
-extern void consumer_temperature               (void* arg);
-extern void consumer_trading                   (void* arg);
-extern void consumer_vegetation                (void* arg);
-extern void consumer_volcanism                 (void* arg);
-
-extern void consumer_biome_type_raw            (void* arg);
-extern void consumer_biome_region_raw          (void* arg);
-extern void consumer_drainage_raw              (void* arg);
-extern void consumer_elevation_raw             (void* arg);
-extern void consumer_elevation_water_raw       (void* arg);
-extern void consumer_evilness_raw              (void* arg);
-extern void consumer_hydro_raw                 (void* arg);
-extern void consumer_rainfall_raw              (void* arg);
-extern void consumer_salinity_raw              (void* arg);
-extern void consumer_savagery_raw              (void* arg);
-extern void consumer_temperature_raw           (void* arg);
-extern void consumer_vegetation_raw            (void* arg);
-extern void consumer_volcanism_raw             (void* arg);
-
-extern void consumer_elevation_heightmap       (void* arg);
-extern void consumer_elevation_water_heightmap (void* arg);
-
-/*****************************************************************************
-*****************************************************************************/
-
 //----------------------------------------------------------------------------//
 // Return the mutex object used to synchronize the producer with the
 // different threads
@@ -87,237 +43,16 @@ tthread::mutex& MapsExporter::get_mutex()
 //----------------------------------------------------------------------------//
 void MapsExporter::setup_threads()
 {
-  if (maps_to_generate & MapType::TEMPERATURE)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_temperature,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::RAINFALL)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_rainfall,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::REGION)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_region,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::DRAINAGE)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_drainage,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::SAVAGERY)
+  for (size_t i = 0; i < active_maps.size(); ++i)
   {
-    tthread::thread* pthread =  new tthread::thread(consumer_savagery,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::VOLCANISM)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_volcanism,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::VEGETATION)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_vegetation,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::EVILNESS)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_evilness,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
+    MapSlot&       slot = slots[active_maps[i]];
+    const MapInfo& info = map_info(active_maps[i]);
 
-  if (maps_to_generate & MapType::SALINITY)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_salinity,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::HYDROSPHERE)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_hydro,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::ELEVATION)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_elevation,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::ELEVATION_WATER)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_elevation_water,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::BIOME)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_biome,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-
-/*
-    if (maps_to_generate & MapType::GEOLOGY)
-    {
-        tthread::thread* pthread =  new tthread::thread(consumer_geology,(void*)this);
-        consumer_threads.push_back(pthread);
-    }
-*/
-
-  if (maps_to_generate & MapType::TRADING)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_trading,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::NOBILITY)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_nobility,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
+    slot.metrics.reset(info.name);
+    slot.percentage = 0;
+    active_metrics.push_back(&slot.metrics);
 
-  if (maps_to_generate & MapType::DIPLOMACY)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_diplomacy,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate & MapType::SITES)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_sites,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-
-  if (maps_to_generate_raw & MapTypeRaw::BIOME_TYPE_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_biome_type_raw,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::BIOME_REGION_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_biome_region_raw,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::DRAINAGE_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_drainage_raw,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::ELEVATION_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_elevation_raw,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::ELEVATION_WATER_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_elevation_water_raw,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::EVILNESS_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_evilness_raw,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::HYDROSPHERE_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_hydro_raw,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::RAINFALL_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_rainfall_raw,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::SALINITY_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_salinity_raw,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::SAVAGERY_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_savagery_raw,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::TEMPERATURE_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_temperature_raw,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::VOLCANISM_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_volcanism_raw,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::VEGETATION_RAW)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_vegetation_raw,(void*)this);
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_hm & MapTypeHeightMap::ELEVATION_HM)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_elevation_heightmap,
-                                                    (void*)this
-                                                    );
-    consumer_threads.push_back(pthread);
-  }
-
-  if (maps_to_generate_hm & MapTypeHeightMap::ELEVATION_WATER_HM)
-  {
-    tthread::thread* pthread =  new tthread::thread(consumer_elevation_water_heightmap,
-                                                    (void*)this
-                                                    );
+    tthread::thread* pthread =  new tthread::thread(info.consumer,(void*)this);
     consumer_threads.push_back(pthread);
   }
 }
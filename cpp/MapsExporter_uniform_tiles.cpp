@@ -0,0 +1,130 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <algorithm>
+#include <string.h>
+#include "../include/MapsExporter.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ Local functions
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Return true if two region map entries have the same value in all the
+// given fields
+//----------------------------------------------------------------------------//
+static bool same_fields(const SnapshotRegionMapEntry& a,
+                        const SnapshotRegionMapEntry& b,
+                        uint32_t fields
+                        )
+{
+  if ((fields & FIELD_BIOME_TYPE)  && (a.biome_type  != b.biome_type))  return false;
+  if ((fields & FIELD_REGION_ID)   && (a.region_id   != b.region_id))   return false;
+  if ((fields & FIELD_TEMPERATURE) && (a.temperature != b.temperature)) return false;
+  if ((fields & FIELD_RAINFALL)    && (a.rainfall    != b.rainfall))    return false;
+  if ((fields & FIELD_DRAINAGE)    && (a.drainage    != b.drainage))    return false;
+  if ((fields & FIELD_SAVAGERY)    && (a.savagery    != b.savagery))    return false;
+  if ((fields & FIELD_VOLCANISM)   && (a.volcanism   != b.volcanism))   return false;
+  if ((fields & FIELD_VEGETATION)  && (a.vegetation  != b.vegetation))  return false;
+  if ((fields & FIELD_EVILNESS)    && (a.evilness    != b.evilness))    return false;
+  if ((fields & FIELD_SALINITY)    && (a.salinity    != b.salinity))    return false;
+  return true;
+}
+
+/*****************************************************************************
+ Class methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Fields of the region map that decide the pixels of all the requested maps,
+// or 0 if any requested map needs the region details of every world tile
+// (elevations, rivers, sites...)
+//----------------------------------------------------------------------------//
+uint32_t MapsExporter::uniform_tile_fields()
+{
+  uint32_t fields = 0;
+
+  // Maps of each kind whose pixels only depend on the region map
+  uint32_t uniform_maps[3] = { 0, 0, 0 };
+  for (int id = 0; id < MAP_COUNT; ++id)
+  {
+    const MapInfo& info = map_info((MapId)id);
+    if (info.region_map_fields == 0)
+      continue;
+
+    uniform_maps[info.kind] |= info.bit;
+    if (is_map_requested((MapId)id))
+      fields |= info.region_map_fields;
+  }
+
+  if ((maps_to_generate     & ~uniform_maps[MAP_KIND_DF])  ||
+      (maps_to_generate_raw & ~uniform_maps[MAP_KIND_RAW]) ||
+      (maps_to_generate_hm  & ~uniform_maps[MAP_KIND_HM]))
+    return 0;
+
+  return fields;
+}
+
+//----------------------------------------------------------------------------//
+// Each pixel of a world tile reads the region map entry of the tile itself
+// or of one of its 8 neighbors, as told by its biome index. If all of them
+// have the same fields, every pixel gets the same value whatever the region
+// details are, so they don't need to be generated
+//----------------------------------------------------------------------------//
+bool MapsExporter::is_uniform_tile(int x,         // world coordinate x
+                                   int y,         // world coordinate y
+                                   uint32_t fields // fields read by the maps
+                                   )
+{
+  int width  = m_world_data->world_width();
+  int height = m_world_data->world_height();
+
+  const SnapshotRegionMapEntry& center = m_world_data->region_map(x, y);
+
+  // The neighbors out of the world are clamped to the border, as
+  // adjust_coordinates_to_region does
+  for (int dy = -1; dy <= 1; ++dy)
+    for (int dx = -1; dx <= 1; ++dx)
+    {
+      int nx = std::min(std::max(x + dx, 0), width  - 1);
+      int ny = std::min(std::max(y + dy, 0), height - 1);
+
+      if (!same_fields(center, m_world_data->region_map(nx, ny), fields))
+        return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Region details for a uniform world tile: every pixel points to the tile
+// itself. Only the biome indexes are read by the maps that allow it
+//----------------------------------------------------------------------------//
+void MapsExporter::uniform_region_details(int x,                    // world coordinate x
+                                          int y,                    // world coordinate y
+                                          SnapshotRegionDetails& rd // destination
+                                          )
+{
+  rd.pos_x = x;
+  rd.pos_y = y;
+  memset(rd.biome, 5, sizeof(rd.biome)); // Center
+}
@@ -20,12 +20,11 @@
 // https://github.com/ragundo/exportmaps
 
 #include <set>
-#include <modules/World.h>
 #include "../include/MapsExporter.h"
 #include "../include/RegionDetails.h"
 #include "../include/ExportedMap.h"
+#include "../include/Tracer.h"
 
-using namespace DFHack;
 using namespace exportmaps_plugin;
 
 //----------------------------------------------------------------------------//
@@ -33,43 +32,9 @@ using namespace exportmaps_plugin;
 //----------------------------------------------------------------------------//
 int MapsExporter::get_num_maps_to_write_to_disk()
 {
-  int result = 0;
+  int result = (int)active_maps.size();
 
-  if (maps_to_generate & MapType::TEMPERATURE)                    result++;
-  if (maps_to_generate & MapType::RAINFALL)                       result++;
-  if (maps_to_generate & MapType::REGION)                         result++;
-  if (maps_to_generate & MapType::DRAINAGE)                       result++;
-  if (maps_to_generate & MapType::SAVAGERY)                       result++;
-  if (maps_to_generate & MapType::VOLCANISM)                      result++;
-  if (maps_to_generate & MapType::VEGETATION)                     result++;
-  if (maps_to_generate & MapType::EVILNESS)                       result++;
-  if (maps_to_generate & MapType::SALINITY)                       result++;
-  if (maps_to_generate & MapType::HYDROSPHERE)                    result++;
-  if (maps_to_generate & MapType::ELEVATION)                      result++;
-  if (maps_to_generate & MapType::ELEVATION_WATER)                result++;
-  if (maps_to_generate & MapType::BIOME)                          result++;
-  //if (maps_to_generate & MapType::GEOLOGY)                        result++;
-  if (maps_to_generate & MapType::TRADING)                        result++;
-  if (maps_to_generate & MapType::NOBILITY)                       result++;
-  if (maps_to_generate & MapType::DIPLOMACY)                      result++;
-  if (maps_to_generate & MapType::SITES)                          result++;
-//----------------------------------------------------------------------------//
-  if (maps_to_generate_raw & MapTypeRaw::BIOME_TYPE_RAW)          result++;
-  if (maps_to_generate_raw & MapTypeRaw::BIOME_REGION_RAW)        result++;
-  if (maps_to_generate_raw & MapTypeRaw::DRAINAGE_RAW)            result++;
-  if (maps_to_generate_raw & MapTypeRaw::ELEVATION_RAW)           result++;
-  if (maps_to_generate_raw & MapTypeRaw::ELEVATION_WATER_RAW)     result++;
-  if (maps_to_generate_raw & MapTypeRaw::EVILNESS_RAW)            result++;
-  if (maps_to_generate_raw & MapTypeRaw::HYDROSPHERE_RAW)         result++;
-  if (maps_to_generate_raw & MapTypeRaw::RAINFALL_RAW)            result++;
-  if (maps_to_generate_raw & MapTypeRaw::SALINITY_RAW)            result++;
-  if (maps_to_generate_raw & MapTypeRaw::SAVAGERY_RAW)            result++;
-  if (maps_to_generate_raw & MapTypeRaw::TEMPERATURE_RAW)         result++;
-  if (maps_to_generate_raw & MapTypeRaw::VOLCANISM_RAW)           result++;
-  if (maps_to_generate_raw & MapTypeRaw::VEGETATION_RAW)          result++;
-//----------------------------------------------------------------------------//
-  if (maps_to_generate_hm & MapTypeHeightMap::ELEVATION_HM)       result++;
-  if (maps_to_generate_hm & MapTypeHeightMap::ELEVATION_WATER_HM) result++;
+  if (raw_container) result++;
 
   return result;
 }
@@ -79,248 +44,55 @@ int MapsExporter::get_num_maps_to_write_to_disk()
 //----------------------------------------------------------------------------//
 void MapsExporter::write_maps_to_disk(Logger& logger)
 {
+  TraceSpan write_span("write_maps_to_disk");
+
   // Get the number of maps to write
   int num_maps = this->get_num_maps_to_write_to_disk();
 
   // Number of maps processed
   int i = 0;
 
-  if (maps_to_generate & MapType::TEMPERATURE)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    temperature_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate & MapType::RAINFALL)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    rainfall_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate & MapType::REGION)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    region_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate & MapType::DRAINAGE)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    drainage_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate & MapType::SAVAGERY)
+  // DF and raw maps, then the raw maps container, then the heightmaps
+  for (int pass = 0; pass < 2; ++pass)
   {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    savagery_map.get()->write_to_disk();
-  }
+    for (size_t m = 0; m < active_maps.size(); ++m)
+    {
+      const MapInfo& info = map_info(active_maps[m]);
+      if ((info.kind == MAP_KIND_HM) != (pass == 1))
+        continue;
 
-  if (maps_to_generate & MapType::VOLCANISM)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    volcanism_map.get()->write_to_disk();
-  }
+      logger.log("Writing maps to disk: ");
+      logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
+      TraceSpan trace_span(info.write_span);
 
-  if (maps_to_generate & MapType::VEGETATION)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    vegetation_map.get()->write_to_disk();
-  }
+      ExportedMapBase* map = slots[active_maps[m]].map.get();
+      if (info.kind == MAP_KIND_DF)
+        write_graphical_map_to_disk(map);
+      else
+        map->write_to_disk();
+    }
 
-  if (maps_to_generate & MapType::EVILNESS)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    evilness_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate & MapType::SALINITY)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    salinity_map.get()->write_to_disk();
+    // The raw maps stored in the container are written all at once
+    if ((pass == 0) && raw_container)
+    {
+      logger.log("Writing maps to disk: ");
+      logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
+      TraceSpan trace_span("write raw_container");
+      raw_container.get()->write_to_disk();
+    }
   }
 
-  if (maps_to_generate & MapType::HYDROSPHERE)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    hydro_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate & MapType::ELEVATION)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    elevation_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate & MapType::ELEVATION_WATER)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    elevation_water_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate & MapType::BIOME)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    biome_map.get()->write_to_disk();
-  }
-
-//  if (maps_to_generate & MapType::GEOLOGY)
-//  {
-//  logger.log_line("Writing maps to disk: ");
-//  logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-//    geology_map.get()->write_to_disk();
-//  }
-
-  if (maps_to_generate & MapType::TRADING)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    trading_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate & MapType::NOBILITY)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    nobility_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate & MapType::DIPLOMACY)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    diplomacy_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate & MapType::SITES)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    sites_map.get()->write_to_disk();
-  }
+  // Write new line to finish
+  logger.log_endl();
+}
 
 //----------------------------------------------------------------------------//
-
-  if (maps_to_generate_raw & MapTypeRaw::BIOME_TYPE_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    biome_type_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::BIOME_REGION_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    biome_region_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::DRAINAGE_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    drainage_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::ELEVATION_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    elevation_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::ELEVATION_WATER_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    elevation_water_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::EVILNESS_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    evilness_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::HYDROSPHERE_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    hydro_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::RAINFALL_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    rainfall_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::SALINITY_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    salinity_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::SAVAGERY_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    savagery_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::TEMPERATURE_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    temperature_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::VOLCANISM_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    volcanism_raw_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_raw & MapTypeRaw::VEGETATION_RAW)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    vegetation_raw_map.get()->write_to_disk();
-  }
-
-
+// Write a graphical map as a single PNG or as a pyramid of tiles
 //----------------------------------------------------------------------------//
-
-  if (maps_to_generate_hm & MapTypeHeightMap::ELEVATION_HM)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    elevation_hm_map.get()->write_to_disk();
-  }
-
-  if (maps_to_generate_hm & MapTypeHeightMap::ELEVATION_WATER_HM)
-  {
-    logger.log("Writing maps to disk: ");
-    logger.log_number(++i); logger.log(" /"); logger.log_number(num_maps); logger.log_cr();
-    elevation_water_hm_map.get()->write_to_disk();
-  }
-
-  // Write new line to finish
-  logger.log_endl();
+void MapsExporter::write_graphical_map_to_disk(ExportedMapBase* map)
+{
+  if (export_options.tiles)
+    map->write_tiles_to_disk(tthread::thread::hardware_concurrency());
+  else
+    map->write_to_disk();
 }
@@ -0,0 +1,342 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <string.h>
+#include <fstream>
+
+#include "../include/BufferPool.h"
+#include "../include/RawContainer.h"
+#include "../include/ExportedMap.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ File layout constants
+*****************************************************************************/
+static const char     CONTAINER_MAGIC[8]  = {'E','X','P','M','A','P','R','C'};
+static const uint32_t CONTAINER_VERSION   = 2;
+static const uint32_t CONTAINER_FLAG_ZLIB = 1u << 0;
+static const size_t   HEADER_SIZE         = 64;   // File header
+static const size_t   DESCRIPTOR_SIZE     = 64;   // Each layer descriptor
+static const size_t   INDEX_ENTRY_SIZE    = 16;   // Each compressed block index entry
+static const size_t   LAYER_ALIGNMENT     = 4096; // Layers start at page boundaries
+
+/*****************************************************************************
+ Local functions
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Round up a file offset to the layer alignment
+//----------------------------------------------------------------------------//
+static uint64_t align_offset(uint64_t offset)
+{
+  return (offset + LAYER_ALIGNMENT - 1) & ~(uint64_t)(LAYER_ALIGNMENT - 1);
+}
+
+//----------------------------------------------------------------------------//
+// Store unsigned values using little endian format (LSB first, MSB last)
+//----------------------------------------------------------------------------//
+static void put_u32(unsigned char* dest, uint32_t value)
+{
+  for (int i = 0; i < 4; ++i)
+    dest[i] = (unsigned char)(value >> (8*i));
+}
+
+static void put_u64(unsigned char* dest, uint64_t value)
+{
+  for (int i = 0; i < 8; ++i)
+    dest[i] = (unsigned char)(value >> (8*i));
+}
+
+static void put_f32(unsigned char* dest, float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  put_u32(dest, bits);
+}
+
+/*****************************************************************************
+ RawContainer methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Constructor
+//----------------------------------------------------------------------------//
+RawContainer::RawContainer(const std::string filename, // name of the container file
+                           int world_width,            // world width in world coordinates
+                           int world_height,           // world height in world coordinates
+                           bool compressed             // compress the layers with zlib
+                           )
+  : _filename(filename),
+    _width(world_width*16),
+    _height(world_height*16),
+    _compressed(compressed)
+{
+}
+
+//----------------------------------------------------------------------------//
+// Add a new layer. The storage is allocated later in create(), when all the
+// layers are known
+//----------------------------------------------------------------------------//
+void RawContainer::add_layer(ExportedMapRaw* map,    // map that writes to this layer
+                             const std::string name, // layer name
+                             MapTypeRaw type_raw,    // raw map type
+                             int min_value,          // minimum value of the layer
+                             int max_value,          // maximum value of the layer
+                             float scale,            // scale applied to each sample
+                             float offset            // offset applied to each sample
+                             )
+{
+  Layer layer;
+  layer.map          = map;
+  layer.name         = name.substr(0, 15);
+  layer.type_raw     = type_raw;
+  layer.sample_type  = sample_type_for_range(min_value, max_value);
+  layer.sample_size  = (layer.sample_type == RawSampleType::SAMPLE_UINT8) ? 1 : 2;
+  layer.scale        = scale;
+  layer.offset       = offset;
+  layer.data_offset  = 0;
+  layer.data_size    = 0;
+  layer.index_offset = 0;
+  layer.block_count  = 0;
+
+  _layers.push_back(layer);
+}
+
+//----------------------------------------------------------------------------//
+// Many raw maps have a small range of values (0..100) so they can be stored
+// using 1 byte per sample instead of 2
+//----------------------------------------------------------------------------//
+RawSampleType RawContainer::sample_type_for_range(int min_value, // minimum value
+                                                  int max_value  // maximum value
+                                                  )
+{
+  if ((min_value >= 0) && (max_value <= 255))
+    return RawSampleType::SAMPLE_UINT8;
+
+  if ((min_value >= 0) && (max_value <= 65535))
+    return RawSampleType::SAMPLE_UINT16;
+
+  return RawSampleType::SAMPLE_INT16;
+}
+
+//----------------------------------------------------------------------------//
+// Size of the header and the layer descriptors
+//----------------------------------------------------------------------------//
+size_t RawContainer::header_size()
+{
+  return HEADER_SIZE + DESCRIPTOR_SIZE * _layers.size();
+}
+
+//----------------------------------------------------------------------------//
+// Allocate the storage for every layer and attach it to its map.
+// If the container is not compressed, the file is created with its final size
+// and mapped in memory, so the maps write their samples directly to the file
+//----------------------------------------------------------------------------//
+void RawContainer::create()
+{
+  size_t layer_samples = (size_t)_width * _height;
+
+  if (!_compressed)
+  {
+    // Compute where each layer starts
+    uint64_t offset = align_offset(header_size());
+    for (unsigned int i = 0; i < _layers.size(); ++i)
+    {
+      _layers[i].data_offset = offset;
+      _layers[i].data_size   = layer_samples * _layers[i].sample_size;
+      offset = align_offset(offset + _layers[i].data_size);
+    }
+
+    if (_file.open(_filename, (size_t)offset))
+    {
+      // The header is already known, so write it now
+      write_header(_file.data());
+
+      for (unsigned int i = 0; i < _layers.size(); ++i)
+        _layers[i].map->attach_samples(_file.data() + _layers[i].data_offset,
+                                       _layers[i].sample_type
+                                       );
+      return;
+    }
+  }
+
+  // Compressed or the file can't be mapped. Keep the layers in memory
+  for (unsigned int i = 0; i < _layers.size(); ++i)
+  {
+    BufferPool::acquire(_layers[i].samples, layer_samples * _layers[i].sample_size);
+    _layers[i].map->attach_samples(&_layers[i].samples[0],
+                                   _layers[i].sample_type
+                                   );
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Write the file header and the descriptor of every layer
+//----------------------------------------------------------------------------//
+void RawContainer::write_header(unsigned char* dest)
+{
+  memset(dest, 0, header_size());
+
+  memcpy(dest, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+  put_u32(dest +  8, CONTAINER_VERSION);
+  put_u32(dest + 12, HEADER_SIZE);
+  put_u32(dest + 16, _width);
+  put_u32(dest + 20, _height);
+  put_u32(dest + 24, _layers.size());
+  put_u32(dest + 28, _compressed ? CONTAINER_FLAG_ZLIB : 0);
+  put_u32(dest + 32, BLOCK_ROWS);
+  put_u32(dest + 36, DESCRIPTOR_SIZE);
+
+  for (unsigned int i = 0; i < _layers.size(); ++i)
+  {
+    unsigned char* descriptor = dest + HEADER_SIZE + i * DESCRIPTOR_SIZE;
+    Layer& layer = _layers[i];
+
+    memcpy(descriptor, layer.name.c_str(), layer.name.size());
+    put_u32(descriptor + 16, layer.type_raw);
+    put_u32(descriptor + 20, layer.sample_type);
+    put_u32(descriptor + 24, layer.sample_size);
+    put_f32(descriptor + 28, layer.scale);
+    put_f32(descriptor + 32, layer.offset);
+    put_u32(descriptor + 36, layer.block_count);
+    put_u64(descriptor + 40, layer.data_offset);
+    put_u64(descriptor + 48, layer.data_size);
+    put_u64(descriptor + 56, layer.index_offset);
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Write the container to disk
+//----------------------------------------------------------------------------//
+int RawContainer::write_to_disk()
+{
+  if (_file.is_open())
+  {
+    // The data is already in the file. Unmap it so the OS writes it back
+    _file.close();
+    return 0;
+  }
+
+  if (_compressed)
+    return write_compressed();
+
+  return write_uncompressed();
+}
+
+//----------------------------------------------------------------------------//
+// Write the layers kept in memory without compression
+//----------------------------------------------------------------------------//
+int RawContainer::write_uncompressed()
+{
+  std::ofstream outfile(_filename, std::ios::out | std::ios::binary);
+  if (!outfile)
+    return -1;
+
+  std::vector<unsigned char> header(header_size());
+  write_header(&header[0]);
+  outfile.write((const char*)&header[0], header.size());
+
+  for (unsigned int i = 0; i < _layers.size(); ++i)
+  {
+    // Pad up to the start of the layer
+    outfile.seekp((std::streamoff)_layers[i].data_offset);
+    outfile.write((const char*)&_layers[i].samples[0], _layers[i].data_size);
+  }
+
+  outfile.close();
+  return 0;
+}
+
+//----------------------------------------------------------------------------//
+// Split each layer in blocks of BLOCK_ROWS rows, compress them with zlib and
+// write them after the block index of the layer
+//----------------------------------------------------------------------------//
+int RawContainer::write_compressed()
+{
+  uint32_t num_blocks = (_height + BLOCK_ROWS - 1) / BLOCK_ROWS;
+
+  std::ofstream outfile(_filename, std::ios::out | std::ios::binary);
+  if (!outfile)
+    return -1;
+
+  // Reserve space for the header, it's written at the end when
+  // all the offsets are known
+  std::vector<unsigned char> header(header_size());
+  outfile.write((const char*)&header[0], header.size());
+
+  uint64_t offset = align_offset(header.size());
+
+  for (unsigned int i = 0; i < _layers.size(); ++i)
+  {
+    Layer& layer = _layers[i];
+    const unsigned char* samples = &layer.samples[0];
+    size_t row_size = (size_t)_width * layer.sample_size;
+
+    layer.block_count  = num_blocks;
+    layer.index_offset = offset;
+    layer.data_offset  = offset + num_blocks * INDEX_ENTRY_SIZE;
+
+    std::vector<unsigned char> index(num_blocks * INDEX_ENTRY_SIZE);
+    uint64_t block_offset = layer.data_offset;
+
+    outfile.seekp((std::streamoff)layer.data_offset);
+
+    for (uint32_t b = 0; b < num_blocks; ++b)
+    {
+      size_t first_row = (size_t)b * BLOCK_ROWS;
+      size_t rows      = (_height - first_row < (size_t)BLOCK_ROWS) ? _height - first_row : BLOCK_ROWS;
+      size_t raw_size  = rows * row_size;
+
+      std::vector<unsigned char> block;
+      unsigned error = lodepng::compress(block, samples + first_row * row_size, raw_size);
+      if (error)
+        return error;
+
+      outfile.write((const char*)&block[0], block.size());
+
+      put_u64(&index[b * INDEX_ENTRY_SIZE + 0], block_offset);
+      put_u32(&index[b * INDEX_ENTRY_SIZE + 8], block.size());
+      put_u32(&index[b * INDEX_ENTRY_SIZE + 12], raw_size);
+
+      block_offset += block.size();
+    }
+
+    layer.data_size = block_offset - layer.data_offset;
+
+    // Now the block index of this layer is complete
+    outfile.seekp((std::streamoff)layer.index_offset);
+    outfile.write((const char*)&index[0], index.size());
+
+    offset = align_offset(block_offset);
+
+    // The samples are no longer needed
+    BufferPool::recycle(layer.samples);
+  }
+
+  // Finally write the header with all the offsets
+  write_header(&header[0]);
+  outfile.seekp(0);
+  outfile.write((const char*)&header[0], header.size());
+
+  outfile.close();
+  return 0;
+}
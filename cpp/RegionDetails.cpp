@@ -0,0 +1,307 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+
+#include <string.h>
+
+#include "../include/RegionDetails.h"
+#include "../include/WorldData.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+External functions
+*****************************************************************************/
+extern std::pair<int,int> adjust_coordinates_to_region(int x,
+                                                       int y,
+                                                       int delta,
+                                                       int pos_x,
+                                                       int pos_y,
+                                                       int world_width,
+                                                       int world_height
+                                                       );
+
+//----------------------------------------------------------------------------//
+// Copy the given fields of the region details of a world tile
+//----------------------------------------------------------------------------//
+std::shared_ptr<const TileDetails> TileDetails::extract(const SnapshotRegionDetails& rd, // region details of the tile
+                                                        uint32_t fields,                 // MapDetails to copy
+                                                        const WorldData* world_data      // needed for DETAILS_ELEVATION_WATER and DETAILS_HYDRO
+                                                        )
+{
+  // The elevation respecting water and the water courses are computed from
+  // the other fields
+  if (fields & (DETAILS_ELEVATION_WATER | DETAILS_HYDRO))
+    fields |= DETAILS_BIOME | DETAILS_ELEVATION | DETAILS_RIVERS;
+
+  // They also need the world data
+  if (world_data == nullptr)
+    fields &= ~(DETAILS_ELEVATION_WATER | DETAILS_HYDRO);
+
+  // Not make_shared, as it would clear the arrays first
+  TileDetails* tile = new TileDetails;
+  tile->pos_x   = rd.pos_x;
+  tile->pos_y   = rd.pos_y;
+  tile->details = fields;
+
+  if (fields & DETAILS_BIOME)
+    memcpy(tile->biome, rd.biome, sizeof(tile->biome));
+
+  if (fields & DETAILS_ELEVATION)
+    memcpy(tile->elevation, rd.elevation, sizeof(tile->elevation));
+
+  if (fields & DETAILS_RIVERS)
+  {
+    memcpy(tile->rivers_vertical.x_min,       rd.rivers_vertical_x_min,       sizeof(tile->rivers_vertical.x_min));
+    memcpy(tile->rivers_vertical.elevation,   rd.rivers_vertical_elevation,   sizeof(tile->rivers_vertical.elevation));
+    memcpy(tile->rivers_horizontal.y_min,     rd.rivers_horizontal_y_min,     sizeof(tile->rivers_horizontal.y_min));
+    memcpy(tile->rivers_horizontal.elevation, rd.rivers_horizontal_elevation, sizeof(tile->rivers_horizontal.elevation));
+  }
+
+  if (fields & (DETAILS_ELEVATION_WATER | DETAILS_HYDRO))
+    tile->fill_embark_tiles(*world_data);
+
+  return std::shared_ptr<const TileDetails>(tile);
+}
+
+//----------------------------------------------------------------------------//
+// Compute the elevation respecting water and the water course of the 16x16
+// embark tiles, as requested
+//----------------------------------------------------------------------------//
+void TileDetails::fill_embark_tiles(const WorldData& world_data)
+{
+  // Flow of the river that crosses this world tile, if any
+  int river_flow = world_data.river_flow(pos_x, pos_y);
+
+  for (auto x=0; x<16; ++x)
+    for (auto y=0; y<16; ++y)
+    {
+      // Each position of the array is a value that tells us if the local tile
+      // belongs to the NW,N,NE,W,center,E,SW,S,SE world region.
+      // Returns a world coordinate adjusted from the original one
+      std::pair<int,int> adjusted_tile_coordinates = adjust_coordinates_to_region(x,
+                                                                                  y,
+                                                                                  biome[x][y],
+                                                                                  pos_x,
+                                                                                  pos_y,
+                                                                                  world_data.world_width(),
+                                                                                  world_data.world_height()
+                                                                                  );
+
+      // Get the biome type for this world position
+      int biome_type = world_data.biome_type(adjusted_tile_coordinates.first,
+                                             adjusted_tile_coordinates.second
+                                             );
+
+      // Get the region where this position belongs to
+      const SnapshotRegionMapEntry& rme = world_data.region_map(adjusted_tile_coordinates.first,
+                                                                adjusted_tile_coordinates.second);
+
+      if (details & DETAILS_ELEVATION_WATER)
+        water[x][y] = water_elevation(x, y, biome_type, world_data.region(rme.region_id));
+
+      if (details & DETAILS_HYDRO)
+        hydro[x][y] = watercourse(x, y, biome_type, rme, river_flow);
+    }
+}
+
+//----------------------------------------------------------------------------//
+// Return the elevation respecting water of an embark tile
+//----------------------------------------------------------------------------//
+WaterElevation TileDetails::water_elevation(int x,                       // embark tile x
+                                            int y,                       // embark tile y
+                                            int biome_type,              // biome type of the embark tile
+                                            const SnapshotRegion* region // region the embark tile belongs to
+                                            ) const
+{
+  int elevation = this->elevation[x][y];
+  bool has_river = true;
+
+  int river_horiz_y_min              = rivers_horizontal.y_min[x  ][y];
+  int river_horiz_y_min_plus_one_row = rivers_horizontal.y_min[x+1][y];
+
+  int river_vert_x_min               = rivers_vertical.x_min[x][y  ];
+  int river_vert_x_min_plus_one_col  = rivers_vertical.x_min[x][y+1];
+
+  if ((river_horiz_y_min == -30000) && (river_horiz_y_min_plus_one_row == -30000))
+    if ((river_vert_x_min == -30000) && (river_vert_x_min_plus_one_col == -30000))
+      has_river = false;
+
+  if (has_river)
+  {
+    switch(biome_type)
+    {
+      case 1:     // GLACIER
+      case 2:     // TUNDRA
+      case 27:    // OCEAN_TROPICAL
+      case 28:    // OCEAN_TEMPERATE
+      case 29:    // OCEAN_ARCTIC
+      case 36:    // LAKE_TEMPERATE_FRESHWATER
+      case 37:    // LAKE_TEMPERATE_BRACKISH_WATER
+      case 38:    // LAKE_TEMPERATE_SALTWATER
+      case 39:    // LAKE_TROPICAL_FRESHWATER
+      case 40:    // LAKE_TROPICAL_BRACKISH_WATER
+      case 41:    // LAKE_TROPICAL_SALT_WATER
+                  if ((biome_type < 27) ||
+                      (biome_type > 29) ||
+                      (elevation  < 99))
+                      {
+                        has_river = false;
+                        break;
+                      }
+      default:    break;
+    }
+  }
+
+  if (has_river)
+  {
+    elevation = 30000;
+    if ((river_horiz_y_min != -30000) &&
+        (rivers_horizontal.elevation[x][y] < 30000)
+        )
+      elevation = rivers_horizontal.elevation[x][y];
+
+    if ((river_horiz_y_min_plus_one_row != -30000) &&
+        (rivers_horizontal.elevation[x+1][y] < elevation)
+        )
+      elevation = rivers_horizontal.elevation[x+1][y];
+
+    if ((river_vert_x_min != -30000) &&
+        (rivers_vertical.elevation[x][y] < elevation)
+        )
+      elevation = rivers_vertical.elevation[x][y];
+
+    if ((river_vert_x_min_plus_one_col != -30000) &&
+        (rivers_vertical.elevation[x][y+1] < elevation)
+        )
+      elevation = rivers_vertical.elevation[x][y+1];
+  }
+
+  WaterElevation water;
+  water.river           = has_river;
+  water.river_elevation = elevation;
+  water.region_type     = region->type;
+
+  if (region->lake_surface != -30000)
+    elevation = region->lake_surface;
+
+  water.elevation = elevation;
+  return water;
+}
+
+//----------------------------------------------------------------------------//
+// Return the water course of an embark tile without a river
+//----------------------------------------------------------------------------//
+Watercourse exportmaps_plugin::no_river_watercourse(int biome_type, // biome type of the embark tile
+                                                   int elevation   // elevation of the embark tile
+                                                   )
+{
+  Watercourse watercourse;
+  watercourse.value = 0;
+
+  if (biome_type == 0) // MOUNTAIN biome
+    watercourse.hydro_class = HYDRO_MOUNTAIN;
+
+  else if ((biome_type > 35) && (biome_type <= 41)) // LAKE biome
+    watercourse.hydro_class = HYDRO_LAKE;
+
+  else if (elevation < 99) // OCEAN biome
+    watercourse.hydro_class = HYDRO_OCEAN;
+
+  else // LAND biome
+    watercourse.hydro_class = HYDRO_LAND;
+
+  return watercourse;
+}
+
+//----------------------------------------------------------------------------//
+// Return the water course of an embark tile
+//----------------------------------------------------------------------------//
+Watercourse TileDetails::watercourse(int x,                             // embark tile x
+                                     int y,                             // embark tile y
+                                     int biome_type,                    // biome type of the embark tile
+                                     const SnapshotRegionMapEntry& rme, // region map entry of the embark tile
+                                     int river_flow                     // flow of the river of the world tile or -1
+                                     ) const
+{
+  int elevation                      = this->elevation[x][y];
+  int river_horiz_y_min              = rivers_horizontal.y_min[x][y  ];
+  int river_horiz_y_min_plus_one_row = rivers_horizontal.y_min[x+1][y];
+  int river_vert_x_min               = rivers_vertical.x_min[x  ][y];
+  int river_vert_x_min_plus_one_col  = rivers_vertical.x_min[x][y+1];
+
+  if ((river_horiz_y_min == -30000) && (river_horiz_y_min_plus_one_row == -30000))
+    if ((river_vert_x_min == -30000) && (river_vert_x_min_plus_one_col == -30000))
+      return no_river_watercourse(biome_type, elevation);
+
+  // Posibly rivers finishing in ocean or lake
+  // Posibly rivers in glacier or tundra are discarted
+  switch(biome_type)
+  {
+    case 1:     // GLACIER
+    case 2:     // TUNDRA
+    case 27:    // OCEAN_TROPICAL
+    case 28:    // OCEAN_TEMPERATE
+    case 29:    // OCEAN_ARCTIC
+    case 36:    // LAKE_TEMPERATE_FRESHWATER
+    case 37:    // LAKE_TEMPERATE_BRACKISH_WATER
+    case 38:    // LAKE_TEMPERATE_SALTWATER
+    case 39:    // LAKE_TROPICAL_FRESHWATER
+    case 40:    // LAKE_TROPICAL_BRACKISH_WATER
+    case 41:    // LAKE_TROPICAL_SALT_WATER
+                if ((biome_type < 27) ||  // OCEAN_TROPICAL
+                    (biome_type > 29) ||  // OCEAN_ARTIC
+                    (elevation  < 99))    // Not shore
+                  return no_river_watercourse(biome_type, elevation);
+                break;
+    default:    break;
+  }
+
+  Watercourse watercourse;
+
+  // DF only checks the brook flag when the flags array has more than one byte
+  bool brook_flag = (rme.flags & REGION_FLAG_IS_BROOK) != 0;
+
+  if ((rme.flags_size > 1) && brook_flag)
+  {
+    watercourse.value       = 32767;
+    watercourse.hydro_class = HYDRO_BROOK;
+  }
+  else if (river_flow == -1)
+  {
+    watercourse.value       = 1;
+    watercourse.hydro_class = HYDRO_SHORE; // Sea or lake shore
+  }
+  else
+  {
+    watercourse.value = (river_flow >= 32000) ? 32000 : river_flow;
+
+    if (river_flow >= 20000)
+      watercourse.hydro_class = HYDRO_MAJOR_RIVER;
+    else if (river_flow >= 10000)
+      watercourse.hydro_class = HYDRO_RIVER;
+    else if (river_flow >= 5000)
+      watercourse.hydro_class = HYDRO_MINOR_RIVER;
+    else
+      watercourse.hydro_class = HYDRO_STREAM;
+  }
+  return watercourse;
+}
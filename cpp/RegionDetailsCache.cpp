@@ -0,0 +1,203 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <string.h>
+
+#include "../include/RegionDetailsCache.h"
+#include "../include/TileFingerprints.h"
+#include "../include/WorldData.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ Local types
+*****************************************************************************/
+
+static const char     CACHE_MAGIC[8] = {'E','X','P','M','A','P','R','D'};
+static const uint32_t CACHE_VERSION  = 1;
+static const size_t   CACHE_ALIGN    = 4096;
+
+/*****************************************************************************
+ Class methods
+*****************************************************************************/
+
+RegionDetailsCache::RegionDetailsCache()
+  : _world_width(0),
+    _world_height(0),
+    _keys(nullptr),
+    _details(nullptr),
+    _hits(0),
+    _stores(0)
+{
+}
+
+//----------------------------------------------------------------------------//
+// Map the cache file. An existing file is reused if it was made for a world
+// of the same size, otherwise a new one, with all the slots empty, replaces it
+//----------------------------------------------------------------------------//
+bool RegionDetailsCache::open(const std::string& filename, // Cache file
+                              int world_width,             // World size in world coordinates
+                              int world_height
+                              )
+{
+  this->close();
+
+  size_t world_tiles    = (size_t)world_width * world_height;
+  size_t keys_end       = sizeof(Header) + world_tiles * sizeof(uint32_t);
+  size_t details_offset = (keys_end + CACHE_ALIGN - 1) / CACHE_ALIGN * CACHE_ALIGN;
+  size_t file_size      = details_offset + world_tiles * sizeof(SnapshotRegionDetails);
+
+  if (world_tiles == 0)
+    return false;
+
+  bool reused = false;
+  if (_file.open_update(filename) && (_file.size() == file_size))
+  {
+    const Header* header = (const Header*)_file.data();
+    reused = (memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0) &&
+             (header->version        == CACHE_VERSION)                       &&
+             (header->record_size    == sizeof(SnapshotRegionDetails))       &&
+             (header->world_width    == world_width)                         &&
+             (header->world_height   == world_height)                        &&
+             (header->details_offset == details_offset);
+  }
+
+  if (!reused)
+  {
+    // The new file is filled with zeros, so all the slots are empty
+    if (!_file.open(filename, file_size))
+      return false;
+
+    Header* header = (Header*)_file.data();
+    memcpy(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header->version        = CACHE_VERSION;
+    header->record_size    = sizeof(SnapshotRegionDetails);
+    header->world_width    = world_width;
+    header->world_height   = world_height;
+    header->details_offset = (uint32_t)details_offset;
+    header->reserved       = 0;
+  }
+
+  _world_width  = world_width;
+  _world_height = world_height;
+  _keys         = (uint32_t*)(_file.data() + sizeof(Header));
+  _details      = (SnapshotRegionDetails*)(_file.data() + details_offset);
+  _hits         = 0;
+  _stores       = 0;
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Unmap the cache file. The OS writes the stored tiles to disk
+//----------------------------------------------------------------------------//
+void RegionDetailsCache::close()
+{
+  _file.close();
+  _keys    = nullptr;
+  _details = nullptr;
+}
+
+//----------------------------------------------------------------------------//
+// DF generates the region details of a world tile from the region map of the
+// tile and its neighbors: the elevation of the corners is interpolated
+// between them, the biome of each region tile is taken from one of them and
+// the rivers follow the ones that cross them
+//----------------------------------------------------------------------------//
+uint32_t RegionDetailsCache::tile_key(const WorldData& world_data, // World tables
+                                      int x,                       // world coordinate x
+                                      int y                        // world coordinate y
+                                      )
+{
+  uint64_t hash = TileFingerprints::hash_bytes(nullptr, 0);
+
+  for (int dy = -1; dy <= 1; ++dy)
+    for (int dx = -1; dx <= 1; ++dx)
+    {
+      int nx = x + dx;
+      int ny = y + dy;
+
+      // Outside the world
+      int32_t values[6] = { -1, -1, -1, -1, -1, -1 };
+
+      if ((nx >= 0) && (nx < world_data.world_width()) &&
+          (ny >= 0) && (ny < world_data.world_height()))
+      {
+        const SnapshotRegionMapEntry& rme = world_data.region_map(nx, ny);
+        values[0] = rme.region_id;
+        values[1] = rme.biome_type;
+        values[2] = rme.elevation;
+        values[3] = rme.flags;
+        values[4] = rme.flags_size;
+        values[5] = world_data.river_flow(nx, ny);
+      }
+      hash = TileFingerprints::hash_bytes(values, sizeof(values), hash);
+    }
+
+  uint32_t key = (uint32_t)(hash ^ (hash >> 32));
+
+  // 0 marks the empty slots
+  return (key != 0) ? key : 1;
+}
+
+//----------------------------------------------------------------------------//
+// Copy a cached world tile
+//----------------------------------------------------------------------------//
+bool RegionDetailsCache::lookup(int x,                    // world coordinate x
+                                int y,                    // world coordinate y
+                                uint32_t key,             // tile_key() of the world tile
+                                SnapshotRegionDetails& rd // destination
+                                )
+{
+  if ((_keys == nullptr) ||
+      (x < 0) || (x >= _world_width) ||
+      (y < 0) || (y >= _world_height))
+    return false;
+
+  size_t index = (size_t)y * _world_width + x;
+  if (_keys[index] != key)
+    return false;
+
+  rd = _details[index];
+  ++_hits;
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Cache a world tile. The record is written before the key, so a cache file
+// left by a crash of DF has no slot with a valid key and a partial record
+//----------------------------------------------------------------------------//
+void RegionDetailsCache::store(int x,                          // world coordinate x
+                               int y,                          // world coordinate y
+                               uint32_t key,                   // tile_key() of the world tile
+                               const SnapshotRegionDetails& rd // region details generated by DF
+                               )
+{
+  if ((_keys == nullptr) ||
+      (x < 0) || (x >= _world_width) ||
+      (y < 0) || (y >= _world_height))
+    return;
+
+  size_t index = (size_t)y * _world_width + x;
+  _keys[index]    = 0;
+  _details[index] = rd;
+  _keys[index]    = key;
+  ++_stores;
+}
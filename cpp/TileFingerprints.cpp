@@ -0,0 +1,254 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+#include <fstream>
+#include <string.h>
+
+#include "../include/TileFingerprints.h"
+#include "../include/WorldData.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ Local types
+*****************************************************************************/
+
+static const char     FINGERPRINTS_MAGIC[8] = {'E','X','P','M','A','P','F','P'};
+static const uint32_t FINGERPRINTS_VERSION  = 1;
+
+// File header (40 bytes), followed by FIELD_COUNT planes of one uint32_t per
+// world tile and then by the file records: kind, bit and name length as
+// uint32_t and the name without the ending zero
+struct FingerprintsHeader
+{
+  char     magic[8];     // EXPMAPFP
+  uint32_t version;      // FINGERPRINTS_VERSION
+  uint32_t world_width;
+  uint32_t world_height;
+  uint32_t field_count;  // TileFingerprints::FIELD_COUNT
+  uint64_t overlays;     // Hash of sites, entities and constructions
+  uint32_t file_count;   // Number of file records
+  uint32_t unused;
+};
+
+/*****************************************************************************
+ Local functions
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Fold the hash of a few values to 32 bits
+//----------------------------------------------------------------------------//
+static uint32_t hash_values(const int32_t* values, // values to hash
+                            size_t count           // number of values
+                            )
+{
+  uint64_t hash = TileFingerprints::hash_bytes(values, count * sizeof(int32_t));
+  return (uint32_t)(hash ^ (hash >> 32));
+}
+
+/*****************************************************************************
+ Class methods
+*****************************************************************************/
+
+TileFingerprints::TileFingerprints()
+  : _width(0),
+    _height(0),
+    _overlays(0)
+{
+}
+
+//----------------------------------------------------------------------------//
+// FNV-1a, 64 bits
+//----------------------------------------------------------------------------//
+uint64_t TileFingerprints::hash_bytes(const void* data, // bytes to hash
+                                      size_t size,      // number of bytes
+                                      uint64_t hash     // previous hash
+                                      )
+{
+  const unsigned char* bytes = (const unsigned char*)data;
+  for (size_t i = 0; i < size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+//----------------------------------------------------------------------------//
+// Hash the fields of each world tile. The region details aren't hashed, as
+// generating them is what an incremental export wants to avoid; DF derives
+// them from the region map of the tile and its neighbors, which are hashed
+//----------------------------------------------------------------------------//
+void TileFingerprints::compute(WorldData& world_data)
+{
+  _width  = world_data.world_width();
+  _height = world_data.world_height();
+
+  size_t world_tiles = (size_t)_width * _height;
+  _hashes.assign(world_tiles * FIELD_COUNT, 0);
+  _files.clear();
+
+  for (int y = 0; y < _height; ++y)
+    for (int x = 0; x < _width; ++x)
+    {
+      const SnapshotRegionMapEntry& rme    = world_data.region_map(x, y);
+      const SnapshotRegion*         region = world_data.region(rme.region_id);
+
+      int32_t region_type  = (region != nullptr) ? region->type         : -1;
+      int32_t lake_surface = (region != nullptr) ? region->lake_surface : -30000;
+
+      int32_t terrain[] = { rme.elevation,
+                            rme.biome_type,
+                            (int32_t)rme.flags,
+                            rme.region_id,
+                            region_type,
+                            lake_surface,
+                            world_data.river_flow(x, y)
+                          };
+      int32_t region_fields[] = { rme.region_id, region_type, rme.biome_type };
+
+      uint32_t* tile = &_hashes[(size_t)y * _width + x];
+      tile[FIELD_TERRAIN     * world_tiles] = hash_values(terrain,       sizeof(terrain)       / sizeof(terrain[0]));
+      tile[FIELD_REGION      * world_tiles] = hash_values(region_fields, sizeof(region_fields) / sizeof(region_fields[0]));
+
+      // A single value is its own fingerprint
+      tile[FIELD_BIOME_TYPE  * world_tiles] = (uint16_t)rme.biome_type;
+      tile[FIELD_TEMPERATURE * world_tiles] = (uint16_t)rme.temperature;
+      tile[FIELD_RAINFALL    * world_tiles] = (uint16_t)rme.rainfall;
+      tile[FIELD_DRAINAGE    * world_tiles] = (uint16_t)rme.drainage;
+      tile[FIELD_SAVAGERY    * world_tiles] = (uint16_t)rme.savagery;
+      tile[FIELD_VOLCANISM   * world_tiles] = (uint16_t)rme.volcanism;
+      tile[FIELD_VEGETATION  * world_tiles] = (uint16_t)rme.vegetation;
+      tile[FIELD_EVILNESS    * world_tiles] = (uint16_t)rme.evilness;
+      tile[FIELD_SALINITY    * world_tiles] = (uint16_t)rme.salinity;
+    }
+
+  _overlays = world_data.overlay_fingerprint();
+}
+
+//----------------------------------------------------------------------------//
+// Read a fingerprints file
+//----------------------------------------------------------------------------//
+bool TileFingerprints::load(const std::string& filename // file to read
+                            )
+{
+  std::ifstream infile(filename, std::ios::in | std::ios::binary);
+  if (!infile)
+    return false;
+
+  FingerprintsHeader header;
+  if (!infile.read((char*)&header, sizeof(header)) ||
+      (memcmp(header.magic, FINGERPRINTS_MAGIC, sizeof(header.magic)) != 0) ||
+      (header.version != FINGERPRINTS_VERSION) ||
+      (header.field_count != FIELD_COUNT))
+    return false;
+
+  std::vector<uint32_t> hashes((size_t)header.world_width * header.world_height * FIELD_COUNT);
+  if (!hashes.empty() && !infile.read((char*)&hashes[0], hashes.size() * sizeof(uint32_t)))
+    return false;
+
+  std::vector<MapFile> files(header.file_count);
+  for (size_t i = 0; i < files.size(); ++i)
+  {
+    uint32_t record[3];
+    if (!infile.read((char*)record, sizeof(record)) || (record[2] > 4096))
+      return false;
+
+    files[i].kind = record[0];
+    files[i].bit  = record[1];
+    files[i].name.resize(record[2]);
+    if ((record[2] != 0) && !infile.read(&files[i].name[0], record[2]))
+      return false;
+  }
+
+  _width    = header.world_width;
+  _height   = header.world_height;
+  _overlays = header.overlays;
+  _hashes.swap(hashes);
+  _files.swap(files);
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Write a fingerprints file
+//----------------------------------------------------------------------------//
+bool TileFingerprints::save(const std::string& filename // file to write
+                            ) const
+{
+  std::ofstream outfile(filename, std::ios::out | std::ios::binary);
+  if (!outfile)
+    return false;
+
+  FingerprintsHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, FINGERPRINTS_MAGIC, sizeof(header.magic));
+  header.version      = FINGERPRINTS_VERSION;
+  header.world_width  = _width;
+  header.world_height = _height;
+  header.field_count  = FIELD_COUNT;
+  header.overlays     = _overlays;
+  header.file_count   = (uint32_t)_files.size();
+
+  outfile.write((const char*)&header, sizeof(header));
+  if (!_hashes.empty())
+    outfile.write((const char*)&_hashes[0], _hashes.size() * sizeof(uint32_t));
+
+  for (size_t i = 0; i < _files.size(); ++i)
+  {
+    uint32_t record[3] = { _files[i].kind, _files[i].bit, (uint32_t)_files[i].name.size() };
+    outfile.write((const char*)record, sizeof(record));
+    outfile.write(_files[i].name.data(), _files[i].name.size());
+  }
+
+  outfile.close();
+  return !outfile.fail();
+}
+
+//----------------------------------------------------------------------------//
+// Name of the file written for a map, or nullptr
+//----------------------------------------------------------------------------//
+const std::string* TileFingerprints::file(MapKind kind, // kind of map
+                                          uint32_t bit  // map type bit
+                                          ) const
+{
+  for (size_t i = 0; i < _files.size(); ++i)
+    if ((_files[i].kind == (uint32_t)kind) && (_files[i].bit == bit))
+      return &_files[i].name;
+  return nullptr;
+}
+
+//----------------------------------------------------------------------------//
+// Set the name of the file written for a map, replacing the previous one
+//----------------------------------------------------------------------------//
+void TileFingerprints::set_file(MapKind kind,            // kind of map
+                                uint32_t bit,            // map type bit
+                                const std::string& name  // file name
+                                )
+{
+  for (size_t i = 0; i < _files.size(); ++i)
+    if ((_files[i].kind == (uint32_t)kind) && (_files[i].bit == bit))
+    {
+      _files[i].name = name;
+      return;
+    }
+
+  MapFile map_file = { (uint32_t)kind, bit, name };
+  _files.push_back(map_file);
+}
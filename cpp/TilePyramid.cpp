@@ -0,0 +1,246 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <algorithm>
+#include <sstream>
+
+#ifdef WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "../include/BufferPool.h"
+#include "../include/TilePyramid.h"
+#include "../include/Tracer.h"
+#include "../include/util/lodepng.h"
+
+using namespace exportmaps_plugin;
+
+//----------------------------------------------------------------------------//
+// Utility function
+// Create a directory. The pyramids are also written outside DF, so DFHack
+// filesystem functions can't be used. Existing directories are not an error
+//----------------------------------------------------------------------------//
+static void make_directory(const std::string& path)
+{
+#ifdef WIN32
+  _mkdir(path.c_str());
+#else
+  mkdir(path.c_str(), 0755);
+#endif
+}
+
+//----------------------------------------------------------------------------//
+// Constructor.
+// All the zoom levels are built here, while the full resolution image is
+// still in the cache, and the list of tiles to encode is prepared.
+// The image is moved into the deepest level, so image is left empty
+//----------------------------------------------------------------------------//
+TilePyramid::TilePyramid(const std::string directory,             // root directory of the pyramid
+                         std::vector<unsigned char>& image,       // RGBA pixels at full resolution
+                         int width,                               // image width in pixels
+                         int height                               // image height in pixels
+                         )
+  : _directory(directory),
+    _next_tile(0),
+    _error(0)
+{
+  // Number of zoom levels needed until the whole image fits in a single tile
+  int num_levels = 1;
+  while ((TILE_SIZE << (num_levels - 1)) < width ||
+         (TILE_SIZE << (num_levels - 1)) < height)
+    num_levels++;
+
+  _levels.resize(num_levels);
+
+  // The deepest level is the image itself
+  Level& deepest = _levels[num_levels - 1];
+  deepest.image.swap(image);
+  deepest.width  = width;
+  deepest.height = height;
+
+  for (int z = num_levels - 2; z >= 0; --z)
+    downsample(_levels[z + 1], _levels[z]);
+
+  for (int z = 0; z < num_levels; ++z)
+  {
+    Level& level  = _levels[z];
+    level.tiles_x = (level.width  + TILE_SIZE - 1) / TILE_SIZE;
+    level.tiles_y = (level.height + TILE_SIZE - 1) / TILE_SIZE;
+
+    for (int x = 0; x < level.tiles_x; ++x)
+      for (int y = 0; y < level.tiles_y; ++y)
+      {
+        Tile tile = {z, x, y};
+        _tiles.push_back(tile);
+      }
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Destructor
+//----------------------------------------------------------------------------//
+TilePyramid::~TilePyramid()
+{
+  for (unsigned int i = 0; i < _levels.size(); ++i)
+    BufferPool::recycle(_levels[i].image);
+}
+
+//----------------------------------------------------------------------------//
+// Each pixel is the average of a 2x2 block of the deeper level. In the last
+// row or column of an odd sized level the block is clamped to the border
+//----------------------------------------------------------------------------//
+void TilePyramid::downsample(const Level& source, // deeper level
+                             Level& dest          // level to be built
+                             )
+{
+  dest.width  = (source.width  + 1) / 2;
+  dest.height = (source.height + 1) / 2;
+  BufferPool::acquire(dest.image, (size_t)dest.width * dest.height * 4);
+
+  for (int y = 0; y < dest.height; ++y)
+  {
+    int y0 = 2 * y;
+    int y1 = (y0 + 1 < source.height) ? y0 + 1 : y0;
+
+    const unsigned char* row0 = &source.image[(size_t)y0 * source.width * 4];
+    const unsigned char* row1 = &source.image[(size_t)y1 * source.width * 4];
+    unsigned char*       out  = &dest.image[(size_t)y * dest.width * 4];
+
+    for (int x = 0; x < dest.width; ++x)
+    {
+      int x0 = 2 * x;
+      int x1 = (x0 + 1 < source.width) ? x0 + 1 : x0;
+
+      for (int c = 0; c < 4; ++c)
+      {
+        int sum = row0[4*x0 + c] + row0[4*x1 + c] +
+                  row1[4*x0 + c] + row1[4*x1 + c];
+        out[4*x + c] = (unsigned char)((sum + 2) / 4);
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Copy the pixels of a tile and encode them as a PNG.
+// The part of the tile outside the level is left transparent
+//----------------------------------------------------------------------------//
+unsigned int TilePyramid::encode_tile(const Tile& tile,                  // tile to encode
+                                      std::vector<unsigned char>& pixels // scratch buffer
+                                      )
+{
+  TraceSpan trace_span("tile encode");
+
+  const Level& level = _levels[tile.z];
+
+  pixels.assign(TILE_SIZE * TILE_SIZE * 4, 0);
+
+  int left   = tile.x * TILE_SIZE;
+  int top    = tile.y * TILE_SIZE;
+  int width  = (level.width  - left < TILE_SIZE) ? level.width  - left : TILE_SIZE;
+  int height = (level.height - top  < TILE_SIZE) ? level.height - top  : TILE_SIZE;
+
+  for (int y = 0; y < height; ++y)
+    std::copy(&level.image[((size_t)(top + y) * level.width + left) * 4],
+              &level.image[((size_t)(top + y) * level.width + left + width) * 4],
+              &pixels[(size_t)y * TILE_SIZE * 4]
+              );
+
+  std::stringstream file_name;
+  file_name << _directory << "/" << tile.z << "/" << tile.x << "/" << tile.y << ".png";
+
+  return lodepng::encode(file_name.str(), pixels, TILE_SIZE, TILE_SIZE);
+}
+
+//----------------------------------------------------------------------------//
+// Take tiles from the shared list until all of them have been encoded
+//----------------------------------------------------------------------------//
+void TilePyramid::worker(void* arg)
+{
+  TilePyramid* pyramid = (TilePyramid*)arg;
+  std::vector<unsigned char> pixels;
+
+  Tracer::set_thread_name("tile encoder");
+
+  while (true)
+  {
+    size_t index;
+    {
+      tthread::lock_guard<tthread::mutex> guard(pyramid->_mutex);
+      if (pyramid->_next_tile >= pyramid->_tiles.size())
+        return;
+      index = pyramid->_next_tile++;
+    }
+
+    unsigned int error = pyramid->encode_tile(pyramid->_tiles[index], pixels);
+    if (error != 0)
+    {
+      tthread::lock_guard<tthread::mutex> guard(pyramid->_mutex);
+      if (pyramid->_error == 0)
+        pyramid->_error = error;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Create the z/x directories and encode all the tiles
+//----------------------------------------------------------------------------//
+unsigned int TilePyramid::write_to_disk(unsigned int num_threads // number of encoding threads
+                                        )
+{
+  make_directory(_directory);
+  for (size_t z = 0; z < _levels.size(); ++z)
+  {
+    std::stringstream level_dir;
+    level_dir << _directory << "/" << z;
+    make_directory(level_dir.str());
+
+    for (int x = 0; x < _levels[z].tiles_x; ++x)
+    {
+      std::stringstream column_dir;
+      column_dir << level_dir.str() << "/" << x;
+      make_directory(column_dir.str());
+    }
+  }
+
+  if (num_threads == 0)
+    num_threads = 1;
+  if (num_threads > _tiles.size())
+    num_threads = (unsigned int)_tiles.size();
+
+  // The calling thread also encodes tiles
+  std::vector<tthread::thread*> threads;
+  for (unsigned int i = 1; i < num_threads; ++i)
+    threads.push_back(new tthread::thread(worker, (void*)this));
+
+  worker((void*)this);
+
+  for (size_t i = 0; i < threads.size(); ++i)
+  {
+    threads[i]->join();
+    delete threads[i];
+  }
+
+  return _error;
+}
@@ -0,0 +1,214 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <vector>
+
+#include <tinythread.h>
+
+#include "../include/Tracer.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ Span storage
+*****************************************************************************/
+
+// Spans kept for each thread. A 257x257 world needs about 130000 spans in
+// the producer thread; the limit only bounds the memory of huge worlds
+static const size_t MAX_SPANS_PER_THREAD = 1 << 21;
+
+struct TraceEvent
+{
+  const char* name;
+  int64_t     begin;
+  int64_t     end;
+};
+
+struct TraceBuffer
+{
+  unsigned int            thread_index; // tid shown in the trace
+  const char*             thread_name;  // nullptr if the thread was not named
+  std::vector<TraceEvent> events;
+  uint64_t                dropped;      // Spans not kept because the buffer was full
+};
+
+// All the buffers of the current session. Only touched with the mutex held,
+// when a thread records its first span or when the session starts or ends
+static std::vector<std::unique_ptr<TraceBuffer> > trace_buffers;
+static tthread::mutex                             trace_buffers_mutex;
+static unsigned int                               trace_session = 0;
+static int64_t                                    trace_start   = 0;
+
+// Buffer of each thread and the session it was created for. A buffer from
+// a previous session has already been freed and is never used
+static thread_local TraceBuffer* thread_buffer  = nullptr;
+static thread_local unsigned int thread_session = 0;
+
+std::atomic<bool> Tracer::_enabled(false);
+
+/*****************************************************************************
+ Local functions
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Return the buffer of the calling thread, creating it the first time the
+// thread records something in this session
+//----------------------------------------------------------------------------//
+static TraceBuffer* get_thread_buffer()
+{
+  if ((thread_buffer == nullptr) || (thread_session != trace_session))
+  {
+    tthread::lock_guard<tthread::mutex> guard(trace_buffers_mutex);
+
+    std::unique_ptr<TraceBuffer> buffer(new TraceBuffer);
+    buffer->thread_index = trace_buffers.size() + 1;
+    buffer->thread_name  = nullptr;
+    buffer->dropped      = 0;
+    buffer->events.reserve(4096);
+
+    thread_buffer  = buffer.get();
+    thread_session = trace_session;
+    trace_buffers.push_back(std::move(buffer));
+  }
+  return thread_buffer;
+}
+
+//----------------------------------------------------------------------------//
+// Write a time in microseconds relative to the start of the session, as
+// expected by the trace viewers
+//----------------------------------------------------------------------------//
+static void write_microseconds(std::ostream& out, int64_t nanoseconds)
+{
+  out << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+}
+
+/*****************************************************************************
+ Tracer methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Discard any previous spans and start recording
+//----------------------------------------------------------------------------//
+void Tracer::start()
+{
+  tthread::lock_guard<tthread::mutex> guard(trace_buffers_mutex);
+
+  trace_buffers.clear();
+  ++trace_session;
+  trace_start = now();
+  _enabled.store(true);
+}
+
+//----------------------------------------------------------------------------//
+// Store a span in the buffer of the calling thread
+//----------------------------------------------------------------------------//
+void Tracer::record(const char* name,
+                    int64_t begin,
+                    int64_t end
+                    )
+{
+  TraceBuffer* buffer = get_thread_buffer();
+
+  if (buffer->events.size() >= MAX_SPANS_PER_THREAD)
+  {
+    buffer->dropped++;
+    return;
+  }
+
+  TraceEvent event;
+  event.name  = name;
+  event.begin = begin;
+  event.end   = end;
+  buffer->events.push_back(event);
+}
+
+//----------------------------------------------------------------------------//
+// Name shown for the calling thread in the trace viewer. The first name is
+// kept, as the producer thread also runs some workers (tile encoders)
+//----------------------------------------------------------------------------//
+void Tracer::set_thread_name(const char* name)
+{
+  if (is_enabled())
+  {
+    TraceBuffer* buffer = get_thread_buffer();
+    if (buffer->thread_name == nullptr)
+      buffer->thread_name = name;
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Stop recording and write all the spans as Chrome trace JSON.
+// Must be called once the threads that recorded spans have finished
+//----------------------------------------------------------------------------//
+bool Tracer::write(const std::string& file_name)
+{
+  _enabled.store(false);
+
+  tthread::lock_guard<tthread::mutex> guard(trace_buffers_mutex);
+
+  std::ofstream out(file_name.c_str(), std::ios::out | std::ios::trunc);
+  if (out.is_open())
+  {
+    uint64_t dropped = 0;
+    bool     first   = true;
+
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < trace_buffers.size(); ++i)
+    {
+      const TraceBuffer& buffer = *trace_buffers[i];
+
+      // Metadata event with the thread name
+      if (buffer.thread_name != nullptr)
+      {
+        out << (first ? "\n" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.thread_index
+            << ",\"args\":{\"name\":\"" << buffer.thread_name << "\"}}";
+        first = false;
+      }
+
+      // Complete events, with begin and duration
+      for (size_t j = 0; j < buffer.events.size(); ++j)
+      {
+        const TraceEvent& event = buffer.events[j];
+
+        out << (first ? "\n" : ",\n")
+            << "{\"name\":\"" << event.name << "\",\"cat\":\"exportmaps\",\"ph\":\"X\",\"ts\":";
+        write_microseconds(out, event.begin - trace_start);
+        out << ",\"dur\":";
+        write_microseconds(out, event.end - event.begin);
+        out << ",\"pid\":1,\"tid\":" << buffer.thread_index << "}";
+        first = false;
+      }
+      dropped += buffer.dropped;
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_spans\":" << dropped << "}}\n";
+  }
+
+  bool ok = out.is_open() && out.good();
+
+  // Free the spans
+  trace_buffers.clear();
+
+  return ok;
+}
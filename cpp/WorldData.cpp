@@ -0,0 +1,128 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <string.h>
+
+#include "../include/TileFingerprints.h"
+#include "../include/WorldData.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ WorldData methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Constructor. The derived classes fill the tables
+//----------------------------------------------------------------------------//
+WorldData::WorldData()
+  : _world_width(0),
+    _world_height(0),
+    _region_map(nullptr),
+    _regions(nullptr),
+    _region_count(0),
+    _river_flow(nullptr)
+{
+  memset(&_world_info, 0, sizeof(_world_info));
+}
+
+/*****************************************************************************
+ SnapshotWorldData methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Map the snapshot and point the tables to its sections
+//----------------------------------------------------------------------------//
+bool SnapshotWorldData::open(const std::string& filename // snapshot file
+                             )
+{
+  if (!_snapshot.open(filename))
+    return false;
+
+  _world_width  = _snapshot.world_width();
+  _world_height = _snapshot.world_height();
+  _region_map   = &_snapshot.region_map(0, 0);
+
+  size_t count = 0;
+  _regions      = (const SnapshotRegion*)_snapshot.section(SECTION_REGIONS, count);
+  _region_count = count;
+
+  // Optional sections
+  const SnapshotWorldInfo* world_info = (const SnapshotWorldInfo*)_snapshot.section(SECTION_WORLD_INFO, count);
+  if ((world_info != nullptr) && (count == 1))
+  {
+    _world_info = *world_info;
+    _world_info.world_folder[sizeof(_world_info.world_folder) - 1] = 0;
+  }
+
+  _river_flow = (const int32_t*)_snapshot.section(SECTION_RIVER_FLOW, count);
+  if (count != (size_t)_world_width * _world_height)
+    _river_flow = nullptr;
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// The region details of every world tile are stored in the snapshot
+//----------------------------------------------------------------------------//
+bool SnapshotWorldData::region_details(int x,                    // world coordinate x
+                                       int y,                    // world coordinate y
+                                       SnapshotRegionDetails& rd // destination
+                                       )
+{
+  if ((x < 0) || (x >= _world_width) || (y < 0) || (y >= _world_height))
+    return false;
+
+  rd = _snapshot.region_details(x, y);
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Hash the sections read by the sites, trading, nobility and diplomacy maps
+//----------------------------------------------------------------------------//
+uint64_t SnapshotWorldData::overlay_fingerprint()
+{
+  static const struct
+  {
+    SnapshotSectionId id;
+    size_t            record_size;
+  } sections[] = { { SECTION_SITES,                sizeof(SnapshotSite)               },
+                   { SECTION_ENTITIES,             sizeof(SnapshotEntity)             },
+                   { SECTION_ENTITY_SITE_LINKS,    sizeof(SnapshotEntitySiteLink)     },
+                   { SECTION_CONSTRUCTIONS,        sizeof(SnapshotConstruction)       },
+                   { SECTION_CONSTRUCTION_SQUARES, sizeof(SnapshotConstructionSquare) },
+                   { SECTION_CONSTRUCTION_POINTS,  sizeof(SnapshotConstructionPoint)  }
+                 };
+
+  uint64_t hash = TileFingerprints::hash_bytes(nullptr, 0);
+  for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); ++i)
+  {
+    size_t      count   = 0;
+    const void* records = _snapshot.section(sections[i].id, count);
+    if (records == nullptr)
+      count = 0;
+
+    hash = TileFingerprints::hash_bytes(&count, sizeof(count), hash);
+    if (count != 0)
+      hash = TileFingerprints::hash_bytes(records, count * sections[i].record_size, hash);
+  }
+  return hash;
+}
@@ -0,0 +1,821 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "../include/WorldGenerator.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ Local constants
+*****************************************************************************/
+
+// Size in world tiles of the cells of the region grid
+static const int REGION_CELL_SIZE = 12;
+
+// Sides of a world tile crossed by a river
+static const unsigned int RIVER_SIDE_N = 1;
+static const unsigned int RIVER_SIDE_S = 2;
+static const unsigned int RIVER_SIDE_W = 4;
+static const unsigned int RIVER_SIDE_E = 8;
+
+// Rivers with less flow than this are brooks
+static const int BROOK_MAX_FLOW = 3000;
+
+// Site bounds are stored as int16 embark coordinates
+static const int SITES_MAX_WORLD_COORD = 32767 / 16;
+
+// Salts that make each field independent of the others
+enum FieldSalt : uint32_t
+{
+  SALT_ELEVATION = 1,
+  SALT_TEMPERATURE,
+  SALT_RAINFALL,
+  SALT_DRAINAGE,
+  SALT_SAVAGERY,
+  SALT_VOLCANISM,
+  SALT_EVILNESS,
+  SALT_SALINITY,
+  SALT_BIOME_BORDER,
+  SALT_REGION_SEED,
+  SALT_SITES,
+  SALT_ENTITIES,
+  SALT_ROADS,
+  SALT_RIVERS
+};
+
+/*****************************************************************************
+ Local functions
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Integer hash of a lattice point. Gives the same value on every platform
+//----------------------------------------------------------------------------//
+static uint32_t hash_point(int x, int y, uint32_t seed)
+{
+  uint32_t h = seed * 0x9E3779B9u;
+  h ^= (uint32_t)x * 0x85EBCA6Bu;
+  h ^= (uint32_t)y * 0xC2B2AE35u;
+  h ^= h >> 16; h *= 0x7FEB352Du;
+  h ^= h >> 15; h *= 0x846CA68Bu;
+  h ^= h >> 16;
+  return h;
+}
+
+//----------------------------------------------------------------------------//
+// Value noise in 0..1 with a lattice point at each integer coordinate
+//----------------------------------------------------------------------------//
+static double value_noise(double x, double y, uint32_t seed)
+{
+  double fx = floor(x);
+  double fy = floor(y);
+  int    ix = (int)fx;
+  int    iy = (int)fy;
+
+  // Smoothstep between the lattice points
+  double tx = x - fx; tx = tx * tx * (3.0 - 2.0 * tx);
+  double ty = y - fy; ty = ty * ty * (3.0 - 2.0 * ty);
+
+  const double scale = 1.0 / 4294967295.0;
+  double v00 = hash_point(ix,     iy,     seed) * scale;
+  double v10 = hash_point(ix + 1, iy,     seed) * scale;
+  double v01 = hash_point(ix,     iy + 1, seed) * scale;
+  double v11 = hash_point(ix + 1, iy + 1, seed) * scale;
+
+  double top    = v00 + (v10 - v00) * tx;
+  double bottom = v01 + (v11 - v01) * tx;
+  return top + (bottom - top) * ty;
+}
+
+static int clamp_value(int value, int min_value, int max_value)
+{
+  return std::min(std::max(value, min_value), max_value);
+}
+
+/*****************************************************************************
+ Small deterministic random generator (xorshift), independent of the
+ standard library implementation
+*****************************************************************************/
+class WorldRandom
+{
+  uint32_t _state;
+public:
+  WorldRandom(uint32_t seed, uint32_t salt)
+    : _state(hash_point((int)salt, 0, seed) | 1)
+  {}
+
+  uint32_t next()
+  {
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+  }
+
+  // Random number in 0..max_value-1
+  int below(int max_value)
+  {
+    return max_value > 0 ? (int)(next() % (uint32_t)max_value) : 0;
+  }
+
+  // Random number in min_value..max_value
+  int range(int min_value, int max_value)
+  {
+    return min_value + below(max_value - min_value + 1);
+  }
+};
+
+/*****************************************************************************
+ WorldGenerator methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Constructor. Choose the unspecified amounts from the world size and place
+// the region seeds
+//----------------------------------------------------------------------------//
+WorldGenerator::WorldGenerator(const WorldGeneratorOptions& options)
+  : _options(options)
+{
+  size_t world_tiles = (size_t)_options.world_width * _options.world_height;
+
+  if (_options.num_sites < 0)
+    _options.num_sites = (int)std::min(world_tiles / 24, (size_t)1000000);
+  if (_options.num_entities < 0)
+    _options.num_entities = _options.num_sites / 3;
+  if (_options.num_roads < 0)
+    _options.num_roads = _options.num_sites / 4;
+
+  // One region seed at a random place of each grid cell
+  _region_cols = (_options.world_width  + REGION_CELL_SIZE - 1) / REGION_CELL_SIZE;
+  _region_rows = (_options.world_height + REGION_CELL_SIZE - 1) / REGION_CELL_SIZE;
+  _region_seeds.resize((size_t)_region_cols * _region_rows);
+
+  for (int cy = 0; cy < _region_rows; ++cy)
+    for (int cx = 0; cx < _region_cols; ++cx)
+    {
+      RegionSeed& seed = _region_seeds[(size_t)cy * _region_cols + cx];
+      uint32_t h = hash_point(cx, cy, _options.seed ^ SALT_REGION_SEED);
+
+      seed.x = std::min(cx * REGION_CELL_SIZE + (int)(h         % REGION_CELL_SIZE), _options.world_width  - 1);
+      seed.y = std::min(cy * REGION_CELL_SIZE + (int)((h >> 16) % REGION_CELL_SIZE), _options.world_height - 1);
+
+      SnapshotRegionMapEntry rme;
+      fill_region_map_entry(seed.x, seed.y, rme);
+      seed.biome_type = rme.biome_type;
+    }
+}
+
+//----------------------------------------------------------------------------//
+// Generate the whole world into a snapshot file
+//----------------------------------------------------------------------------//
+bool WorldGenerator::write(const std::string& filename // snapshot file
+                           )
+{
+  int    world_width  = _options.world_width;
+  int    world_height = _options.world_height;
+  size_t world_tiles  = (size_t)world_width * world_height;
+
+  // The lists are generated first, as the file needs the number of records
+  std::vector<SnapshotSite>               sites;
+  std::vector<SnapshotEntity>             entities;
+  std::vector<SnapshotEntitySiteLink>     entity_site_links;
+  std::vector<SnapshotConstruction>       constructions;
+  std::vector<SnapshotConstructionSquare> construction_squares;
+  std::vector<SnapshotConstructionPoint>  construction_points;
+
+  generate_sites(sites);
+  generate_entities(sites, entities, entity_site_links);
+  generate_roads(sites, constructions, construction_squares, construction_points);
+
+  WorldSnapshotWriter writer;
+  writer.add_section(SECTION_WORLD_INFO,           sizeof(SnapshotWorldInfo),          1);
+  writer.add_section(SECTION_REGION_MAP,           sizeof(SnapshotRegionMapEntry),     world_tiles);
+  writer.add_section(SECTION_REGIONS,              sizeof(SnapshotRegion),             _region_seeds.size());
+  writer.add_section(SECTION_RIVER_FLOW,           sizeof(int32_t),                    world_tiles);
+  writer.add_section(SECTION_REGION_DETAILS,       sizeof(SnapshotRegionDetails),      world_tiles);
+  writer.add_section(SECTION_SITES,                sizeof(SnapshotSite),               sites.size());
+  writer.add_section(SECTION_ENTITIES,             sizeof(SnapshotEntity),             entities.size());
+  writer.add_section(SECTION_ENTITY_SITE_LINKS,    sizeof(SnapshotEntitySiteLink),     entity_site_links.size());
+  writer.add_section(SECTION_CONSTRUCTIONS,        sizeof(SnapshotConstruction),       constructions.size());
+  writer.add_section(SECTION_CONSTRUCTION_SQUARES, sizeof(SnapshotConstructionSquare), construction_squares.size());
+  writer.add_section(SECTION_CONSTRUCTION_POINTS,  sizeof(SnapshotConstructionPoint),  construction_points.size());
+
+  if (!writer.create(filename, world_width, world_height))
+    return false;
+
+  if (!sites.empty())
+    memcpy(writer.records(SECTION_SITES), &sites[0], sites.size() * sizeof(SnapshotSite));
+  if (!entities.empty())
+    memcpy(writer.records(SECTION_ENTITIES), &entities[0], entities.size() * sizeof(SnapshotEntity));
+  if (!entity_site_links.empty())
+    memcpy(writer.records(SECTION_ENTITY_SITE_LINKS), &entity_site_links[0], entity_site_links.size() * sizeof(SnapshotEntitySiteLink));
+  if (!constructions.empty())
+    memcpy(writer.records(SECTION_CONSTRUCTIONS), &constructions[0], constructions.size() * sizeof(SnapshotConstruction));
+  if (!construction_squares.empty())
+    memcpy(writer.records(SECTION_CONSTRUCTION_SQUARES), &construction_squares[0], construction_squares.size() * sizeof(SnapshotConstructionSquare));
+  if (!construction_points.empty())
+    memcpy(writer.records(SECTION_CONSTRUCTION_POINTS), &construction_points[0], construction_points.size() * sizeof(SnapshotConstructionPoint));
+
+  // Regions take their type from the biome at their seed
+  SnapshotRegion* regions = (SnapshotRegion*)writer.records(SECTION_REGIONS);
+  for (size_t i = 0; i < _region_seeds.size(); ++i)
+  {
+    regions[i].type         = region_type(_region_seeds[i].biome_type);
+    regions[i].lake_surface = -30000;
+  }
+
+  // The region map is written first, as the rivers are traced over it
+  SnapshotRegionMapEntry* region_map = (SnapshotRegionMapEntry*)writer.records(SECTION_REGION_MAP);
+  for (int y = 0; y < world_height; ++y)
+    for (int x = 0; x < world_width; ++x)
+      fill_region_map_entry(x, y, region_map[(size_t)y * world_width + x]);
+
+  int32_t*             river_flow = (int32_t*)writer.records(SECTION_RIVER_FLOW);
+  std::vector<uint8_t> river_sides(world_tiles, 0);
+  trace_rivers(region_map, river_flow, river_sides);
+
+  // Region details, keeping the highest point for the heightmaps
+  SnapshotRegionDetails* region_details = (SnapshotRegionDetails*)writer.records(SECTION_REGION_DETAILS);
+  int max_elevation = 0;
+  for (int y = 0; y < world_height; ++y)
+    for (int x = 0; x < world_width; ++x)
+    {
+      size_t index = (size_t)y * world_width + x;
+      SnapshotRegionDetails& rd = region_details[index];
+      fill_region_details(x, y, region_map[index], river_sides[index], rd);
+
+      for (int i = 0; i < 17; ++i)
+        for (int j = 0; j < 17; ++j)
+          max_elevation = std::max(max_elevation, (int)rd.elevation[i][j]);
+    }
+
+  SnapshotWorldInfo* world_info = (SnapshotWorldInfo*)writer.records(SECTION_WORLD_INFO);
+  snprintf(world_info->world_folder, sizeof(world_info->world_folder), "synthetic-%u", _options.seed);
+  world_info->year          = 250;
+  world_info->month         = 1;
+  world_info->day           = 1;
+  world_info->max_elevation = max_elevation;
+
+  writer.close();
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Place the sites over land, preferring the lowlands. Their bounds are stored
+// in int16 embark coordinates, so in very big worlds they are placed only in
+// the first 2047x2047 world tiles
+//----------------------------------------------------------------------------//
+void WorldGenerator::generate_sites(std::vector<SnapshotSite>& sites
+                                    )
+{
+  WorldRandom random(_options.seed, SALT_SITES);
+  int max_x = std::min(_options.world_width,  SITES_MAX_WORLD_COORD);
+  int max_y = std::min(_options.world_height, SITES_MAX_WORLD_COORD);
+
+  sites.reserve(_options.num_sites);
+  for (int i = 0; i < _options.num_sites; ++i)
+  {
+    // Look for a lowland tile, but don't try forever in a world of oceans
+    int x = 0, y = 0;
+    for (int tries = 0; tries < 16; ++tries)
+    {
+      x = random.below(max_x);
+      y = random.below(max_y);
+      int e = elevation(x * 16 + 8, y * 16 + 8);
+      if ((e >= 100) && (e < 150))
+        break;
+    }
+
+    SnapshotSite site;
+    memset(&site, 0, sizeof(site));
+    site.id         = i;
+    site.type       = (int16_t)random.below(11);
+    site.flags_size = 2;
+
+    // Towns, fortresses, mountain halls and dark fortresses are bigger
+    bool big = (site.type == 1) || (site.type == 3) || (site.type == 5) || (site.type == 8);
+    int size_x = big ? random.range(3, 8) : random.range(1, 3);
+    int size_y = big ? random.range(3, 8) : random.range(1, 3);
+
+    site.global_min_x = (int16_t)(x * 16 + random.below(16 - size_x));
+    site.global_min_y = (int16_t)(y * 16 + random.below(16 - size_y));
+    site.global_max_x = (int16_t)(site.global_min_x + size_x - 1);
+    site.global_max_y = (int16_t)(site.global_min_y + size_y - 1);
+    site.population   = big ? random.range(50, 2000) : random.range(0, 100);
+
+    // Half the towns have a market
+    if ((site.type == 5) && (random.next() & 1))
+      site.flags = 0x08;
+
+    sites.push_back(site);
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Create civilizations, linked to many sites, and site governments, linked
+// to a single one
+//----------------------------------------------------------------------------//
+void WorldGenerator::generate_entities(const std::vector<SnapshotSite>& sites,
+                                       std::vector<SnapshotEntity>& entities,
+                                       std::vector<SnapshotEntitySiteLink>& links
+                                       )
+{
+  WorldRandom random(_options.seed, SALT_ENTITIES);
+
+  entities.reserve(_options.num_entities);
+  for (int i = 0; i < _options.num_entities; ++i)
+  {
+    SnapshotEntity entity;
+    entity.id              = i;
+    entity.type            = (i % 8 == 0) ? 0 : 1; // Civilization or SiteGovernment
+    entity.first_site_link = (uint32_t)links.size();
+
+    int num_links = sites.empty() ? 0 : (entity.type == 0 ? random.range(2, 12) : 1);
+    for (int j = 0; j < num_links; ++j)
+    {
+      SnapshotEntitySiteLink link;
+      link.target = sites[random.below((int)sites.size())].id;
+
+      // The first site is the residence, the others are markets
+      if (j == 0)
+        link.flags = 0x01;
+      else
+        link.flags = (random.next() & 1) ? 0x08 : 0x10;
+
+      links.push_back(link);
+    }
+
+    entity.site_link_count = (uint32_t)links.size() - entity.first_site_link;
+    entities.push_back(entity);
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Join sites with roads. Each road goes from a random site to the nearest of
+// a few other random ones, crossing the world tiles in between
+//----------------------------------------------------------------------------//
+void WorldGenerator::generate_roads(const std::vector<SnapshotSite>& sites,
+                                    std::vector<SnapshotConstruction>& constructions,
+                                    std::vector<SnapshotConstructionSquare>& squares,
+                                    std::vector<SnapshotConstructionPoint>& points
+                                    )
+{
+  if (sites.size() < 2)
+    return;
+
+  WorldRandom random(_options.seed, SALT_ROADS);
+
+  constructions.reserve(_options.num_roads);
+  for (int i = 0; i < _options.num_roads; ++i)
+  {
+    const SnapshotSite& from = sites[random.below((int)sites.size())];
+    int x  = from.global_min_x / 16;
+    int y  = from.global_min_y / 16;
+
+    // Nearest destination among some candidates
+    int to_x = x, to_y = y, best_distance = -1;
+    for (int c = 0; c < 8; ++c)
+    {
+      const SnapshotSite& candidate = sites[random.below((int)sites.size())];
+      int cx = candidate.global_min_x / 16;
+      int cy = candidate.global_min_y / 16;
+      int distance = abs(cx - x) + abs(cy - y);
+      if ((distance > 0) && ((best_distance == -1) || (distance < best_distance)))
+      {
+        best_distance = distance;
+        to_x = cx;
+        to_y = cy;
+      }
+    }
+    if (best_distance == -1)
+      continue;
+
+    SnapshotConstruction construction;
+    construction.id           = (int32_t)constructions.size();
+    construction.type         = 0; // road
+    construction.first_square = (uint32_t)squares.size();
+
+    int16_t stone = (int16_t)(random.next() & 1);
+
+    // Walk the world tiles, moving along the axis with more distance left.
+    // The road crosses each square through its middle row or column
+    while (true)
+    {
+      int dx = to_x - x;
+      int dy = to_y - y;
+      bool horizontal = abs(dx) >= abs(dy);
+
+      SnapshotConstructionSquare square;
+      memset(&square, 0, sizeof(square));
+      square.region_x    = (int16_t)x;
+      square.region_y    = (int16_t)y;
+      square.stone       = stone;
+      square.first_point = (uint32_t)points.size();
+      square.point_count = 16;
+
+      for (int k = 0; k < 16; ++k)
+      {
+        SnapshotConstructionPoint point;
+        point.embark_x = (int16_t)(horizontal ? k : 8);
+        point.embark_y = (int16_t)(horizontal ? 8 : k);
+        points.push_back(point);
+      }
+      squares.push_back(square);
+
+      if ((dx == 0) && (dy == 0))
+        break;
+
+      if (horizontal) x += (dx > 0) ? 1 : -1;
+      else            y += (dy > 0) ? 1 : -1;
+    }
+
+    construction.square_count = (uint32_t)squares.size() - construction.first_square;
+    constructions.push_back(construction);
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Trace the rivers from random mountain tiles, always going to the lowest
+// neighbour, until they reach the sea or another river. The flow grows with
+// the rainfall of each tile crossed
+//----------------------------------------------------------------------------//
+void WorldGenerator::trace_rivers(SnapshotRegionMapEntry* region_map,
+                                  int32_t* river_flow,
+                                  std::vector<uint8_t>& river_sides
+                                  )
+{
+  int    world_width  = _options.world_width;
+  int    world_height = _options.world_height;
+  size_t world_tiles  = (size_t)world_width * world_height;
+
+  for (size_t i = 0; i < world_tiles; ++i)
+    river_flow[i] = -1;
+
+  static const int          dx[4]   = { 0, 0, -1, 1 };
+  static const int          dy[4]   = { -1, 1, 0, 0 };
+  static const unsigned int side[4] = { RIVER_SIDE_N, RIVER_SIDE_S, RIVER_SIDE_W, RIVER_SIDE_E };
+  static const unsigned int back[4] = { RIVER_SIDE_S, RIVER_SIDE_N, RIVER_SIDE_E, RIVER_SIDE_W };
+
+  WorldRandom random(_options.seed, SALT_RIVERS);
+  size_t num_sources = world_tiles / 64;
+  int    max_length  = 4 * (world_width + world_height);
+
+  // River that crosses each world tile, to tell joins from loops
+  std::vector<uint32_t> river_id(world_tiles, 0);
+
+  for (size_t s = 0; s < num_sources; ++s)
+  {
+    int x = random.below(world_width);
+    int y = random.below(world_height);
+    if (region_map[(size_t)y * world_width + x].elevation < 150)
+      continue;
+
+    uint32_t id   = (uint32_t)s + 1;
+    int      flow = 0;
+    for (int length = 0; length < max_length; ++length)
+    {
+      size_t index = (size_t)y * world_width + x;
+      SnapshotRegionMapEntry& rme = region_map[index];
+
+      // Joined another river
+      if (river_id[index] != 0)
+        break;
+
+      flow += 500 + rme.rainfall * 40;
+      river_flow[index] = flow;
+      river_id[index]   = id;
+      rme.flags |= REGION_FLAG_HAS_RIVER;
+
+      // Lowest neighbour not crossed yet by this river. In a pit the river
+      // climbs over the lowest border, as if it filled a small lake
+      int next   = -1;
+      int lowest = 0;
+      for (int d = 0; d < 4; ++d)
+      {
+        int nx = x + dx[d];
+        int ny = y + dy[d];
+        if ((nx < 0) || (ny < 0) || (nx >= world_width) || (ny >= world_height))
+          continue;
+
+        size_t neighbour = (size_t)ny * world_width + nx;
+        int    e         = region_map[neighbour].elevation;
+        if ((river_id[neighbour] != id) && ((next == -1) || (e < lowest)))
+        {
+          lowest = e;
+          next   = d;
+        }
+      }
+      if (next == -1)
+        break; // surrounded by itself
+
+      river_sides[index] |= side[next];
+      x += dx[next];
+      y += dy[next];
+
+      // Reached the sea
+      index = (size_t)y * world_width + x;
+      if (region_map[index].elevation < 100)
+        break;
+
+      river_sides[index] |= back[next];
+    }
+  }
+
+  // Rivers start as brooks
+  for (size_t i = 0; i < world_tiles; ++i)
+    if ((river_flow[i] != -1) && (river_flow[i] < BROOK_MAX_FLOW))
+      region_map[i].flags |= REGION_FLAG_IS_BROOK;
+}
+
+//----------------------------------------------------------------------------//
+// Fill the region map entry of a world tile from the fields sampled at its
+// center
+//----------------------------------------------------------------------------//
+void WorldGenerator::fill_region_map_entry(int x,                     // world coordinate x
+                                           int y,                     // world coordinate y
+                                           SnapshotRegionMapEntry& rme
+                                           ) const
+{
+  int ex = x * 16 + 8;
+  int ey = y * 16 + 8;
+
+  memset(&rme, 0, sizeof(rme));
+  rme.elevation = (int16_t)elevation(ex, ey);
+
+  // Colder near the poles and in the mountains
+  double latitude = fabs(2.0 * ey / (_options.world_height * 16.0) - 1.0);
+  int temperature = (int)(90 - latitude * 120) - std::max(0, rme.elevation - 150) / 3 + field(ex, ey, 512, SALT_TEMPERATURE) / 5 - 10;
+
+  rme.temperature = (int16_t)clamp_value(temperature, -50, 110);
+  rme.rainfall    = (int16_t)field(ex, ey, 512, SALT_RAINFALL);
+  rme.drainage    = (int16_t)field(ex, ey, 256, SALT_DRAINAGE);
+  rme.savagery    = (int16_t)field(ex, ey, 512, SALT_SAVAGERY);
+  rme.volcanism   = (int16_t)field(ex, ey, 256, SALT_VOLCANISM);
+  rme.evilness    = (int16_t)field(ex, ey, 512, SALT_EVILNESS);
+
+  // Plants need water and warmth
+  int vegetation  = rme.temperature > 0 ? rme.rainfall : rme.rainfall / 3;
+  rme.vegetation  = (int16_t)clamp_value(vegetation, 0, 100);
+
+  // The sea is salty, and so is the land near it
+  rme.salinity    = (int16_t)(rme.elevation < 100 ? 100 : clamp_value(field(ex, ey, 256, SALT_SALINITY) - (rme.elevation - 100), 0, 100));
+
+  rme.flags_size  = 2;
+  rme.biome_type  = (int16_t)biome_type(rme);
+  rme.region_id   = region_id(x, y, rme.biome_type);
+  rme.geo_index   = (int16_t)(rme.region_id & 0x7fff);
+}
+
+//----------------------------------------------------------------------------//
+// Fill the region details of a world tile. The 17x17 grid is sampled from the
+// same fields, so it matches the neighbour tiles at the borders
+//----------------------------------------------------------------------------//
+void WorldGenerator::fill_region_details(int x,                       // world coordinate x
+                                         int y,                       // world coordinate y
+                                         const SnapshotRegionMapEntry& rme,
+                                         unsigned int river_sides,    // RIVER_SIDE bits
+                                         SnapshotRegionDetails& rd
+                                         ) const
+{
+  memset(&rd, 0, sizeof(rd));
+  rd.pos_x = (int16_t)x;
+  rd.pos_y = (int16_t)y;
+
+  for (int i = 0; i < 17; ++i)
+    for (int j = 0; j < 17; ++j)
+    {
+      int ex = x * 16 + i;
+      int ey = y * 16 + j;
+      rd.elevation[i][j] = (int16_t)elevation(ex, ey);
+
+      // Near the borders the biome comes from the neighbour world tile.
+      // The width of the border changes with the position
+      int border = field(ex, ey, 8, SALT_BIOME_BORDER) / 20;
+      int delta_x = (i < border) ? -1 : ((i > 16 - border) ? 1 : 0);
+      int delta_y = (j < border) ? -1 : ((j > 16 - border) ? 1 : 0);
+
+      // Same numbering than the keypad: 7 8 9 / 4 5 6 / 1 2 3
+      rd.biome[i][j] = (int8_t)(5 + delta_x - 3 * delta_y);
+    }
+
+  for (int i = 0; i < 16; ++i)
+    for (int j = 0; j < 17; ++j)
+    {
+      rd.rivers_vertical_x_min[i][j]       = -30000;
+      rd.rivers_vertical_elevation[i][j]   = -30000;
+      rd.rivers_horizontal_y_min[j][i]     = -30000;
+      rd.rivers_horizontal_elevation[j][i] = -30000;
+    }
+
+  // Rivers go from the middle of the tile to the middle of each crossed side
+  int16_t river_elevation = (int16_t)std::max(rme.elevation - 1, 99);
+
+  for (int k = 0; k <= 16; ++k)
+  {
+    bool first_half  = k <= 8;
+    bool second_half = k >= 8;
+
+    if (((river_sides & RIVER_SIDE_N) && first_half) || ((river_sides & RIVER_SIDE_S) && second_half))
+    {
+      rd.rivers_vertical_x_min[8][k]     = (int16_t)(x * 16 + 8);
+      rd.rivers_vertical_elevation[8][k] = river_elevation;
+    }
+
+    if (((river_sides & RIVER_SIDE_W) && first_half) || ((river_sides & RIVER_SIDE_E) && second_half))
+    {
+      rd.rivers_horizontal_y_min[k][8]     = (int16_t)(y * 16 + 8);
+      rd.rivers_horizontal_elevation[k][8] = river_elevation;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Elevation of an embark tile. Below 100 is sea, 150 and above are mountains
+//----------------------------------------------------------------------------//
+int WorldGenerator::elevation(int ex, // embark coordinate x
+                              int ey  // embark coordinate y
+                              ) const
+{
+  double n = fractal_noise(ex, ey, 1024, SALT_ELEVATION);
+
+  // Half sea, half land, and the peaks of the highlands are steeper
+  double e = 100 + (n - 0.5) * 240;
+  if (e > 130)
+    e += (e - 130) * 2;
+
+  return clamp_value((int)e, 0, 400);
+}
+
+//----------------------------------------------------------------------------//
+// A field in 0..100
+//----------------------------------------------------------------------------//
+int WorldGenerator::field(int ex,        // embark coordinate x
+                          int ey,        // embark coordinate y
+                          int scale,     // size in embark tiles of the biggest features
+                          uint32_t salt  // field
+                          ) const
+{
+  double n = fractal_noise(ex, ey, scale, salt);
+  return clamp_value((int)((n - 0.5) * 250 + 50), 0, 100);
+}
+
+//----------------------------------------------------------------------------//
+// Sum of three octaves of value noise, in 0..1
+//----------------------------------------------------------------------------//
+double WorldGenerator::fractal_noise(int ex,        // embark coordinate x
+                                     int ey,        // embark coordinate y
+                                     int scale,     // size in embark tiles of the biggest features
+                                     uint32_t salt  // field
+                                     ) const
+{
+  double sum       = 0.0;
+  double amplitude = 1.0;
+  double total     = 0.0;
+
+  for (int octave = 0; (octave < 3) && (scale > 0); ++octave)
+  {
+    sum       += amplitude * value_noise((double)ex / scale, (double)ey / scale, _options.seed ^ (salt << 8) ^ octave);
+    total     += amplitude;
+    amplitude *= 0.5;
+    scale     /= 4;
+  }
+
+  return sum / total;
+}
+
+//----------------------------------------------------------------------------//
+// Region of a world tile: the nearest region seed, preferring the ones with
+// the same kind of terrain
+//----------------------------------------------------------------------------//
+int WorldGenerator::region_id(int x,         // world coordinate x
+                              int y,         // world coordinate y
+                              int biome_type // biome of the world tile
+                              ) const
+{
+  int cell_x = x / REGION_CELL_SIZE;
+  int cell_y = y / REGION_CELL_SIZE;
+  int type   = region_type(biome_type);
+
+  int best_id       = cell_y * _region_cols + cell_x;
+  int best_distance = -1;
+
+  for (int cy = std::max(cell_y - 1, 0); cy <= std::min(cell_y + 1, _region_rows - 1); ++cy)
+    for (int cx = std::max(cell_x - 1, 0); cx <= std::min(cell_x + 1, _region_cols - 1); ++cx)
+    {
+      int id = cy * _region_cols + cx;
+      const RegionSeed& seed = _region_seeds[id];
+
+      int distance = (seed.x - x) * (seed.x - x) + (seed.y - y) * (seed.y - y);
+      if (region_type(seed.biome_type) != type)
+        distance += 4 * REGION_CELL_SIZE * REGION_CELL_SIZE;
+
+      if ((best_distance == -1) || (distance < best_distance))
+      {
+        best_distance = distance;
+        best_id       = id;
+      }
+    }
+
+  return best_id;
+}
+
+//----------------------------------------------------------------------------//
+// Biome type of a world tile, a simplified version of the DF rules used by
+// get_biome_type
+//----------------------------------------------------------------------------//
+int WorldGenerator::biome_type(const SnapshotRegionMapEntry& rme // region map data
+                               ) const
+{
+  bool tropical = rme.temperature >= 75;
+
+  if (rme.elevation >= 150)
+    return 0;                                          // MOUNTAIN
+
+  if (rme.elevation < 100)
+  {
+    if (rme.temperature <= -5) return 29;              // OCEAN_ARCTIC
+    return tropical ? 27 : 28;                         // OCEAN_TROPICAL, OCEAN_TEMPERATE
+  }
+
+  if (rme.temperature <= -5)
+    return rme.drainage < 75 ? 2 : 1;                  // TUNDRA, GLACIER
+
+  if (rme.vegetation < 33)
+  {
+    if (rme.vegetation < 10)
+    {
+      if (rme.drainage < 33) return 26;                // DESERT_SAND
+      if (rme.drainage < 66) return 25;                // DESERT_ROCK
+      return 24;                                       // DESERT_BADLAND
+    }
+    if (rme.vegetation < 20)
+      return tropical ? 21 : 18;                       // GRASSLAND
+    return tropical ? 22 : 19;                         // SAVANNA
+  }
+
+  if (rme.vegetation < 66)
+  {
+    if (rme.drainage < 33)
+      return tropical ? (rme.salinity >= 66 ? 11 : 10) // MARSH_TROPICAL
+                      : (rme.salinity >= 66 ? 6  : 5); // MARSH_TEMPERATE
+    return tropical ? 23 : 20;                         // SHRUBLAND
+  }
+
+  if (rme.drainage < 33)
+  {
+    if (tropical)
+      return rme.salinity >= 66 ? 8 : 7;               // SWAMP_TROPICAL
+    return rme.salinity >= 66 ? 4 : 3;                 // SWAMP_TEMPERATE
+  }
+
+  if (rme.temperature < 10)
+    return 12;                                         // FOREST_TAIGA
+  if (tropical)
+    return rme.rainfall >= 80 ? 17 : 16;               // FOREST_TROPICAL_MOIST/DRY_BROADLEAF
+  return rme.drainage >= 66 ? 13 : 14;                 // FOREST_TEMPERATE_CONIFER/BROADLEAF
+}
+
+//----------------------------------------------------------------------------//
+// World region type (as drawn by the region map) of a biome type
+//----------------------------------------------------------------------------//
+int WorldGenerator::region_type(int biome_type) const
+{
+  switch (biome_type)
+  {
+    case 0:                    return 3; // Mountains
+    case 1:                    return 6; // Glacier
+    case 2:                    return 7; // Tundra
+    case 15: case 16: case 17: return 2; // Jungle
+    case 24: case 25: case 26: return 1; // Desert
+    case 27: case 28: case 29: return 4; // Ocean
+    case 12: case 13: case 14: return 9; // Hills
+    default:                   break;
+  }
+
+  if ((biome_type >= 3) && (biome_type <= 11))
+    return 0;                            // Swamp
+
+  return 8;                              // Steppe
+}
@@ -0,0 +1,272 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <string.h>
+
+#include "../include/WorldSnapshot.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ File layout constants
+*****************************************************************************/
+static const size_t SECTION_ALIGNMENT = 4096; // Sections start at page boundaries
+
+/*****************************************************************************
+ Local functions
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Round up a file offset to the section alignment
+//----------------------------------------------------------------------------//
+static uint64_t align_offset(uint64_t offset)
+{
+  return (offset + SECTION_ALIGNMENT - 1) & ~(uint64_t)(SECTION_ALIGNMENT - 1);
+}
+
+//----------------------------------------------------------------------------//
+// Size of the records stored in each section. A section with a different
+// record size was written by an incompatible version
+//----------------------------------------------------------------------------//
+static size_t record_size_of(uint32_t id)
+{
+  switch (id)
+  {
+    case SECTION_REGION_MAP:           return sizeof(SnapshotRegionMapEntry);
+    case SECTION_REGIONS:              return sizeof(SnapshotRegion);
+    case SECTION_REGION_DETAILS:       return sizeof(SnapshotRegionDetails);
+    case SECTION_SITES:                return sizeof(SnapshotSite);
+    case SECTION_ENTITIES:             return sizeof(SnapshotEntity);
+    case SECTION_ENTITY_SITE_LINKS:    return sizeof(SnapshotEntitySiteLink);
+    case SECTION_CONSTRUCTIONS:        return sizeof(SnapshotConstruction);
+    case SECTION_CONSTRUCTION_SQUARES: return sizeof(SnapshotConstructionSquare);
+    case SECTION_CONSTRUCTION_POINTS:  return sizeof(SnapshotConstructionPoint);
+    case SECTION_WORLD_INFO:           return sizeof(SnapshotWorldInfo);
+    case SECTION_RIVER_FLOW:           return sizeof(int32_t);
+    default:                           return 0;
+  }
+}
+
+/*****************************************************************************
+ WorldSnapshot methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Constructor
+//----------------------------------------------------------------------------//
+WorldSnapshot::WorldSnapshot()
+  : _header(nullptr),
+    _region_map(nullptr),
+    _region_details(nullptr)
+{
+}
+
+//----------------------------------------------------------------------------//
+// Map the file and validate it before giving access to any record
+//----------------------------------------------------------------------------//
+bool WorldSnapshot::open(const std::string& filename // snapshot file
+                         )
+{
+  this->close();
+
+  if (!_file.open_read(filename))
+    return false;
+
+  const SnapshotHeader* header = (const SnapshotHeader*)_file.data();
+
+  if ((_file.size() < sizeof(SnapshotHeader))                          ||
+      (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) ||
+      (header->version            != SNAPSHOT_VERSION)                 ||
+      (header->header_size        != sizeof(SnapshotHeader))           ||
+      (header->section_entry_size != sizeof(SnapshotSection))          ||
+      (header->header_size + (uint64_t)header->section_count * sizeof(SnapshotSection) > _file.size())
+     )
+  {
+    this->close();
+    return false;
+  }
+
+  // Every known section must have the expected record size and fit in the file
+  const SnapshotSection* sections = (const SnapshotSection*)(_file.data() + header->header_size);
+  for (uint32_t i = 0; i < header->section_count; ++i)
+  {
+    size_t expected = record_size_of(sections[i].id);
+    if (expected == 0)
+      continue; // Sections added by newer versions are ignored
+
+    if ((sections[i].record_size != expected) ||
+        (sections[i].offset + sections[i].record_count * sections[i].record_size > _file.size()))
+    {
+      this->close();
+      return false;
+    }
+  }
+
+  _header = header;
+
+  // The per world tile sections are mandatory
+  size_t count = 0;
+  size_t world_tiles = (size_t)header->world_width * header->world_height;
+
+  _region_map = (const SnapshotRegionMapEntry*)section(SECTION_REGION_MAP, count);
+  if ((_region_map == nullptr) || (count != world_tiles))
+  {
+    this->close();
+    return false;
+  }
+
+  _region_details = (const SnapshotRegionDetails*)section(SECTION_REGION_DETAILS, count);
+  if ((_region_details == nullptr) || (count != world_tiles))
+  {
+    this->close();
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Unmap the file
+//----------------------------------------------------------------------------//
+void WorldSnapshot::close()
+{
+  _file.close();
+  _header         = nullptr;
+  _region_map     = nullptr;
+  _region_details = nullptr;
+}
+
+//----------------------------------------------------------------------------//
+// Find an entry in the section table
+//----------------------------------------------------------------------------//
+const SnapshotSection* WorldSnapshot::find_section(SnapshotSectionId id // section to find
+                                                   ) const
+{
+  if (_header == nullptr)
+    return nullptr;
+
+  const SnapshotSection* sections = (const SnapshotSection*)(_file.data() + _header->header_size);
+  for (uint32_t i = 0; i < _header->section_count; ++i)
+    if (sections[i].id == id)
+      return &sections[i];
+
+  return nullptr;
+}
+
+//----------------------------------------------------------------------------//
+// Return the records of a section
+//----------------------------------------------------------------------------//
+const void* WorldSnapshot::section(SnapshotSectionId id, // section to find
+                                   size_t& count         // number of records
+                                   ) const
+{
+  count = 0;
+
+  const SnapshotSection* entry = find_section(id);
+  if (entry == nullptr)
+    return nullptr;
+
+  count = (size_t)entry->record_count;
+  return _file.data() + entry->offset;
+}
+
+/*****************************************************************************
+ WorldSnapshotWriter methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Declare a section. Its offset is assigned when the file is created
+//----------------------------------------------------------------------------//
+void WorldSnapshotWriter::add_section(SnapshotSectionId id, // section id
+                                      size_t record_size,   // size of each record
+                                      size_t record_count   // number of records
+                                      )
+{
+  SnapshotSection section;
+  memset(&section, 0, sizeof(section));
+  section.id           = id;
+  section.record_size  = (uint32_t)record_size;
+  section.record_count = record_count;
+  _sections.push_back(section);
+}
+
+//----------------------------------------------------------------------------//
+// Lay out the sections, create the file and write the header and the
+// section table
+//----------------------------------------------------------------------------//
+bool WorldSnapshotWriter::create(const std::string& filename, // snapshot file
+                                 int world_width,             // world width in world coordinates
+                                 int world_height             // world height in world coordinates
+                                 )
+{
+  uint64_t offset = sizeof(SnapshotHeader) + _sections.size() * sizeof(SnapshotSection);
+  for (size_t i = 0; i < _sections.size(); ++i)
+  {
+    _sections[i].offset = align_offset(offset);
+    offset = _sections[i].offset + _sections[i].record_count * _sections[i].record_size;
+  }
+
+  if (!_file.open(filename, (size_t)offset))
+    return false;
+
+  // The mapped file is filled with zeros, so only the used fields are set
+  SnapshotHeader* header = (SnapshotHeader*)_file.data();
+  memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header->version            = SNAPSHOT_VERSION;
+  header->header_size        = sizeof(SnapshotHeader);
+  header->world_width        = world_width;
+  header->world_height       = world_height;
+  header->section_count      = (uint32_t)_sections.size();
+  header->section_entry_size = sizeof(SnapshotSection);
+
+  if (!_sections.empty())
+    memcpy(_file.data() + sizeof(SnapshotHeader),
+           &_sections[0],
+           _sections.size() * sizeof(SnapshotSection)
+           );
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Return the first record of a section
+//----------------------------------------------------------------------------//
+void* WorldSnapshotWriter::records(SnapshotSectionId id // section id
+                                   )
+{
+  if (!_file.is_open())
+    return nullptr;
+
+  for (size_t i = 0; i < _sections.size(); ++i)
+    if (_sections[i].id == id)
+      return _file.data() + _sections[i].offset;
+
+  return nullptr;
+}
+
+//----------------------------------------------------------------------------//
+// Unmap the file
+//----------------------------------------------------------------------------//
+void WorldSnapshotWriter::close(bool remove)
+{
+  _file.close(remove);
+  _sections.clear();
+}
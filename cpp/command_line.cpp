@@ -0,0 +1,427 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <algorithm>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "../include/MapTypes.h"
+#include "../include/ExportOptions.h"
+
+using namespace exportmaps_plugin;
+
+//----------------------------------------------------------------------------//
+// Return true if the argument is a non negative integer
+//----------------------------------------------------------------------------//
+static bool is_number(const std::string& argument)
+{
+  if (argument.empty())
+    return false;
+
+  for (size_t i = 0; i < argument.size(); ++i)
+    if (!isdigit((unsigned char)argument[i]))
+      return false;
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Process the command line arguments
+// returns a tuple, where
+// tuple.first is a uint bit each bit meaning a graphical map type to be generated
+// tuple.second is a uint bit each bit meaning a raw map type to be generated
+// tuple.third is a vector with index to wrong arguments
+// export_options receives the options that change how the maps are exported
+//----------------------------------------------------------------------------//
+std::tuple<unsigned int, unsigned int, unsigned int, std::vector<int> >
+process_command_line(std::vector <std::string>& options,
+                     ExportOptions& export_options)
+{
+  unsigned int     maps_to_generate     = 0; // Graphical maps to generate
+  unsigned int     maps_to_generate_raw = 0; // Raw maps to generate
+  unsigned int     maps_to_generate_hm  = 0; // Heightmaps to generate
+  std::vector<int> errors(options.size());   // Vector with index to wrong command line options
+
+  // Iterate over all the command line options received
+  for ( unsigned int argv_iterator = 0; argv_iterator < options.size(); ++argv_iterator)
+  {
+    // Get a command line option
+    std::string option = options[argv_iterator];
+
+    // Convert to lowercase
+    std::transform(option.begin(), option.end(), option.begin(), ::tolower);
+
+    // No error in argument until now
+    errors[argv_iterator] = -1;
+
+    // Check command line
+    if (option == "-all-df")                                       // All DF maps
+    {
+		maps_to_generate = -1; continue;
+	}
+
+    if (option == "-all-raw")                                 // All raws maps
+    {
+		maps_to_generate_raw = -1; continue;
+	}
+
+    if (option == "-all-hm")                                  // All raws maps
+    {
+		maps_to_generate_hm = -1; continue;
+	}
+
+    if (option == "-temperature")                                  // map DF style
+    {
+		maps_to_generate |= MapType::TEMPERATURE; continue;
+	}
+
+    if (option == "-rainfall")                                // map DF style
+    {
+		maps_to_generate |= MapType::RAINFALL; continue;
+	}
+
+    if (option == "-region")                                  // map DF style
+    {
+		maps_to_generate |= MapType::REGION; continue;
+	}
+
+    if (option == "-drainage")                                // map DF style
+    {
+		maps_to_generate |= MapType::DRAINAGE; continue;
+	}
+
+    if (option == "-savagery")                                // map DF style
+    {
+		maps_to_generate |= MapType::SAVAGERY; continue;
+	}
+
+    if (option == "-volcanism")                               // map DF style
+    {
+		maps_to_generate |= MapType::VOLCANISM; continue;
+	}
+
+    if (option == "-vegetation")                              // map DF style
+    {
+		maps_to_generate |= MapType::VEGETATION; continue;
+	}
+
+    if (option == "-evilness")                                // map DF style
+    {
+		maps_to_generate |= MapType::EVILNESS; continue;
+	}
+
+    if (option == "-salinity")                                // map DF style
+    {
+		maps_to_generate |= MapType::SALINITY; continue;
+	}
+
+    if (option == "-hydrosphere")                             // map DF style
+    {
+		maps_to_generate |= MapType::HYDROSPHERE; continue;
+	}
+
+    if (option == "-elevation")                               // map DF style
+    {
+		maps_to_generate |= MapType::ELEVATION; continue;
+	}
+
+    if (option == "-elevation-water")                         // map DF style
+    {
+		maps_to_generate |= MapType::ELEVATION_WATER; continue;
+	}
+
+    if (option == "-biome")                                   // map DF style
+    {
+		maps_to_generate |= MapType::BIOME; continue;
+	}
+
+    if (option == "-trading")                                 // map DF style
+    {
+		maps_to_generate |= MapType::TRADING; continue;
+	}
+
+    if (option == "-nobility")                                // map DF style
+     {
+		 maps_to_generate |= MapType::NOBILITY; continue;
+	}
+
+    if (option == "-diplomacy")                               // map DF style
+    {
+		 maps_to_generate |= MapType::DIPLOMACY; continue;
+	}
+
+    if (option == "-sites")                                   // map DF style
+    {
+#ifndef _DARWIN
+		maps_to_generate |= MapType::SITES; 
+#endif
+	
+		continue;
+	}
+
+
+    // Raw maps
+
+    if (option == "-temperature-raw")                         // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::TEMPERATURE_RAW; continue;
+	}
+
+    if (option == "-rainfall-raw")                            // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::RAINFALL_RAW; continue;
+	}
+
+    if (option == "-drainage-raw")                            // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::DRAINAGE_RAW; continue;
+	}
+
+    if (option == "-savagery-raw")                            // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::SAVAGERY_RAW; continue;
+	}
+
+    if (option == "-volcanism-raw")                           // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::VOLCANISM_RAW; continue;
+	}
+
+    if (option == "-vegetation-raw")                          // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::VEGETATION_RAW; continue;
+	}
+
+    if (option == "-evilness-raw")                            // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::EVILNESS_RAW; continue;
+	}
+
+    if (option == "-salinity-raw")                            // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::SALINITY_RAW; continue;
+	}
+
+    if (option == "-hydrosphere-raw")                         // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::HYDROSPHERE_RAW; continue;
+	}
+
+    if (option == "-elevation-raw")                           // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::ELEVATION_RAW; continue;
+	}
+
+    if (option == "-elevation-water-raw")                     // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::ELEVATION_WATER_RAW; continue;
+	}
+
+    if (option == "-biome-raw")                               // map raw data file
+    {
+      maps_to_generate_raw |= MapTypeRaw::BIOME_TYPE_RAW;
+      maps_to_generate_raw |= MapTypeRaw::BIOME_REGION_RAW; 
+	  continue;
+    }
+
+    if (option == "-trading-raw")                             // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::TRADING_RAW; continue;
+	}
+
+    if (option == "-nobility-raw")                            // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::NOBILITY_RAW; continue;
+	}
+
+    if (option == "-diplomacy-raw")                           // map raw data file
+    {
+		maps_to_generate_raw |= MapTypeRaw::DIPLOMACY_RAW; continue;
+	}
+
+    if (option == "-sites-raw")                               // map raw data file
+    {
+#ifndef _DARWIN
+		maps_to_generate_raw |= MapTypeRaw::SITES_RAW; continue;
+#endif
+	}
+
+    // Heightmaps
+
+    if (option == "-elevation-hm")                            // Heighmap style
+    {
+		maps_to_generate_hm |= MapTypeHeightMap::ELEVATION_HM; continue;
+	}
+
+    if (option == "-elevation-water-hm")                      // Heightmap style
+    {
+		maps_to_generate_hm |= MapTypeHeightMap::ELEVATION_WATER_HM; continue;
+	}
+
+    // Export options
+
+    if (option == "-raw-container")                           // All raw maps in a single file
+    {
+      export_options.raw_container = true; continue;
+    }
+
+    if (option == "-raw-container-zlib")                      // Same, compressing the layers
+    {
+      export_options.raw_container      = true;
+      export_options.raw_container_zlib = true;
+      continue;
+    }
+
+    if (option == "-tiles")                                   // Graphical maps as tile pyramids
+    {
+      export_options.tiles = true; continue;
+    }
+
+    if (option == "-snapshot")                                // World data snapshot, followed by a file name
+    {
+      if (argv_iterator + 1 < options.size())
+      {
+        export_options.snapshot_file = options[++argv_iterator]; // Keep the original case
+        errors[argv_iterator] = -1;
+        continue;
+      }
+    }
+
+    if (option == "-mem-budget")                              // Memory budget in MB, followed by a number
+    {
+      if (argv_iterator + 1 < options.size())
+      {
+        int budget = atoi(options[argv_iterator + 1].c_str());
+        if (budget > 0)
+        {
+          export_options.mem_budget_mb = budget;
+          errors[++argv_iterator] = -1;
+          continue;
+        }
+      }
+    }
+
+    if (option == "-rect")                                    // Rectangle of the world, followed by x0 y0 x1 y1
+    {
+      if ((argv_iterator + 4 < options.size()) &&
+          is_number(options[argv_iterator + 1]) &&
+          is_number(options[argv_iterator + 2]) &&
+          is_number(options[argv_iterator + 3]) &&
+          is_number(options[argv_iterator + 4]))
+      {
+        export_options.rect    = true;
+        export_options.rect_x0 = atoi(options[argv_iterator + 1].c_str());
+        export_options.rect_y0 = atoi(options[argv_iterator + 2].c_str());
+        export_options.rect_x1 = atoi(options[argv_iterator + 3].c_str());
+        export_options.rect_y1 = atoi(options[argv_iterator + 4].c_str());
+        for (int i = 0; i < 4; ++i)
+          errors[++argv_iterator] = -1;
+        continue;
+      }
+    }
+
+    if (option == "-rect-embark")                             // Rectangle around the embark, followed by its radius
+    {
+      if ((argv_iterator + 1 < options.size()) &&
+          is_number(options[argv_iterator + 1]))
+      {
+        export_options.rect_embark_radius = atoi(options[argv_iterator + 1].c_str());
+        errors[++argv_iterator] = -1;
+        continue;
+      }
+    }
+
+    if (option == "-preview")                                 // Maps at one pixel per world tile
+    {
+      export_options.preview = true;
+      continue;
+    }
+
+    if (option == "-incremental")                             // Only what changed since the previous export
+    {
+      export_options.incremental = true;
+      continue;
+    }
+
+    if (option == "-region-cache")                            // Region details kept between exports
+    {
+      export_options.region_cache = true;
+      continue;
+    }
+
+    if (option == "-background")                              // Render the maps while the game runs
+    {
+      export_options.background = true;
+      continue;
+    }
+
+    if (option == "-tiles-per-frame")                         // Background export, followed by the tiles per frame
+    {
+      if ((argv_iterator + 1 < options.size()) &&
+          is_number(options[argv_iterator + 1]))
+      {
+        int tiles = atoi(options[argv_iterator + 1].c_str());
+        if (tiles > 0)
+        {
+          export_options.tiles_per_frame = tiles;
+          errors[++argv_iterator] = -1;
+          continue;
+        }
+      }
+    }
+
+    if (option == "-status")                                  // State of the background export
+    {
+      export_options.status = true;
+      continue;
+    }
+
+    if (option == "-release-buffers")                         // Free the buffers kept between exports
+    {
+      export_options.release_buffers = true;
+      continue;
+    }
+
+    if (option == "-trace")                                   // Chrome trace of the export, followed by a file name
+    {
+      if (argv_iterator + 1 < options.size())
+      {
+        export_options.trace_file = options[++argv_iterator]; // Keep the original case
+        errors[argv_iterator] = -1;
+        continue;
+      }
+    }
+
+    // ERROR - unknown argument
+      errors[argv_iterator] = argv_iterator;
+  }
+  return std::tuple<unsigned int,
+                    unsigned int,
+                    unsigned int,
+                    std::vector<int>
+                   >(maps_to_generate,
+                     maps_to_generate_raw,
+                     maps_to_generate_hm,
+                     errors
+                     );
+}
@@ -21,20 +21,12 @@
 
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
 
 using namespace exportmaps_plugin;
 
 /*****************************************************************************
 External functions
 *****************************************************************************/
-extern int                get_biome_type(int world_coord_x,
-                                         int world_coord_y
-                                         );
-
 extern std::pair<int,int> adjust_coordinates_to_region(int x,
                                                        int y,
                                                        int delta,
@@ -63,12 +55,11 @@ void consumer_biome(void* arg)
 
   if (arg != nullptr)
   {
-    // The map where we will write to
-    ExportedMapBase* biome_map = maps_exporter->get_biome_map();
+    Tracer::set_thread_name("biome consumer");
 
     while(!finish)
     {
-      if (maps_exporter->is_biome_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_BIOME))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -88,16 +79,25 @@ void consumer_biome(void* arg)
 //----------------------------------------------------------------------------//
 bool biome_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("biome");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_BIOME));
+
   // Get the data from the queue
-  RegionDetailsBiome rdb = maps_exporter->pop_biome();
+  RegionDetailsBiome rdb = maps_exporter->pop<MAP_BIOME>();
 
   // Check if is the marker for no more data from the producer
   if (rdb.is_end_marker())
+  {
     // All the data has been processed. Done
+    work_timer.set_end_marker();
     return true;
+  }
 
   // Get the data where we'll write to
-  ExportedMapBase* map = maps_exporter->get_biome_map();
+  ExportedMapBase* map = maps_exporter->get_map<MAP_BIOME>();
+
+  // World data to read from
+  WorldData* world_data = maps_exporter->get_world_data();
 
   // There's data to be processed
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
@@ -112,14 +112,14 @@ bool biome_do_work(MapsExporter* maps_exporter)
                                                                                   rdb.get_biome_index(x,y),
                                                                                   rdb.get_pos_x(),
                                                                                   rdb.get_pos_y(),
-                                                                                  df::global::world->world_data->world_width,
-                                                                                  df::global::world->world_data->world_height
+                                                                                  world_data->world_width(),
+                                                                                  world_data->world_height()
                                                                                   );
 
       // Get the biome type for this world position
-      int biome_type = get_biome_type(adjusted_tile_coordinates.first,
-                                      adjusted_tile_coordinates.second
-                                      );
+      int biome_type = world_data->biome_type(adjusted_tile_coordinates.first,
+                                              adjusted_tile_coordinates.second
+                                              );
 
       // Get the RGB values associated to this biome type
       RGB_color rgb_pixel_color = RGB_from_biome_type(biome_type);
@@ -20,6 +20,7 @@
 // https://github.com/ragundo/exportmaps
 
 #include "../../../include/Mac_compat.h"
+#include "../../../include/dfhack.h"
 #include "../../../include/ExportMaps.h"
 #include "../../../include/util/ofsub.h"
 #include <df/region_map_entry.h>
@@ -204,9 +205,11 @@ void consumer_diplomacy(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("diplomacy consumer");
+
     while (!finish)
     {
-      if (maps_exporter->is_diplomacy_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_DIPLOMACY))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -229,16 +232,21 @@ void consumer_diplomacy(void* arg)
 *****************************************************************************/
 bool diplomacy_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("diplomacy");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_DIPLOMACY));
+
   // Get the data from the queue
-  RegionDetailsElevationWater rdew = maps_exporter->pop_diplomacy();
+  RegionDetailsElevationWater rdew = maps_exporter->pop<MAP_DIPLOMACY>();
 
   // Get the map
-  ExportedMapDF* diplomacy_map = maps_exporter->get_diplomacy_map();
+  ExportedMapDF* diplomacy_map = maps_exporter->get_map<MAP_DIPLOMACY>();
 
   // Check if is the marker for no more data from the producer
   if (rdew.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the terrain data has been processed.
+    TraceSpan overlay_span("diplomacy overlay");
     process_world_structures(diplomacy_map);
 
     // Now draw world sites and relationships over this base map
@@ -268,7 +276,7 @@ bool diplomacy_do_work(MapsExporter* maps_exporter)
 void draw_diplomacy_map(MapsExporter* map_exporter)
 {
   // Draw rectangles over ALL sites
-  draw_nobility_diplomacy_sites(map_exporter->get_diplomacy_map());
+  draw_nobility_diplomacy_sites(map_exporter->get_map<MAP_DIPLOMACY>());
 
   // 1st pass
   diplomacy_1st_pass(map_exporter);
@@ -278,11 +286,11 @@ void draw_diplomacy_map(MapsExporter* map_exporter)
   diplomacy_3rd_pass(map_exporter);
 
   // Draw rectangles ONLY over each noble holdings
-  draw_nobility_holdings_sites(map_exporter->get_diplomacy_map());
+  draw_nobility_holdings_sites(map_exporter->get_map<MAP_DIPLOMACY>());
   //draw_capital_sites(map);
 
   // Map generated. Warn the main thread
-  map_exporter->set_percentage_diplomacy(-1);
+  map_exporter->set_percentage(MAP_DIPLOMACY, -1);
 
 }
 
@@ -292,7 +300,7 @@ void draw_diplomacy_map(MapsExporter* map_exporter)
 //----------------------------------------------------------------------------//
 void diplomacy_1st_pass(MapsExporter* map_exporter)
 {
-  ExportedMapBase* map = map_exporter->get_diplomacy_map();
+  ExportedMapBase* map = map_exporter->get_map<MAP_DIPLOMACY>();
   for (unsigned int i = 0; i < df::global::world->world_data->sites.size(); i++)
   {
     df::world_site* site1 = df::global::world->world_data->sites[i];
@@ -455,7 +463,7 @@ void diplomacy_1st_pass(MapsExporter* map_exporter)
     // Compute the % of map processing
     float a = i*100;
     float b = df::global::world->entities.all.size() + 2 * df::global::world->world_data->sites.size();
-    map_exporter->set_percentage_sites((int)(a/b));
+    map_exporter->set_percentage(MAP_DIPLOMACY, (int)(a/b));
   }
 
 }
@@ -466,7 +474,7 @@ void diplomacy_1st_pass(MapsExporter* map_exporter)
 //----------------------------------------------------------------------------//
 void diplomacy_2nd_pass(MapsExporter* map_exporter)
 {
-  ExportedMapBase* map = map_exporter->get_diplomacy_map();
+  ExportedMapBase* map = map_exporter->get_map<MAP_DIPLOMACY>();
 
   for (unsigned int i = 0; i < df::global::world->world_data->sites.size(); i++)
   {
@@ -636,7 +644,7 @@ void diplomacy_2nd_pass(MapsExporter* map_exporter)
     // Compute the % of map processing
     float a = (i + df::global::world->world_data->sites.size()) * 100;
     float b = df::global::world->entities.all.size() + 2 * df::global::world->world_data->sites.size();
-    map_exporter->set_percentage_sites((int)(a/b));
+    map_exporter->set_percentage(MAP_DIPLOMACY, (int)(a/b));
   }
 
 }
@@ -647,7 +655,7 @@ void diplomacy_2nd_pass(MapsExporter* map_exporter)
 //----------------------------------------------------------------------------//
 void diplomacy_3rd_pass(MapsExporter* map_exporter)
 {
-  ExportedMapBase* map = map_exporter->get_diplomacy_map();
+  ExportedMapBase* map = map_exporter->get_map<MAP_DIPLOMACY>();
 
   for (unsigned int p = 0; p < df::global::world->entities.all.size(); p++)
   {
@@ -834,7 +842,7 @@ int a,b;
     // Compute the % of map processing
     float a = (p + 2 * df::global::world->world_data->sites.size())*100;
     float b = df::global::world->entities.all.size() + 2 * df::global::world->world_data->sites.size();
-    map_exporter->set_percentage_diplomacy((int)a/b);
+    map_exporter->set_percentage(MAP_DIPLOMACY, (int)a/b);
   }
 }
 
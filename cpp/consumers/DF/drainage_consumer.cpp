@@ -21,10 +21,6 @@
 
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
 
 using namespace exportmaps_plugin;
 
@@ -62,9 +58,11 @@ void consumer_drainage(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("drainage consumer");
+
     while(!finish)
     {
-      if (maps_exporter->is_drainage_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_DRAINAGE))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -84,16 +82,23 @@ void consumer_drainage(void* arg)
 //----------------------------------------------------------------------------//
 bool drainage_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("drainage");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_DRAINAGE));
+
   // Get the data from the queue
-  RegionDetailsBiome rdg = maps_exporter->pop_drainage();
+  RegionDetailsBiome rdg = maps_exporter->pop<MAP_DRAINAGE>();
 
   // Check if is the marker for no more data from the producer
   if (rdg.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the data has been processed. Finish this thread execution
     return true;
   }
 
+  // World data to read from
+  WorldData* world_data = maps_exporter->get_world_data();
+
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
   for (auto x=0; x<16; ++x)
     for (auto y=0; y<16; ++y)
@@ -106,18 +111,18 @@ bool drainage_do_work(MapsExporter* maps_exporter)
                                                                                   rdg.get_biome_index(x,y),
                                                                                   rdg.get_pos_x(),
                                                                                   rdg.get_pos_y(),
-                                                                                  df::global::world->world_data->world_width,
-                                                                                  df::global::world->world_data->world_height
+                                                                                  world_data->world_width(),
+                                                                                  world_data->world_height()
                                                                                   );
 
-      df::region_map_entry& rme = df::global::world->world_data->region_map[adjusted_tile_coordinates.first]
-                                                                           [adjusted_tile_coordinates.second];
+      const SnapshotRegionMapEntry& rme = world_data->region_map(adjusted_tile_coordinates.first,
+                                                                 adjusted_tile_coordinates.second);
 
       // Get the RGB values associated to this drainage
       RGB_color rgb_pixel_color = RGB_from_drainage(rme.drainage);
 
       // Write pixels to the bitmap
-      ExportedMapBase* drainage_map = maps_exporter->get_drainage_map();
+      ExportedMapBase* drainage_map = maps_exporter->get_map<MAP_DRAINAGE>();
       drainage_map->write_world_pixel(rdg.get_pos_x(),
                                       rdg.get_pos_y(),
                                       x,
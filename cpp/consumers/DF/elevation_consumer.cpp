@@ -18,10 +18,6 @@
 
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
 
 // You can always find the latest version of this plugin in Github
 // https://github.com/ragundo/exportmaps
@@ -48,9 +44,11 @@ void consumer_elevation(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("elevation consumer");
+
     while(!finish)
     {
-      if (maps_exporter->is_elevation_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_ELEVATION))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -70,17 +68,21 @@ void consumer_elevation(void* arg)
 //----------------------------------------------------------------------------//
 bool elevation_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("elevation");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_ELEVATION));
+
   // Get the data from the queue
-  RegionDetailsElevation rde = maps_exporter->pop_elevation();
+  RegionDetailsElevation rde = maps_exporter->pop<MAP_ELEVATION>();
   // Check if is the marker for no more data from the producer
   if (rde.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the data has been processed. Finish this thread execution
     return true;
   }
 
   // Get the map where we'll write to
-  ExportedMapBase* elevation_map = maps_exporter->get_elevation_map();
+  ExportedMapBase* elevation_map = maps_exporter->get_map<MAP_ELEVATION>();
 
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
   for (auto x=0; x<16; ++x)
@@ -21,42 +21,16 @@
 
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
-#include <df/world_region.h>
 
 using namespace exportmaps_plugin;
 
-/*****************************************************************************
-External functions
-*****************************************************************************/
-extern int                get_biome_type(int world_coord_x,
-                                         int world_coord_y
-                                         );
-
-extern std::pair<int,int> adjust_coordinates_to_region(int x,
-                                                       int y,
-                                                       int delta,
-                                                       int pos_x,
-                                                       int pos_y,
-                                                       int world_width,
-                                                       int world_height
-                                                       );
-
 /*****************************************************************************
 Local functions forward declaration
 *****************************************************************************/
 bool      elevation_water_do_work(MapsExporter* maps_exporter);
 
-// Return the RGB values for the biome export map given a biome type
-RGB_color RGB_from_elevation_water(RegionDetailsElevationWater& rdew,
-                                   int x,
-                                   int y,
-                                   int biome_type,
-                                   df::world_region* region
-                                   );
+// Return the RGB values for the elevation respecting water of an embark tile
+RGB_color RGB_from_elevation_water(const WaterElevation& water);
 
 
 /*****************************************************************************
@@ -70,9 +44,11 @@ void consumer_elevation_water(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("elevation_water consumer");
+
     while(!finish)
     {
-      if (maps_exporter->is_elevation_water_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_ELEVATION_WATER))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -92,53 +68,30 @@ void consumer_elevation_water(void* arg)
 //----------------------------------------------------------------------------//
 bool elevation_water_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("elevation_water");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_ELEVATION_WATER));
+
   // Get the data from the queue
-  RegionDetailsElevationWater rdew = maps_exporter->pop_elevation_water();
+  RegionDetailsElevationWater rdew = maps_exporter->pop<MAP_ELEVATION_WATER>();
 
   // Check if is the marker for no more data from the producer
   if (rdew.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the data has been processed. Finish this thread execution
     return true;
   }
 
   // Get the map where we'll write to
-  ExportedMapBase* elevation_water_map = maps_exporter->get_elevation_water_map();
+  ExportedMapBase* elevation_water_map = maps_exporter->get_map<MAP_ELEVATION_WATER>();
 
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
   for (auto x=0; x<16; ++x)
     for (auto y=15; y>=0; --y)
     {
-      // Each position of the array is a value that tells us if the local tile
-      // belongs to the NW,N,NE,W,center,E,SW,S,SE world region.
-      // Returns a world coordinate adjusted from the original one
-      std::pair<int,int> adjusted_tile_coordinates = adjust_coordinates_to_region(x,
-                                                                                  y,
-                                                                                  rdew.get_biome_index(x,y),
-                                                                                  rdew.get_pos_x(),
-                                                                                  rdew.get_pos_y(),
-                                                                                  df::global::world->world_data->world_width,
-                                                                                  df::global::world->world_data->world_height
-                                                                                  );
-
-      // Get the biome type for this world position
-      int biome_type = get_biome_type(adjusted_tile_coordinates.first,
-                                      adjusted_tile_coordinates.second
-                                      );
+      // The producer already computed the elevation respecting water
+      RGB_color rgb_pixel_color = RGB_from_elevation_water(rdew.get_water_elevation(x,y));
 
-      // Get the region where this position belongs to
-      df::region_map_entry& rme = df::global::world->world_data->region_map[adjusted_tile_coordinates.first]
-                                                                           [adjusted_tile_coordinates.second];
-
-      df::world_region* region = df::global::world->world_data->regions[rme.region_id];
-
-      // Get the RGB values associated to this biome type
-      RGB_color rgb_pixel_color = RGB_from_elevation_water(rdew,
-                                                           x,
-                                                           y,
-                                                           biome_type,
-                                                           region
-                                                           );
       // Write pixels to the bitmap
       elevation_water_map->write_world_pixel(rdew.get_pos_x(),
                                              rdew.get_pos_y(),
@@ -155,94 +108,20 @@ bool elevation_water_do_work(MapsExporter* maps_exporter)
 // Return the RGB values for the elevation respecting water export map
 //----------------------------------------------------------------------------//
 
-RGB_color RGB_from_elevation_water(RegionDetailsElevationWater& rdew,
-                                   int x,
-                                   int y,
-                                   int biome_type,
-                                   df::world_region* region
-                                   )
+RGB_color RGB_from_elevation_water(const WaterElevation& water)
 {
   unsigned char r = 127;
   unsigned char g = 0;
   unsigned char b = 0;
 
-  int elevation = rdew.get_elevation(x,y);
-  bool v23 = false;
-  bool has_river = true;
-
-  int river_horiz_y_min              = rdew.get_rivers_horizontal().y_min[x  ][y];
-  int river_horiz_y_min_plus_one_row = rdew.get_rivers_horizontal().y_min[x+1][y];
-
-  int river_vert_x_min               = rdew.get_rivers_vertical().x_min[x][y  ];
-  int river_vert_x_min_plus_one_col  = rdew.get_rivers_vertical().x_min[x][y+1];
-
-  if ((river_horiz_y_min == -30000) && (river_horiz_y_min_plus_one_row == -30000))
-    if ((river_vert_x_min == -30000) && (river_vert_x_min_plus_one_col == -30000))
-    {
-      elevation = rdew.get_elevation(x,y);
-      has_river = false;
-      v23 = false;
-    }
-
-  if (has_river)
-  {
-    switch(biome_type)
-    {
-      case 1:     // GLACIER
-      case 2:     // TUNDRA
-      case 27:    // OCEAN_TROPICAL
-      case 28:    // OCEAN_TEMPERATE
-      case 29:    // OCEAN_ARCTIC
-      case 36:    // LAKE_TEMPERATE_FRESHWATER
-      case 37:    // LAKE_TEMPERATE_BRACKISH_WATER
-      case 38:    // LAKE_TEMPERATE_SALTWATER
-      case 39:    // LAKE_TROPICAL_FRESHWATER
-      case 40:    // LAKE_TROPICAL_BRACKISH_WATER
-      case 41:    // LAKE_TROPICAL_SALT_WATER
-                  if ((biome_type < 27) ||
-                      (biome_type > 29) ||
-                      (elevation  < 99))
-                      {
-                        has_river = false;
-                        break;
-                      }
-      default:    break;
-    }
-  }
-
-  if (has_river)
+  if (water.river)
   {
-    elevation = 30000;
-    if ((river_horiz_y_min != -30000) &&
-        (rdew.get_rivers_horizontal().elevation[x][y] < 30000)
-        )
-      elevation = rdew.get_rivers_horizontal().elevation[x][y];
-
-    if ((river_horiz_y_min_plus_one_row != -30000) &&
-        (rdew.get_rivers_horizontal().elevation[x+1][y] < elevation)
-        )
-      elevation = rdew.get_rivers_horizontal().elevation[x+1][y];
-
-    if ((river_vert_x_min != -30000) &&
-        (rdew.get_rivers_vertical().elevation[x][y] < elevation)
-        )
-      elevation = rdew.get_rivers_vertical().elevation[x][y];
-
-    if ((river_vert_x_min_plus_one_col != -30000) &&
-        (rdew.get_rivers_vertical().elevation[x][y+1] < elevation)
-        )
-      elevation = rdew.get_rivers_vertical().elevation[x][y+1];
-
     r = 0;
-    g = elevation;
-    b = elevation;
-    v23 = true;
+    g = water.river_elevation;
+    b = water.river_elevation;
   }
 
-  if (region->lake_surface != -30000)
-    elevation = region->lake_surface;
-
-  int corrected_elevation = elevation - 25;
+  int corrected_elevation = water.elevation - 25;
 
   if (corrected_elevation > 255)
     corrected_elevation = 255;
@@ -250,16 +129,16 @@ RGB_color RGB_from_elevation_water(RegionDetailsElevationWater& rdew,
   if ( corrected_elevation < 73)
     corrected_elevation = 73;
 
-  if ((region->type  == 5)         || // GLACIER
+  if ((water.region_type  == 5)    || // GLACIER
       ((corrected_elevation <= 73) &&
-       (region->type == 4)           // LAKE
+       (water.region_type == 4)      // LAKE
       )
      )
   {
     r = g = 0;
     b = corrected_elevation;
   }
-  else if (!v23)
+  else if (!water.river)
   {
     r = g = b = corrected_elevation;
   }
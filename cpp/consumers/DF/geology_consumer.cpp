@@ -31,6 +31,7 @@
 #include <BitArray.h>
 #include "modules/Maps.h"
 #include "../../../include/Mac_compat.h"
+#include "../../../include/dfhack.h"
 #include "../../../include/ExportMaps.h"
 #include "../../../include/util/ofsub.h"
 #include <df/region_map_entry.h>
@@ -82,7 +83,7 @@ void consumer_geology(void* arg)
 
     while(arg != nullptr)
     {
-        if (maps_exporter->is_geology_queue_empty())
+        if (maps_exporter->is_queue_empty(MAP_GEOLOGY))
         {
             // No data on the queue. Sleep 100 ms and try again
             tthread::this_thread::yield();
@@ -90,7 +91,7 @@ void consumer_geology(void* arg)
         else // There's data in the queue
         {
             // Get the data from the queue
-            RegionDetailsGeology rdg = maps_exporter->pop_geology();
+            RegionDetailsGeology rdg = maps_exporter->pop<MAP_GEOLOGY>();
 
             // Check if is the marker for no more data from the producer
             // TODO refactor this
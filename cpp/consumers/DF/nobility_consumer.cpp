@@ -20,6 +20,7 @@
 // https://github.com/ragundo/exportmaps
 
 #include "../../../include/Mac_compat.h"
+#include "../../../include/dfhack.h"
 #include "../../../include/ExportMaps.h"
 #include <df/region_map_entry.h>
 #include <df/world.h>
@@ -190,9 +191,11 @@ void consumer_nobility(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("nobility consumer");
+
     while (!finish)
     {
-      if (maps_exporter->is_nobility_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_NOBILITY))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -214,16 +217,21 @@ void consumer_nobility(void* arg)
 *****************************************************************************/
 bool nobility_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("nobility");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_NOBILITY));
+
   // Get the data from the queue
-  RegionDetailsElevationWater rdew = maps_exporter->pop_nobility();
+  RegionDetailsElevationWater rdew = maps_exporter->pop<MAP_NOBILITY>();
 
   // The map where we will write to
-  ExportedMapBase *nobility_map = maps_exporter->get_nobility_map();
+  ExportedMapBase *nobility_map = maps_exporter->get_map<MAP_NOBILITY>();
 
   // Check if is the marker for no more data from the producer
   if (rdew.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the terrain data has been processed.
+    TraceSpan overlay_span("nobility overlay");
     process_world_structures(nobility_map);
 
     // Now draw world sites and relationships over this base map
@@ -254,7 +262,7 @@ bool nobility_do_work(MapsExporter* maps_exporter)
 //----------------------------------------------------------------------------//
 void draw_nobility_map(MapsExporter* map_exporter)
 {
-  ExportedMapBase* map = map_exporter->get_nobility_map();
+  ExportedMapBase* map = map_exporter->get_map<MAP_NOBILITY>();
 
   // Draw rectangles over ALL sites
   draw_nobility_diplomacy_sites(map);
@@ -333,14 +341,14 @@ void draw_nobility_map(MapsExporter* map_exporter)
     // Compute the % of map processing
     float a = l*100;
     float b = df::global::world->entities.all.size();
-    map_exporter->set_percentage_sites((int)(a/b));
+    map_exporter->set_percentage(MAP_NOBILITY, (int)(a/b));
   }
 
   // Draw rectangles ONLY over each noble holdings
   draw_nobility_holdings_sites(map);
 
   // Map generated. Warn the main thread
-  map_exporter->set_percentage_nobility(-1);
+  map_exporter->set_percentage(MAP_NOBILITY, -1);
 }
 
 //----------------------------------------------------------------------------//
@@ -21,15 +21,8 @@
 
 #include <utility>
 #include <set>
-#include <BitArray.h>
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include "../../../include/util/ofsub.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
-#include <df/world_region.h>
 
 
 
@@ -40,10 +33,6 @@ using namespace exportmaps_plugin;
 /*****************************************************************************
 External functions
 *****************************************************************************/
-extern int                get_biome_type(int world_coord_x,
-                                         int world_coord_y
-                                         );
-
 extern std::pair<int,int> adjust_coordinates_to_region(int x,
                                                        int y,
                                                        int delta,
@@ -55,22 +44,12 @@ extern std::pair<int,int> adjust_coordinates_to_region(int x,
 
 extern RGB_color RGB_from_biome_type(int biome_type);
 
-extern df::world_region* find_world_region(int region_id);
-
 
 /*****************************************************************************
 Local functions forward declaration
 *****************************************************************************/
 bool region_do_work(MapsExporter* maps_exporter);
 
-// Return the RGB values for the biome export map given a biome type
-RGB_color RGB_from_elevation_water(RegionDetailsElevationWater& rdew,
-                                   int x,
-                                   int y,
-                                   int biome_type,
-                                   DFHack::BitArray<df::region_map_entry_flags>& flags
-                                   );
-
 RGB_color RGB_from_region_type(int region_type);
 
 std::set< std::pair<int,int>, RegionDetailsElevationWater > cache_set;
@@ -87,9 +66,11 @@ void consumer_region(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("region consumer");
+
     while(!finish)
     {
-      if (maps_exporter->is_region_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_REGION))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -109,18 +90,25 @@ void consumer_region(void* arg)
 //----------------------------------------------------------------------------//
 bool region_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("region");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_REGION));
+
   // Get the data from the queue
-  RegionDetailsElevationWater rdew = maps_exporter->pop_region();
+  RegionDetailsElevationWater rdew = maps_exporter->pop<MAP_REGION>();
 
   // Check if is the marker for no more data from the producer
   if (rdew.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the data has been processed. Finish this thread execution
     return true;
   }
 
   // Get the map where we'll write to
-  ExportedMapBase* region_map = maps_exporter->get_region_map();
+  ExportedMapBase* region_map = maps_exporter->get_map<MAP_REGION>();
+
+  // World data to read from
+  WorldData* world_data = maps_exporter->get_world_data();
 
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
   for (auto x=0; x<16; ++x)
@@ -134,20 +122,15 @@ bool region_do_work(MapsExporter* maps_exporter)
                                                                                   rdew.get_biome_index(x,y),
                                                                                   rdew.get_pos_x(),
                                                                                   rdew.get_pos_y(),
-                                                                                  df::global::world->world_data->world_width,
-                                                                                  df::global::world->world_data->world_height
+                                                                                  world_data->world_width(),
+                                                                                  world_data->world_height()
                                                                                   );
 
-      // Get the biome type for this world position
-      int biome_type = get_biome_type(adjusted_tile_coordinates.first,
-                                      adjusted_tile_coordinates.second
-                                      );
-
       // Get the region where this position belongs to
-      df::region_map_entry& rme = df::global::world->world_data->region_map[adjusted_tile_coordinates.first]
-                                                                           [adjusted_tile_coordinates.second];
+      const SnapshotRegionMapEntry& rme = world_data->region_map(adjusted_tile_coordinates.first,
+                                                                 adjusted_tile_coordinates.second);
       // Get the world region where it belongs
-      df::world_region* world_region = find_world_region(rme.region_id);
+      const SnapshotRegion* world_region = world_data->region(rme.region_id);
       if (world_region == nullptr) continue;
 
       // Get a color from the region type
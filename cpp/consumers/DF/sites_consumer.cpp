@@ -20,6 +20,7 @@
 // https://github.com/ragundo/exportmaps
 
 #include "../../../include/Mac_compat.h"
+#include "../../../include/dfhack.h"
 #include "../../../include/ExportMaps.h"
 #include "../../../include/util/ofsub.h"
 #include <df/region_map_entry.h>
@@ -59,9 +60,7 @@ extern std::pair<int,int> adjust_coordinates_to_region(int x,
                                                        int world_height
                                                        );
 
-extern RGB_color          no_river_color(int biome_type,
-                                         int elevation
-                                         );
+extern RGB_color          RGB_from_watercourse(const Watercourse& watercourse);
 
 df::world_construction*   find_construction_square_id_in_world_data_constructions(df::world_data::T_constructions& constructions,
                                                                                   int start,
@@ -176,9 +175,11 @@ void consumer_sites(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("sites consumer");
+
     while(!finish)
     {
-      if (maps_exporter->is_sites_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_SITES))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -198,16 +199,21 @@ If it's actual data process it and update the corresponding map
 *****************************************************************************/
 bool sites_do_work(MapsExporter*    maps_exporter, Logger* logger)
 {
+  TraceSpan trace_span("sites");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_SITES));
+
   // Get the data from the queue
-  RegionDetailsElevationWater rdew = maps_exporter->pop_sites();
+  RegionDetailsElevationWater rdew = maps_exporter->pop<MAP_SITES>();
   // The map where we will write to
-  ExportedMapBase* sites_map = maps_exporter->get_sites_map();
+  ExportedMapBase* sites_map = maps_exporter->get_map<MAP_SITES>();
 
   // Check if is the marker for no more data from the producer
   if (rdew.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the terrain data has been processed.
     // Now draw world sites over this base map
+    TraceSpan overlay_span("sites overlay");
     process_world_structures(sites_map);
     draw_sites_map(maps_exporter, logger);
 
@@ -264,7 +270,7 @@ bool process_nob_dip_trad_sites_common(ExportedMapBase*             map,
   if ((river_horiz_y_min == -30000) && (river_horiz_y_min_plus_one_row == -30000))
       if ((river_vert_x_min == -30000) && (river_vert_x_min_plus_one_col == -30000))
       {
-        RGB_color pixel_color = no_river_color(biome_type, rdew.get_elevation(x,y));
+        RGB_color pixel_color = RGB_from_watercourse(no_river_watercourse(biome_type, rdew.get_elevation(x,y)));
         map->write_world_pixel(rdew.get_pos_x(),
                                rdew.get_pos_y(),
                                x,
@@ -293,9 +299,9 @@ bool process_nob_dip_trad_sites_common(ExportedMapBase*             map,
                   (biome_type > 29) ||
                   (elevation  < 99))
               {
-                RGB_color pixel_color = no_river_color(biome_type,
-                                                       rdew.get_elevation(x,y)
-                                                       );
+                RGB_color pixel_color = RGB_from_watercourse(no_river_watercourse(biome_type,
+                                                                                  rdew.get_elevation(x,y)
+                                                                                  ));
                 map->write_world_pixel(rdew.get_pos_x(),
                                        rdew.get_pos_y(),
                                        x,
@@ -327,7 +333,7 @@ bool process_nob_dip_trad_sites_common(ExportedMapBase*             map,
     return false;
   }
 
-  RGB_color pixel_color = no_river_color(biome_type, rdew.get_elevation(x,y));
+  RGB_color pixel_color = RGB_from_watercourse(no_river_watercourse(biome_type, rdew.get_elevation(x,y)));
   map->write_world_pixel(rdew.get_pos_x(),
                          rdew.get_pos_y(),
                          x,
@@ -345,7 +351,7 @@ bool process_nob_dip_trad_sites_common(ExportedMapBase*             map,
 //----------------------------------------------------------------------------//
 int draw_sites_map(MapsExporter* map_exporter, Logger* logger)
 {
-  ExportedMapBase* map = map_exporter->get_sites_map();
+  ExportedMapBase* map = map_exporter->get_map<MAP_SITES>();
   int result = 0;
   for (int i = df::global::world->world_data->sites.size() - 1; i >= 0; i-- )
   {
@@ -362,7 +368,10 @@ int draw_sites_map(MapsExporter* map_exporter, Logger* logger)
 
     // Do DF initalize the site realization as this is a VERY complex task
     if (!site_has_realization)
+    {
+      TraceSpan realization_span("site realization");
       init_world_site_realization(world_site);
+    }
 
     // Get the new/updated site realization after DF work
     df::world_site_realization* site_realization = world_site->realization;
@@ -398,10 +407,10 @@ int draw_sites_map(MapsExporter* map_exporter, Logger* logger)
     // Compute the % of map processing
     float a = i*100;
     float b = df::global::world->world_data->sites.size();
-    map_exporter->set_percentage_sites(100-(int)(a/b));
+    map_exporter->set_percentage(MAP_SITES, 100-(int)(a/b));
   }
   // Map generated. Warn the main thread
-  map_exporter->set_percentage_sites(-1);
+  map_exporter->set_percentage(MAP_SITES, -1);
 
   return result;
 }
@@ -21,10 +21,6 @@
 
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
 
 using namespace exportmaps_plugin;
 
@@ -60,9 +56,11 @@ void consumer_temperature(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("temperature consumer");
+
     while(!finish)
     {
-      if (maps_exporter->is_temperature_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_TEMPERATURE))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -82,18 +80,25 @@ void consumer_temperature(void* arg)
 //----------------------------------------------------------------------------//
 bool temperature_do_work(MapsExporter* maps_exporter) // The coordinator object
 {
+  TraceSpan trace_span("temperature");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_TEMPERATURE));
+
   // Get the data from the queue
-  RegionDetailsBiome rdg = maps_exporter->pop_temperature();
+  RegionDetailsBiome rdg = maps_exporter->pop<MAP_TEMPERATURE>();
 
   // Check if is the marker for no more data from the producer
   if (rdg.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the data has been processed. Finish this thread execution
     return true;
   }
 
   // Get the map where we'll write to
-  ExportedMapBase* temperature_map = maps_exporter->get_temperature_map();
+  ExportedMapBase* temperature_map = maps_exporter->get_map<MAP_TEMPERATURE>();
+
+  // World data to read from
+  WorldData* world_data = maps_exporter->get_world_data();
 
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
   for (auto x=0; x<16; ++x)
@@ -107,10 +112,10 @@ bool temperature_do_work(MapsExporter* maps_exporter) // The coordinator object
                                                                                   rdg.get_biome_index(x,y),
                                                                                   rdg.get_pos_x(),
                                                                                   rdg.get_pos_y(),
-                                                                                  df::global::world->world_data->world_width,
-                                                                                  df::global::world->world_data->world_height
+                                                                                  world_data->world_width(),
+                                                                                  world_data->world_height()
                                                                                   );
-      df::region_map_entry& rme = df::global::world->world_data->region_map[adjusted_tile_coordinates.first][adjusted_tile_coordinates.second];
+      const SnapshotRegionMapEntry& rme = world_data->region_map(adjusted_tile_coordinates.first, adjusted_tile_coordinates.second);
 
       // Get the RGB values associated to this temperature
       RGB_color rgb_pixel_color = RGB_from_temperature(rme.temperature);
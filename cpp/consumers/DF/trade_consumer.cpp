@@ -20,6 +20,7 @@
 // https://github.com/ragundo/exportmaps
 
 #include "../../../include/Mac_compat.h"
+#include "../../../include/dfhack.h"
 #include "../../../include/ExportMaps.h"
 #include <df/region_map_entry.h>
 #include <df/historical_entity.h>
@@ -158,9 +159,11 @@ void consumer_trading(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("trading consumer");
+
     while (!finish)
     {
-      if (maps_exporter->is_trading_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_TRADING))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -183,16 +186,21 @@ void consumer_trading(void* arg)
  *****************************************************************************/
 bool trading_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("trading");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_TRADING));
+
   // Get the data from the queue
-  RegionDetailsElevationWater rdew = maps_exporter->pop_trading();
+  RegionDetailsElevationWater rdew = maps_exporter->pop<MAP_TRADING>();
 
   // The map where we will write to
-  ExportedMapBase* trade_map = maps_exporter->get_trading_map();
+  ExportedMapBase* trade_map = maps_exporter->get_map<MAP_TRADING>();
 
   // Check if is the marker for no more data from the producer
   if (rdew.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the terrain data has been processed.
+    TraceSpan overlay_span("trading overlay");
     process_world_structures(trade_map);
 
     draw_trade_map(maps_exporter);
@@ -240,7 +248,7 @@ void draw_trade_map(MapsExporter* map_exporter)
   int x = 0;
   int y = 0;
 
-  ExportedMapBase* map = map_exporter->get_trading_map();
+  ExportedMapBase* map = map_exporter->get_map<MAP_TRADING>();
 
   // Draw rectangles over each site
   draw_regular_sites(map);
@@ -287,14 +295,14 @@ void draw_trade_map(MapsExporter* map_exporter)
     // Compute the % of map processing
     float a = l*100;
     float b = df::global::world->entities.all.size();
-    map_exporter->set_percentage_trade((int)a/b);
+    map_exporter->set_percentage(MAP_TRADING, (int)a/b);
   }
 
   // Draw sites with trading relationships over the trading lines
   draw_trading_sites(map);
 
   // Map generated. Warn the main thread
-  map_exporter->set_percentage_trade(-1);
+  map_exporter->set_percentage(MAP_TRADING, -1);
 }
 
 
@@ -21,20 +21,12 @@
 
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
 
 using namespace exportmaps_plugin;
 
 /*****************************************************************************
 External functions
 *****************************************************************************/
-extern int                get_biome_type(int world_coord_x,
-                                         int world_coord_y
-                                         );
-
 extern std::pair<int,int> adjust_coordinates_to_region(int x,
                                                        int y,
                                                        int delta,
@@ -66,9 +58,11 @@ void consumer_vegetation(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("vegetation consumer");
+
     while(!finish)
     {
-      if (maps_exporter->is_vegetation_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_VEGETATION))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -89,18 +83,25 @@ void consumer_vegetation(void* arg)
 //----------------------------------------------------------------------------//
 bool vegetation_do_work(MapsExporter* maps_exporter) // The coordinator object
 {
+  TraceSpan trace_span("vegetation");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_VEGETATION));
+
   // Get the data from the queue
-  RegionDetailsBiome rdg = maps_exporter->pop_vegetation();
+  RegionDetailsBiome rdg = maps_exporter->pop<MAP_VEGETATION>();
 
   // Check if is the marker for no more data from the producer
   if (rdg.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the data has been processed. Done
     return true;
   }
 
   // Get the map where we'll write to
-  ExportedMapBase* vegetation_map = maps_exporter->get_vegetation_map();
+  ExportedMapBase* vegetation_map = maps_exporter->get_map<MAP_VEGETATION>();
+
+  // World data to read from
+  WorldData* world_data = maps_exporter->get_world_data();
 
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
   for (auto x=0; x<16; ++x)
@@ -114,15 +115,15 @@ bool vegetation_do_work(MapsExporter* maps_exporter) // The coordinator object
                                                                                   rdg.get_biome_index(x,y),
                                                                                   rdg.get_pos_x(),
                                                                                   rdg.get_pos_y(),
-                                                                                  df::global::world->world_data->world_width,
-                                                                                  df::global::world->world_data->world_height);
+                                                                                  world_data->world_width(),
+                                                                                  world_data->world_height());
 
-      df::region_map_entry& rme = df::global::world->world_data->region_map[adjusted_tile_coordinates.first][adjusted_tile_coordinates.second];
+      const SnapshotRegionMapEntry& rme = world_data->region_map(adjusted_tile_coordinates.first, adjusted_tile_coordinates.second);
 
       // Get the biome type for this world position
-      int biome_type = get_biome_type(adjusted_tile_coordinates.first,
-                                      adjusted_tile_coordinates.second
-                                      );
+      int biome_type = world_data->biome_type(adjusted_tile_coordinates.first,
+                                              adjusted_tile_coordinates.second
+                                              );
 
       // Get the RGB values associated to this vegetation & biome
       RGB_color rgb_pixel_color = RGB_from_vegetation(rme.vegetation,
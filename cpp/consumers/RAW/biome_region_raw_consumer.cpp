@@ -21,11 +21,6 @@
 
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include <df/region_map_entry.h>
-#include <df/world_region_details.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
 
 using namespace exportmaps_plugin;
 
@@ -59,9 +54,11 @@ void consumer_biome_region_raw(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("biome_region_raw consumer");
+
     while(!finish)
     {
-      if (maps_exporter->is_biome_raw_region_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_BIOME_REGION_RAW))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -81,16 +78,25 @@ void consumer_biome_region_raw(void* arg)
 //----------------------------------------------------------------------------//
 bool biome_region_raw_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("biome_region_raw");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_BIOME_REGION_RAW));
+
   // Get the data from the queue
-  RegionDetailsBiome rdb = maps_exporter->pop_biome_region_raw();
+  RegionDetailsBiome rdb = maps_exporter->pop<MAP_BIOME_REGION_RAW>();
 
   // Check if is the marker for no more data from the producer
   if (rdb.is_end_marker())
+  {
     // All the data has been processed. Done
+    work_timer.set_end_marker();
     return true;
+  }
 
   // Get the data where we'll write to
-  ExportedMapBase* map = maps_exporter->get_biome_region_raw_map();
+  ExportedMapBase* map = maps_exporter->get_map<MAP_BIOME_REGION_RAW>();
+
+  // World data to read from
+  WorldData* world_data = maps_exporter->get_world_data();
 
   // There's data to be processed
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
@@ -105,13 +111,13 @@ bool biome_region_raw_do_work(MapsExporter* maps_exporter)
                                                                                   rdb.get_biome_index(x,y),
                                                                                   rdb.get_pos_x(),
                                                                                   rdb.get_pos_y(),
-                                                                                  df::global::world->world_data->world_width,
-                                                                                  df::global::world->world_data->world_height
+                                                                                  world_data->world_width(),
+                                                                                  world_data->world_height()
                                                                                   );
 
       // Get the region entry for this embark coordinate
-      df::region_map_entry& rme = df::global::world->world_data->region_map[adjusted_tile_coordinates.first]
-                                                                           [adjusted_tile_coordinates.second];
+      const SnapshotRegionMapEntry& rme = world_data->region_map(adjusted_tile_coordinates.first,
+                                                                 adjusted_tile_coordinates.second);
 
       // Write region id in the buffer
       map->write_data(rdb.get_pos_x(),
@@ -18,10 +18,6 @@
 
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
 
 // You can always find the latest version of this plugin in Github
 // https://github.com/ragundo/exportmaps
@@ -44,9 +40,11 @@ void consumer_elevation_raw(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("elevation_raw consumer");
+
     while(!finish)
     {
-      if (maps_exporter->is_elevation_raw_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_ELEVATION_RAW))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -66,17 +64,21 @@ void consumer_elevation_raw(void* arg)
 //----------------------------------------------------------------------------//
 bool elevation_raw_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("elevation_raw");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_ELEVATION_RAW));
+
   // Get the data from the queue
-  RegionDetailsElevation rde = maps_exporter->pop_elevation_raw();
+  RegionDetailsElevation rde = maps_exporter->pop<MAP_ELEVATION_RAW>();
   // Check if is the marker for no more data from the producer
   if (rde.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the data has been processed. Finish this thread execution
     return true;
   }
 
   // Get the map where we'll write to
-  ExportedMapBase* elevation_raw_map = maps_exporter->get_elevation_raw_map();
+  ExportedMapBase* elevation_raw_map = maps_exporter->get_map<MAP_ELEVATION_RAW>();
 
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
   for (auto x=0; x<16; ++x)
@@ -20,53 +20,18 @@
 // https://github.com/ragundo/exportmaps
 
 #include <utility>
-#include <BitArray.h>
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include "../../../include/util/ofsub.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
-#include <df/world_river.h>
-
-
 
 
 using namespace exportmaps_plugin;
 
 
-/*****************************************************************************
-External functions
-*****************************************************************************/
-extern int                get_biome_type(int world_coord_x,
-                                         int world_coord_y
-                                         );
-
-extern std::pair<int,int> adjust_coordinates_to_region(int x,
-                                                       int y,
-                                                       int delta,
-                                                       int pos_x,
-                                                       int pos_y,
-                                                       int world_width,
-                                                       int world_height
-                                                       );
-
-extern std::pair<df::world_river*, int> get_world_river(int x,
-                                                        int y
-                                                        );
-
 /*****************************************************************************
 Local functions forward declaration
 *****************************************************************************/
 bool hydro_raw_do_work(MapsExporter* maps_exporter);
 
-int river_value(RegionDetailsElevationWater& rdew,
-                int x,
-                int y,
-                int biome_type,
-                DFHack::BitArray<df::region_map_entry_flags>& flags
-                );
 
 
 
@@ -82,9 +47,11 @@ void consumer_hydro_raw(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("hydro_raw consumer");
+
     while(!finish)
     {
-      if (maps_exporter->is_hydro_raw_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_HYDRO_RAW))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -104,51 +71,29 @@ void consumer_hydro_raw(void* arg)
 //----------------------------------------------------------------------------//
 bool hydro_raw_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("hydro_raw");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_HYDRO_RAW));
+
   // Get the data from the queue
-  RegionDetailsElevationWater rdew = maps_exporter->pop_hydro_raw();
+  RegionDetailsElevationWater rdew = maps_exporter->pop<MAP_HYDRO_RAW>();
 
   // Check if is the marker for no more data from the producer
   if (rdew.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the data has been processed. Finish this thread execution
     return true;
   }
 
   // Get the map where we'll write to
-  ExportedMapBase* hydro_raw_map = maps_exporter->get_hydro_raw_map();
+  ExportedMapBase* hydro_raw_map = maps_exporter->get_map<MAP_HYDRO_RAW>();
 
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
   for (auto x=0; x<16; ++x)
     for (auto y=15; y>=0; --y)
     {
-      // Each position of the array is a value that tells us if the local tile
-      // belongs to the NW,N,NE,W,center,E,SW,S,SE world region.
-      // Returns a world coordinate adjusted from the original one
-      std::pair<int,int> adjusted_tile_coordinates = adjust_coordinates_to_region(x,
-                                                                                  y,
-                                                                                  rdew.get_biome_index(x,y),
-                                                                                  rdew.get_pos_x(),
-                                                                                  rdew.get_pos_y(),
-                                                                                  df::global::world->world_data->world_width,
-                                                                                  df::global::world->world_data->world_height
-                                                                                  );
-
-      // Get the biome type for this world position
-      int biome_type = get_biome_type(adjusted_tile_coordinates.first,
-                                      adjusted_tile_coordinates.second
-                                      );
-
-      // Get the region where this position belongs to
-      df::region_map_entry& rme = df::global::world->world_data->region_map[adjusted_tile_coordinates.first]
-                                                                           [adjusted_tile_coordinates.second];
-
-      // Get the river value
-      int river_val = river_value(rdew,
-                                  x,
-                                  y,
-                                  biome_type,
-                                  rme.flags
-                                  );
+      // The producer already computed the water course
+      int river_val = rdew.get_watercourse(x,y).value;
 
       // Write data to the map
       hydro_raw_map->write_data(rdew.get_pos_x(),
@@ -162,84 +107,3 @@ bool hydro_raw_do_work(MapsExporter* maps_exporter)
   return false; // Continue working
 }
 
-
-//----------------------------------------------------------------------------//
-// Utility function
-//----------------------------------------------------------------------------//
-int river_value(RegionDetailsElevationWater& rdew,
-                int x,
-                int y,
-                int biome_type,
-                DFHack::BitArray<df::region_map_entry_flags>& flags
-                )
-{
-    int elevation                      = rdew.get_elevation(x,y);
-    int river_horiz_y_min              = rdew.get_rivers_horizontal().y_min[x][y  ];
-    int river_horiz_y_min_plus_one_row = rdew.get_rivers_horizontal().y_min[x+1][y];
-    int river_vert_x_min               = rdew.get_rivers_vertical().x_min[x  ][y];
-    int river_vert_x_min_plus_one_col  = rdew.get_rivers_vertical().x_min[x][y+1];
-
-    if ((river_horiz_y_min == -30000) && (river_horiz_y_min_plus_one_row == -30000))
-        if ((river_vert_x_min == -30000) && (river_vert_x_min_plus_one_col == -30000))
-            return 0;
-
-    // Posibly rivers finishing in ocean or lake
-    // Posibly rivers in glacier or tundra are discarted
-    switch(biome_type)
-    {
-        case 1:     // GLACIER
-        case 2:     // TUNDRA
-        case 27:    // OCEAN_TROPICAL
-        case 28:    // OCEAN_TEMPERATE
-        case 29:    // OCEAN_ARCTIC
-        case 36:    // LAKE_TEMPERATE_FRESHWATER
-        case 37:    // LAKE_TEMPERATE_BRACKISH_WATER
-        case 38:    // LAKE_TEMPERATE_SALTWATER
-        case 39:    // LAKE_TROPICAL_FRESHWATER
-        case 40:    // LAKE_TROPICAL_BRACKISH_WATER
-        case 41:    // LAKE_TROPICAL_SALT_WATER
-                    if ((biome_type < 27) ||  // OCEAN_TROPICAL
-                        (biome_type > 29) ||  // OCEAN_ARTIC
-                        (elevation  < 99))    // Not shore
-                            return 0;
-                    break;
-        default:    break;
-    }
-
-    bool brook_flag = flags.is_set(df::enums::region_map_entry_flags::region_map_entry_flags::is_brook);
-
-    char* p_void = (char*)&flags;
-    p_void += 4;
-    uint32_t size = (uint32_t)*p_void;
-    bool v41 = __OFSUB__(size,1);
-    bool v40 = size == 1;
-    bool v12 = (size-1) < 0;
-    bool expr = (v12 ^ v41) | v40 || !brook_flag;
-
-    if (!expr)
-        return 32767; // Brook
-
-    std::pair<df::world_river*, int> river_data = get_world_river(rdew.get_pos_x(),
-                                                                  rdew.get_pos_y()
-                                                                  );
-    df::world_river* ptr_world_river = river_data.first;
-    int river_index = river_data.second;
-
-    if (ptr_world_river == nullptr)
-        return 1; // Sea or lake shore
-
-    int value = ptr_world_river->unk_8c[river_index];
-/*
-    if (value >= 20000) // Major river
-    if (value >= 10000) // river
-    if (value >= 5000)  // minor river
-    else               // stream
-*/
-
-    if (value >= 32000)
-      return 32000;
-
-    return value;
-}
-
-
@@ -21,10 +21,6 @@
 
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
 
 using namespace exportmaps_plugin;
 
@@ -57,9 +53,11 @@ void consumer_volcanism_raw(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("volcanism_raw consumer");
+
     while(!finish)
     {
-      if (maps_exporter->is_volcanism_raw_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_VOLCANISM_RAW))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -79,18 +77,27 @@ void consumer_volcanism_raw(void* arg)
 //----------------------------------------------------------------------------//
 bool volcanism_raw_do_work(MapsExporter* maps_exporter)
 {
+  TraceSpan trace_span("volcanism_raw");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_VOLCANISM_RAW));
+
   // Get the data from the queue
-  RegionDetailsBiome rdg = maps_exporter->pop_volcanism_raw();
+  RegionDetailsBiome rdg = maps_exporter->pop<MAP_VOLCANISM_RAW>();
 
   // Check if is the marker for no more data from the producer
   if (rdg.is_end_marker())
+  {
     // All the data has been processed. Done
+    work_timer.set_end_marker();
     return true;
+  }
 
   // There's data to be processed
 
   // Get the map where we'll write to
-  ExportedMapBase* volcanism_raw_map = maps_exporter->get_volcanism_raw_map();
+  ExportedMapBase* volcanism_raw_map = maps_exporter->get_map<MAP_VOLCANISM_RAW>();
+
+  // World data to read from
+  WorldData* world_data = maps_exporter->get_world_data();
 
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
   for (auto x=0; x<16; ++x)
@@ -104,11 +111,11 @@ bool volcanism_raw_do_work(MapsExporter* maps_exporter)
                                                                                   rdg.get_biome_index(x,y),
                                                                                   rdg.get_pos_x(),
                                                                                   rdg.get_pos_y(),
-                                                                                  df::global::world->world_data->world_width,
-                                                                                  df::global::world->world_data->world_height
+                                                                                  world_data->world_width(),
+                                                                                  world_data->world_height()
                                                                                   );
       // Get the proper df::region_entry
-      df::region_map_entry& rme = df::global::world->world_data->region_map[adjusted_tile_coordinates.first][adjusted_tile_coordinates.second];
+      const SnapshotRegionMapEntry& rme = world_data->region_map(adjusted_tile_coordinates.first, adjusted_tile_coordinates.second);
 
       // Write data to the map
       volcanism_raw_map->write_data(rdg.get_pos_x(),
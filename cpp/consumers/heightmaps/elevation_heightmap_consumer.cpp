@@ -18,10 +18,6 @@
 
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
 
 // You can always find the latest version of this plugin in Github
 // https://github.com/ragundo/exportmaps
@@ -35,8 +31,6 @@ bool      elevation_heightmap_do_work(MapsExporter* maps_exporter,
                                       int max_world_elevation
                                       );
 
-int find_max_world_elevation();
-
 /*****************************************************************************
 Module main function.
 This is the function that the thread executes
@@ -48,12 +42,14 @@ void consumer_elevation_heightmap(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("elevation_heightmap consumer");
+
     // Find the maximum height in the world
-    int max_world_elevation = find_max_world_elevation();
+    int max_world_elevation = maps_exporter->get_world_data()->max_elevation();
 
     while(!finish)
     {
-      if (maps_exporter->is_elevation_hm_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_ELEVATION_HM))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -73,55 +69,38 @@ void consumer_elevation_heightmap(void* arg)
 //----------------------------------------------------------------------------//
 bool elevation_heightmap_do_work(MapsExporter* maps_exporter, int max_world_elevation)
 {
+  TraceSpan trace_span("elevation_heightmap");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_ELEVATION_HM));
+
   // Get the data from the queue
-  RegionDetailsElevation rde = maps_exporter->pop_elevation_hm();
+  RegionDetailsElevation rde = maps_exporter->pop<MAP_ELEVATION_HM>();
   // Check if is the marker for no more data from the producer
   if (rde.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the data has been processed. Finish this thread execution
     return true;
   }
 
   // Get the map where we'll write to
-  ExportedMapBase* elevation_heightmap_map = maps_exporter->get_elevation_hm_map();
+  ExportedMapBase* elevation_heightmap_map = maps_exporter->get_map<MAP_ELEVATION_HM>();
 
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
   for (auto x=0; x<16; ++x)
     for (auto y=0; y<16; ++y)
     {
       // Scale the value relative to the world maximum elevation
-      // The value for the maximum world elevation must be 255
-      int scaled_elevation = (rde.get_elevation(x,y) * 255) / max_world_elevation;
-
-      RGB_color rgb_pixel_color = RGB_color(scaled_elevation,
-                                            scaled_elevation,
-                                            scaled_elevation
-                                            );
-
-      // Write pixel to the bitmap
-      elevation_heightmap_map->write_world_pixel(rde.get_pos_x(),
-                                                 rde.get_pos_y(),
-                                                 x,
-                                                 y,
-                                                 rgb_pixel_color
-                                                 );
+      // The value for the maximum world elevation must be 65535
+      int scaled_elevation = (rde.get_elevation(x,y) * 65535) / max_world_elevation;
+
+      // Write the 16 bit value to the heightmap
+      elevation_heightmap_map->write_data(rde.get_pos_x(),
+                                          rde.get_pos_y(),
+                                          x,
+                                          y,
+                                          scaled_elevation
+                                          );
 
     }
   return false; // Continue working
 }
-
-//----------------------------------------------------------------------------//
-// Utility function
-//
-// Iterates over mountain peaks looking for the one with the maximum height
-// This height will be the maximum elevation of the complete DF world
-//----------------------------------------------------------------------------//
-int find_max_world_elevation()
-{
-  int max_height = -1;
-  for (unsigned int i = 0; i < df::global::world->world_data->mountain_peaks.size(); i++)
-    if ( max_height <= df::global::world->world_data->mountain_peaks[i]->height)
-      max_height = df::global::world->world_data->mountain_peaks[i]->height;
-
-  return max_height;
-}
@@ -21,37 +21,13 @@
 
 #include "../../../include/Mac_compat.h"
 #include "../../../include/ExportMaps.h"
-#include <df/region_map_entry.h>
-#include <df/world.h>
-#include <df/world_data.h>
-#include <df/world_region_details.h>
 
 using namespace exportmaps_plugin;
 
 /*****************************************************************************
 External functions
 *****************************************************************************/
-extern int                get_biome_type(int world_coord_x,
-                                         int world_coord_y
-                                         );
-
-extern std::pair<int,int> adjust_coordinates_to_region(int x,
-                                                       int y,
-                                                       int delta,
-                                                       int pos_x,
-                                                       int pos_y,
-                                                       int world_width,
-                                                       int world_height
-                                                       );
-
-extern int elevation_water(RegionDetailsElevationWater& rdew,
-                             int x,
-                             int y,
-                             int biome_type,
-                             df::world_region* region
-                             );
-
-extern int find_max_world_elevation();
+extern int elevation_water(const WaterElevation& water);
 
 
 /*****************************************************************************
@@ -73,12 +49,14 @@ void consumer_elevation_water_heightmap(void* arg)
 
   if (arg != nullptr)
   {
+    Tracer::set_thread_name("elevation_water_heightmap consumer");
+
     // Find the maximum height in the world
-    int max_world_elevation = find_max_world_elevation();
+    int max_world_elevation = maps_exporter->get_world_data()->max_elevation();
 
     while(!finish)
     {
-      if (maps_exporter->is_elevation_water_hm_queue_empty())
+      if (maps_exporter->is_queue_empty(MAP_ELEVATION_WATER_HM))
         // No data on the queue. Try again later
         tthread::this_thread::yield();
 
@@ -98,69 +76,41 @@ void consumer_elevation_water_heightmap(void* arg)
 //----------------------------------------------------------------------------//
 bool elevation_water_heightmap_do_work(MapsExporter* maps_exporter, int max_world_elevation)
 {
+  TraceSpan trace_span("elevation_water_heightmap");
+  MapWorkTimer work_timer(maps_exporter->get_metrics(MAP_ELEVATION_WATER_HM));
+
   // Get the data from the queue
-  RegionDetailsElevationWater rdew = maps_exporter->pop_elevation_water_hm();
+  RegionDetailsElevationWater rdew = maps_exporter->pop<MAP_ELEVATION_WATER_HM>();
 
   // Check if is the marker for no more data from the producer
   if (rdew.is_end_marker())
   {
+    work_timer.set_end_marker();
     // All the data has been processed. Finish this thread execution
     return true;
   }
 
   // The map where we'll write to
-  ExportedMapBase* elevation_water_heightmap_map = maps_exporter->get_elevation_water_hm_map();
+  ExportedMapBase* elevation_water_heightmap_map = maps_exporter->get_map<MAP_ELEVATION_WATER_HM>();
 
   // Iterate over the 16 subtiles (x) and (y) that a world tile has
   for (auto x=0; x<16; ++x)
     for (auto y=15; y>=0; --y)
     {
-      // Each position of the array is a value that tells us if the local tile
-      // belongs to the NW,N,NE,W,center,E,SW,S,SE world region.
-      // Returns a world coordinate adjusted from the original one
-      std::pair<int,int> adjusted_tile_coordinates = adjust_coordinates_to_region(x,
-                                                                                  y,
-                                                                                  rdew.get_biome_index(x,y),
-                                                                                  rdew.get_pos_x(),
-                                                                                  rdew.get_pos_y(),
-                                                                                  df::global::world->world_data->world_width,
-                                                                                  df::global::world->world_data->world_height
-                                                                                  );
-      // Get the biome type for this world position
-      int biome_type = get_biome_type(adjusted_tile_coordinates.first,
-                                      adjusted_tile_coordinates.second
-                                      );
-
-      // Get the region where this position belongs to
-      df::region_map_entry& rme = df::global::world->world_data->region_map[adjusted_tile_coordinates.first]
-                                                                           [adjusted_tile_coordinates.second];
-
-      df::world_region* region = df::global::world->world_data->regions[rme.region_id];
-
-      int corrected_elevation = elevation_water(rdew,
+      // The producer already computed the elevation respecting water
+      int corrected_elevation = elevation_water(rdew.get_water_elevation(x,y));
+
+      // Scale the value relative to the world maximum elevation
+      // The value for the maximum world elevation must be 65535
+      int scaled_elevation = (corrected_elevation * 65535) / max_world_elevation;
+
+      // Write the 16 bit value to the heightmap
+      elevation_water_heightmap_map->write_data(rdew.get_pos_x(),
+                                                rdew.get_pos_y(),
                                                 x,
                                                 y,
-                                                biome_type,
-                                                region
+                                                scaled_elevation
                                                 );
-
-      // Scale the value relative to the world maximum elevation
-      // The value for the maximum world elevation must be 255
-      int scaled_elevation = (corrected_elevation * 255) / max_world_elevation;
-
-
-      RGB_color pixel_color = RGB_color(scaled_elevation,
-                                        scaled_elevation,
-                                        scaled_elevation
-                                        );
-
-      // Write value to the map
-      elevation_water_heightmap_map->write_world_pixel(rdew.get_pos_x(),
-                                                       rdew.get_pos_y(),
-                                                       x,
-                                                       y,
-                                                       pixel_color
-                                                       );
   }
   return false; // Continue working
 }
@@ -0,0 +1,326 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <string.h>
+#include <utility>
+
+#include "../../include/dfhack.h"
+#include "../../include/RegionDetailsCache.h"
+#include "../../include/TileFingerprints.h"
+#include "../../include/WorldData.h"
+#include <modules/World.h>
+#include <df/world.h>
+#include <df/world_data.h>
+#include <df/world_region.h>
+#include <df/world_region_details.h>
+#include <df/region_map_entry.h>
+#include <df/world_river.h>
+
+using namespace exportmaps_plugin;
+using namespace DFHack;
+
+/*****************************************************************************
+External functions
+*****************************************************************************/
+extern int  get_biome_type(int world_coord_x,
+                           int world_coord_y
+                           );
+
+extern int  fill_world_region_details(int world_pos_x,
+                                      int world_pos_y
+                                      );
+
+extern void capture_sites        (std::vector<SnapshotSite>& sites);
+
+extern void capture_entities     (std::vector<SnapshotEntity>& entities,
+                                  std::vector<SnapshotEntitySiteLink>& links
+                                  );
+
+extern void capture_constructions(std::vector<SnapshotConstruction>& constructions,
+                                  std::vector<SnapshotConstructionSquare>& squares,
+                                  std::vector<SnapshotConstructionPoint>& points
+                                  );
+
+/*****************************************************************************
+Local functions forward declaration
+*****************************************************************************/
+std::pair<df::world_river*, int> get_world_river(int x,
+                                                 int y
+                                                 );
+
+int  find_max_world_elevation();
+
+void copy_region_details(df::world_region_details* rd,
+                         SnapshotRegionDetails& snapshot_rd
+                         );
+
+/*****************************************************************************
+ DFWorldData methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Constructor.
+// Copy the world tables read by the consumers. The biome type and the river
+// flow of each world tile are computed here once instead of once per pixel
+//----------------------------------------------------------------------------//
+DFWorldData::DFWorldData()
+  : _cache(nullptr)
+{
+  df::world_data* world_data = df::global::world->world_data;
+
+  _world_width  = world_data->world_width;
+  _world_height = world_data->world_height;
+
+  // Save folder, date and the height of the highest peak
+  strncpy(_world_info.world_folder, World::ReadWorldFolder().c_str(), sizeof(_world_info.world_folder) - 1);
+  _world_info.year          = World::ReadCurrentYear();
+  _world_info.month         = World::ReadCurrentMonth() + 1;
+  _world_info.day           = World::ReadCurrentDay();
+  _world_info.max_elevation = find_max_world_elevation();
+
+  // World regions
+  _regions_data.resize(world_data->regions.size());
+  for (size_t i = 0; i < world_data->regions.size(); ++i)
+  {
+    df::world_region* region = world_data->regions[i];
+    _regions_data[i].type         = (region != nullptr) ? (int32_t)region->type  : -1;
+    _regions_data[i].lake_surface = (region != nullptr) ? region->lake_surface : -30000;
+  }
+
+  // Region map and rivers, by rows
+  size_t world_tiles = (size_t)_world_width * _world_height;
+  _region_map_data.resize(world_tiles);
+  _river_flow_data.resize(world_tiles);
+
+  for (int y = 0; y < _world_height; ++y)
+    for (int x = 0; x < _world_width; ++x)
+    {
+      df::region_map_entry&   rme   = world_data->region_map[x][y];
+      SnapshotRegionMapEntry& entry = _region_map_data[(size_t)y * _world_width + x];
+
+      entry.region_id   = rme.region_id;
+      entry.biome_type  = get_biome_type(x, y);
+      entry.elevation   = rme.elevation;
+      entry.temperature = rme.temperature;
+      entry.rainfall    = rme.rainfall;
+      entry.drainage    = rme.drainage;
+      entry.savagery    = rme.savagery;
+      entry.volcanism   = rme.volcanism;
+      entry.vegetation  = rme.vegetation;
+      entry.evilness    = rme.evilness;
+      entry.salinity    = rme.salinity;
+      entry.geo_index   = rme.geo_index;
+      entry.flags_size  = rme.flags.size;
+      entry.flags       = 0;
+
+      if (rme.flags.is_set(df::region_map_entry_flags::has_river)) entry.flags |= REGION_FLAG_HAS_RIVER;
+      if (rme.flags.is_set(df::region_map_entry_flags::is_brook))  entry.flags |= REGION_FLAG_IS_BROOK;
+      if (rme.flags.is_set(df::region_map_entry_flags::is_lake))   entry.flags |= REGION_FLAG_IS_LAKE;
+
+      std::pair<df::world_river*, int> river_data = get_world_river(x, y);
+      _river_flow_data[(size_t)y * _world_width + x] = (river_data.first != nullptr) ?
+                                                       river_data.first->unk_8c[river_data.second] :
+                                                       -1;
+    }
+
+  _region_map   = _region_map_data.empty() ? nullptr : &_region_map_data[0];
+  _regions      = _regions_data.empty()    ? nullptr : &_regions_data[0];
+  _region_count = _regions_data.size();
+  _river_flow   = _river_flow_data.empty() ? nullptr : &_river_flow_data[0];
+}
+
+//----------------------------------------------------------------------------//
+// Copy the region details of a world tile.
+// For the current embark they are already present in world.world_data.region_details,
+// so there's no need to generate nor destroy them. For the rest they are
+// generated on demand and removed after being copied, unless a cache has them
+// from a previous export
+//----------------------------------------------------------------------------//
+bool DFWorldData::region_details(int x,                    // world coordinate x
+                                 int y,                    // world coordinate y
+                                 SnapshotRegionDetails& rd // destination
+                                 )
+{
+  df::world_data* world_data = df::global::world->world_data;
+
+  // Generating them is the slowest part of the export
+  uint32_t key = 0;
+  if (_cache != nullptr)
+  {
+    key = RegionDetailsCache::tile_key(*this, x, y);
+    if (_cache->lookup(x, y, key, rd))
+      return true;
+  }
+
+  for (unsigned int k = 0; k < world_data->region_details.size(); ++k)
+    if ((world_data->region_details[k]->pos.x == x) &&
+        (world_data->region_details[k]->pos.y == y))
+    {
+      copy_region_details(world_data->region_details[k], rd);
+      if (_cache != nullptr)
+        _cache->store(x, y, key, rd);
+      return true;
+    }
+
+  // size before inserting the new element
+  int previous = world_data->region_details.size();
+
+  // generate a new region details a push in the vector
+  fill_world_region_details(x, y);
+
+  // The new size must be the original + 1. If not there was an error
+  int new_size = world_data->region_details.size();
+  if ((new_size == 0) || (new_size == previous))
+    return false;
+
+  df::world_region_details* ptr_rd = world_data->region_details[new_size - 1];
+  copy_region_details(ptr_rd, rd);
+
+  // Remove the generated region details and its entry in the vector
+  delete ptr_rd;
+  world_data->region_details.erase(world_data->region_details.begin() + new_size - 1);
+
+  if (_cache != nullptr)
+    _cache->store(x, y, key, rd);
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Hash the sites, entities and constructions, copied as they would be stored
+// in a snapshot so only the fields read by the maps are taken into account
+//----------------------------------------------------------------------------//
+template <typename T>
+static uint64_t hash_records(const std::vector<T>& records, uint64_t hash)
+{
+  size_t count = records.size();
+  hash = TileFingerprints::hash_bytes(&count, sizeof(count), hash);
+  if (count != 0)
+    hash = TileFingerprints::hash_bytes(&records[0], count * sizeof(T), hash);
+  return hash;
+}
+
+uint64_t DFWorldData::overlay_fingerprint()
+{
+  std::vector<SnapshotSite>               sites;
+  std::vector<SnapshotEntity>             entities;
+  std::vector<SnapshotEntitySiteLink>     entity_site_links;
+  std::vector<SnapshotConstruction>       constructions;
+  std::vector<SnapshotConstructionSquare> construction_squares;
+  std::vector<SnapshotConstructionPoint>  construction_points;
+
+  capture_sites(sites);
+  capture_entities(entities, entity_site_links);
+  capture_constructions(constructions, construction_squares, construction_points);
+
+  uint64_t hash = TileFingerprints::hash_bytes(nullptr, 0);
+  hash = hash_records(sites,                hash);
+  hash = hash_records(entities,             hash);
+  hash = hash_records(entity_site_links,    hash);
+  hash = hash_records(constructions,        hash);
+  hash = hash_records(construction_squares, hash);
+  hash = hash_records(construction_points,  hash);
+  return hash;
+}
+
+//----------------------------------------------------------------------------//
+// Utility function
+// Copy the region details fields used by the consumers
+//----------------------------------------------------------------------------//
+void copy_region_details(df::world_region_details* rd,
+                         SnapshotRegionDetails& snapshot_rd
+                         )
+{
+  memset(&snapshot_rd, 0, sizeof(snapshot_rd));
+  snapshot_rd.pos_x = rd->pos.x;
+  snapshot_rd.pos_y = rd->pos.y;
+
+  for (int i = 0; i < 17; ++i)
+    for (int j = 0; j < 17; ++j)
+    {
+      snapshot_rd.elevation[i][j] = rd->elevation[i][j];
+      snapshot_rd.biome[i][j]     = (int8_t)rd->biome[i][j];
+    }
+
+  for (int i = 0; i < 16; ++i)
+    for (int j = 0; j < 17; ++j)
+    {
+      snapshot_rd.rivers_vertical_x_min[i][j]     = rd->rivers_vertical.x_min[i][j];
+      snapshot_rd.rivers_vertical_elevation[i][j] = rd->rivers_vertical.elevation[i][j];
+    }
+
+  for (int i = 0; i < 17; ++i)
+    for (int j = 0; j < 16; ++j)
+    {
+      snapshot_rd.rivers_horizontal_y_min[i][j]     = rd->rivers_horizontal.y_min[i][j];
+      snapshot_rd.rivers_horizontal_elevation[i][j] = rd->rivers_horizontal.elevation[i][j];
+    }
+}
+
+//----------------------------------------------------------------------------//
+// Utility function
+//
+// Iterates over mountain peaks looking for the one with the maximum height
+// This height will be the maximum elevation of the complete DF world
+//----------------------------------------------------------------------------//
+int find_max_world_elevation()
+{
+  int max_height = -1;
+  for (unsigned int i = 0; i < df::global::world->world_data->mountain_peaks.size(); i++)
+    if ( max_height <= df::global::world->world_data->mountain_peaks[i]->height)
+      max_height = df::global::world->world_data->mountain_peaks[i]->height;
+
+  return max_height;
+}
+
+//----------------------------------------------------------------------------//
+// Utility function
+// Return the river that crosses a world tile and the index of the tile in
+// the river path
+//----------------------------------------------------------------------------//
+std::pair<df::world_river*, int> get_world_river(int x, int y)
+{
+    std::pair<df::world_river*, int> NO_RIVER((df::world_river*)nullptr,-1);
+
+    // Out of bounds check
+    if ((x < 0) || (x >= df::global::world->world_data->world_width) ||
+        (y < 0) || (y >= df::global::world->world_data->world_height))
+            return NO_RIVER;
+
+    if (df::global::world->world_data->feature_map != nullptr)
+    {
+        df::world_data::T_feature_map& t_feature = df::global::world->world_data->feature_map[x >> 4][y >> 4];
+
+        if (t_feature.unk_8 != nullptr)
+        {
+            int offset = 2 * ((y % 16) + sizeof(df::world_data::T_feature_map) * (x % 16));
+            int value1  = t_feature.unk_8[offset];
+            if (value1 != -1)
+            {
+                int value2  = t_feature.unk_8[offset + 1];
+                df::world_river* river = df::global::world->world_data->rivers[value1];
+                return std::pair<df::world_river*, int>(river,value2);
+            }
+        }
+    }
+
+    return NO_RIVER;
+}
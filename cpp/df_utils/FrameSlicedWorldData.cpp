@@ -0,0 +1,158 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include "../../include/dfhack.h"
+#include "../../include/WorldData.h"
+#include <df/world.h>
+#include <df/world_data.h>
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ FrameSlicedWorldData methods
+*****************************************************************************/
+
+//----------------------------------------------------------------------------//
+// Constructor. DF must be paused, as the world tables are copied and the
+// sites, entities and constructions are hashed now
+//----------------------------------------------------------------------------//
+FrameSlicedWorldData::FrameSlicedWorldData(size_t capacity // Most tiles generated ahead
+                                           )
+  : _capacity(capacity),
+    _wanted(0),
+    _next(0),
+    _sweep(0),
+    _started(false),
+    _cancelled(false),
+    _df_world(df::global::world->world_data)
+{
+  _overlays = DFWorldData::overlay_fingerprint();
+}
+
+//----------------------------------------------------------------------------//
+// Generate the region details of the next world tiles, while there's room
+// for them. Called from plugin_onupdate, so DF is paused by DFHack
+//----------------------------------------------------------------------------//
+void FrameSlicedWorldData::generate(unsigned int count // Most tiles to generate
+                                    )
+{
+  // The world was unloaded, or another one loaded, during the export
+  if (df::global::world->world_data != _df_world)
+  {
+    this->cancel();
+    return;
+  }
+
+  size_t world_tiles = (size_t)_world_width * _world_height;
+
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    Tile tile;
+    {
+      tthread::lock_guard<tthread::mutex> guard(_mutex);
+      if (_cancelled || !_started || (_ready.size() >= _capacity) || (_next >= world_tiles))
+        return;
+      tile.index = _next++;
+      tile.sweep = _sweep;
+    }
+
+    // Without the lock, so the export can take the tiles already generated
+    tile.ok = DFWorldData::region_details((int)(tile.index % _world_width),
+                                          (int)(tile.index / _world_width),
+                                          tile.details
+                                          );
+
+    tthread::lock_guard<tthread::mutex> guard(_mutex);
+
+    // The export skipped it, or started another sweep, while it was being generated
+    if ((tile.sweep == _sweep) && (tile.index >= _wanted))
+      _ready.push_back(tile);
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Stop generating tiles
+//----------------------------------------------------------------------------//
+void FrameSlicedWorldData::cancel()
+{
+  tthread::lock_guard<tthread::mutex> guard(_mutex);
+  _cancelled = true;
+}
+
+//----------------------------------------------------------------------------//
+// Wait until the DF thread has generated the region details of a world tile.
+// The world is swept by rows, so the tiles before it will never be asked
+// for and are discarded, and if it's past the next tile to generate, the
+// DF thread jumps to it. A tile before the last one asked for starts another
+// sweep (the next wave of a -mem-budget export)
+//----------------------------------------------------------------------------//
+bool FrameSlicedWorldData::region_details(int x,                    // world coordinate x
+                                          int y,                    // world coordinate y
+                                          SnapshotRegionDetails& rd // destination
+                                          )
+{
+  size_t index = (size_t)y * _world_width + x;
+
+  while (true)
+  {
+    {
+      tthread::lock_guard<tthread::mutex> guard(_mutex);
+
+      if (_started && (index < _wanted))
+      {
+        _ready.clear();
+        _next = index;
+        _sweep++;
+      }
+
+      _started = true;
+      _wanted  = index;
+      if (_next < index)
+        _next = index;
+
+      while (!_ready.empty() && (_ready.front().index < index))
+        _ready.pop_front();
+
+      if (!_ready.empty() && (_ready.front().index == index))
+      {
+        bool ok = _ready.front().ok;
+        rd = _ready.front().details;
+        _ready.pop_front();
+        return ok;
+      }
+
+      if (_cancelled)
+        return false;
+    }
+
+    // The next frame is several milliseconds away
+    tthread::this_thread::sleep_for(tthread::chrono::milliseconds(1));
+  }
+}
+
+//----------------------------------------------------------------------------//
+// The export thread can't read DF, so the fingerprint is the one computed
+// when the object was created
+//----------------------------------------------------------------------------//
+uint64_t FrameSlicedWorldData::overlay_fingerprint()
+{
+  return _overlays;
+}
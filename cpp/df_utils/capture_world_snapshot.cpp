@@ -0,0 +1,333 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <string.h>
+#include <vector>
+
+#include "../../include/dfhack.h"
+#include "../../include/Logger.h"
+#include "../../include/WorldData.h"
+#include <df/world.h>
+#include <df/world_data.h>
+#include <df/world_site.h>
+#include <df/world_site_inhabitant.h>
+#include <df/historical_entity.h>
+#include <df/entity_site_link.h>
+#include <df/world_construction.h>
+#include <df/world_construction_square.h>
+#include <df/world_construction_square_roadst.h>
+#include <df/world_construction_square_bridgest.h>
+#include <df/world_construction_square_wallst.h>
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+Local functions forward declaration
+*****************************************************************************/
+void capture_sites        (std::vector<SnapshotSite>& sites);
+
+void capture_entities     (std::vector<SnapshotEntity>& entities,
+                           std::vector<SnapshotEntitySiteLink>& links
+                           );
+
+void capture_constructions(std::vector<SnapshotConstruction>& constructions,
+                           std::vector<SnapshotConstructionSquare>& squares,
+                           std::vector<SnapshotConstructionPoint>& points
+                           );
+
+
+/*****************************************************************************
+Module main function.
+Write every piece of world data read by the consumers to a snapshot file.
+The sites, entities and constructions are collected first, so the size of
+every section is known and the file can be created and mapped at once. The
+world tables are copied from world_data, and the region details of each
+world tile are generated like MapsExporter::generate_maps does
+*****************************************************************************/
+bool capture_world_snapshot(const std::string& file_name, // snapshot file
+                            WorldData& world_data,        // world tables read from DF
+                            Logger& logger                // progress output
+                            )
+{
+  int world_width  = world_data.world_width();
+  int world_height = world_data.world_height();
+  size_t world_tiles = (size_t)world_width * world_height;
+
+  std::vector<SnapshotSite>               sites;
+  std::vector<SnapshotEntity>             entities;
+  std::vector<SnapshotEntitySiteLink>     entity_site_links;
+  std::vector<SnapshotConstruction>       constructions;
+  std::vector<SnapshotConstructionSquare> construction_squares;
+  std::vector<SnapshotConstructionPoint>  construction_points;
+
+  capture_sites(sites);
+  capture_entities(entities, entity_site_links);
+  capture_constructions(constructions, construction_squares, construction_points);
+
+  WorldSnapshotWriter writer;
+  writer.add_section(SECTION_WORLD_INFO,           sizeof(SnapshotWorldInfo),          1);
+  writer.add_section(SECTION_REGION_MAP,           sizeof(SnapshotRegionMapEntry),     world_tiles);
+  writer.add_section(SECTION_REGIONS,              sizeof(SnapshotRegion),             world_data.num_regions());
+  writer.add_section(SECTION_RIVER_FLOW,           sizeof(int32_t),                    world_tiles);
+  writer.add_section(SECTION_REGION_DETAILS,       sizeof(SnapshotRegionDetails),      world_tiles);
+  writer.add_section(SECTION_SITES,                sizeof(SnapshotSite),               sites.size());
+  writer.add_section(SECTION_ENTITIES,             sizeof(SnapshotEntity),             entities.size());
+  writer.add_section(SECTION_ENTITY_SITE_LINKS,    sizeof(SnapshotEntitySiteLink),     entity_site_links.size());
+  writer.add_section(SECTION_CONSTRUCTIONS,        sizeof(SnapshotConstruction),       constructions.size());
+  writer.add_section(SECTION_CONSTRUCTION_SQUARES, sizeof(SnapshotConstructionSquare), construction_squares.size());
+  writer.add_section(SECTION_CONSTRUCTION_POINTS,  sizeof(SnapshotConstructionPoint),  construction_points.size());
+
+  if (!writer.create(file_name, world_width, world_height))
+  {
+    logger.log_line("ERROR: can't create the snapshot file " + file_name);
+    return false;
+  }
+
+  // Copy the tables already collected
+  if (!sites.empty())
+    memcpy(writer.records(SECTION_SITES), &sites[0], sites.size() * sizeof(SnapshotSite));
+  if (!entities.empty())
+    memcpy(writer.records(SECTION_ENTITIES), &entities[0], entities.size() * sizeof(SnapshotEntity));
+  if (!entity_site_links.empty())
+    memcpy(writer.records(SECTION_ENTITY_SITE_LINKS), &entity_site_links[0], entity_site_links.size() * sizeof(SnapshotEntitySiteLink));
+  if (!constructions.empty())
+    memcpy(writer.records(SECTION_CONSTRUCTIONS), &constructions[0], constructions.size() * sizeof(SnapshotConstruction));
+  if (!construction_squares.empty())
+    memcpy(writer.records(SECTION_CONSTRUCTION_SQUARES), &construction_squares[0], construction_squares.size() * sizeof(SnapshotConstructionSquare));
+  if (!construction_points.empty())
+    memcpy(writer.records(SECTION_CONSTRUCTION_POINTS), &construction_points[0], construction_points.size() * sizeof(SnapshotConstructionPoint));
+
+  // World tables
+  memcpy(writer.records(SECTION_WORLD_INFO), &world_data.world_info(), sizeof(SnapshotWorldInfo));
+
+  SnapshotRegion* regions = (SnapshotRegion*)writer.records(SECTION_REGIONS);
+  for (int i = 0; i < world_data.num_regions(); ++i)
+    regions[i] = *world_data.region(i);
+
+  SnapshotRegionMapEntry* region_map = (SnapshotRegionMapEntry*)writer.records(SECTION_REGION_MAP);
+  int32_t*                river_flow = (int32_t*)writer.records(SECTION_RIVER_FLOW);
+  for (int y = 0; y < world_height; ++y)
+    for (int x = 0; x < world_width; ++x)
+    {
+      region_map[(size_t)y * world_width + x] = world_data.region_map(x, y);
+      river_flow[(size_t)y * world_width + x] = world_data.river_flow(x, y);
+    }
+
+  // Sweep the world generating the region details of each world tile
+  SnapshotRegionDetails* region_details = (SnapshotRegionDetails*)writer.records(SECTION_REGION_DETAILS);
+  bool exit_by_error = false;
+
+  for (int y = 0; (y < world_height) && !exit_by_error; ++y)
+  {
+    logger.log("Capturing world row "); logger.log_number(y + 1, 3); logger.log(" /"); logger.log_number(world_height);
+    logger.log_cr();
+
+    for (int x = 0; (x < world_width) && !exit_by_error; ++x)
+      exit_by_error = !world_data.region_details(x, y, region_details[(size_t)y * world_width + x]);
+  }
+
+  logger.log_endl();
+
+  // Don't leave an incomplete snapshot on disk
+  writer.close(exit_by_error);
+
+  if (exit_by_error)
+    logger.log_line("ERROR capturing the world snapshot");
+  else
+    logger.log_line("World snapshot written to " + file_name);
+
+  return !exit_by_error;
+}
+
+//----------------------------------------------------------------------------//
+// Utility function
+// Copy the world sites
+//----------------------------------------------------------------------------//
+void capture_sites(std::vector<SnapshotSite>& sites)
+{
+  std::vector<df::world_site*>& world_sites = df::global::world->world_data->sites;
+
+  for (unsigned int i = 0; i < world_sites.size(); ++i)
+  {
+    df::world_site* world_site = world_sites[i];
+    if (world_site == nullptr) continue;
+
+    SnapshotSite site;
+    memset(&site, 0, sizeof(site));
+    site.id           = world_site->id;
+    site.type         = world_site->type;
+    site.flags_size   = world_site->flags.size;
+    site.flags        = world_site->flags.as_int();
+    site.global_min_x = world_site->global_min_x;
+    site.global_min_y = world_site->global_min_y;
+    site.global_max_x = world_site->global_max_x;
+    site.global_max_y = world_site->global_max_y;
+
+    for (unsigned int j = 0; j < world_site->inhabitants.size(); ++j)
+      if (world_site->inhabitants[j] != nullptr)
+        site.population += world_site->inhabitants[j]->count;
+
+    sites.push_back(site);
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Utility function
+// Copy the historical entities and their links to sites
+//----------------------------------------------------------------------------//
+void capture_entities(std::vector<SnapshotEntity>& entities,
+                      std::vector<SnapshotEntitySiteLink>& links
+                      )
+{
+  std::vector<df::historical_entity*>& all = df::global::world->entities.all;
+
+  for (unsigned int i = 0; i < all.size(); ++i)
+  {
+    df::historical_entity* entity = all[i];
+    if (entity == nullptr) continue;
+
+    SnapshotEntity snapshot_entity;
+    snapshot_entity.id              = entity->id;
+    snapshot_entity.type            = entity->type;
+    snapshot_entity.first_site_link = (uint32_t)links.size();
+
+    for (unsigned int j = 0; j < entity->site_links.size(); ++j)
+    {
+      df::entity_site_link* site_link = entity->site_links[j];
+      if (site_link == nullptr) continue;
+
+      SnapshotEntitySiteLink link;
+      link.target = site_link->target;
+      link.flags  = site_link->flags.whole;
+      links.push_back(link);
+    }
+
+    snapshot_entity.site_link_count = (uint32_t)links.size() - snapshot_entity.first_site_link;
+    entities.push_back(snapshot_entity);
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Utility function
+// Copy a construction square and its embark points
+//----------------------------------------------------------------------------//
+static void capture_construction_square(df::world_construction_square* constr_square,
+                                        bool stone,
+                                        std::vector<SnapshotConstructionSquare>& squares,
+                                        std::vector<SnapshotConstructionPoint>& points
+                                        )
+{
+  SnapshotConstructionSquare square;
+  memset(&square, 0, sizeof(square));
+  square.region_x    = constr_square->region_pos.x;
+  square.region_y    = constr_square->region_pos.y;
+  square.stone       = stone ? 1 : 0;
+  square.first_point = (uint32_t)points.size();
+
+  for (unsigned int k = 0; k < constr_square->embark_x.size(); ++k)
+  {
+    SnapshotConstructionPoint point;
+    point.embark_x = constr_square->embark_x[k];
+    point.embark_y = constr_square->embark_y[k];
+    points.push_back(point);
+  }
+
+  square.point_count = (uint32_t)points.size() - square.first_point;
+  squares.push_back(square);
+}
+
+//----------------------------------------------------------------------------//
+// Utility function
+// Copy roads, tunnels, bridges and walls. The material of each square is
+// reduced to the stone / other distinction that the sites map draws.
+// Bridges are located through the constructions map, as the sites consumer does
+//----------------------------------------------------------------------------//
+void capture_constructions(std::vector<SnapshotConstruction>& constructions,
+                           std::vector<SnapshotConstructionSquare>& squares,
+                           std::vector<SnapshotConstructionPoint>& points
+                           )
+{
+  df::world_data* world_data = df::global::world->world_data;
+
+  for (unsigned int i = 0; i < world_data->constructions.list.size(); ++i)
+  {
+    df::world_construction* construction = world_data->constructions.list[i];
+    if (construction == nullptr) continue;
+
+    SnapshotConstruction snapshot_construction;
+    snapshot_construction.id           = construction->id;
+    snapshot_construction.type         = construction->getType();
+    snapshot_construction.first_square = (uint32_t)squares.size();
+
+    switch (snapshot_construction.type)
+    {
+      case 0: // Road
+      case 1: // Tunnel
+      case 3: // Wall
+              for (unsigned int j = 0; j < construction->square_obj.size(); ++j)
+              {
+                df::world_construction_square* constr_square = construction->square_obj[j];
+                if (constr_square == nullptr) continue;
+
+                bool stone = true;
+                if (snapshot_construction.type == 0)
+                {
+                  df::world_construction_square_roadst* road = static_cast<df::world_construction_square_roadst*>(constr_square);
+                  stone = !((road->item_type == -1) || (road->mat_type != 0));
+                }
+                else if (snapshot_construction.type == 3)
+                {
+                  df::world_construction_square_wallst* wall = static_cast<df::world_construction_square_wallst*>(constr_square);
+                  stone = !((wall->item_type == -1) || (wall->mat_type != 0));
+                }
+
+                capture_construction_square(constr_square, stone, squares, points);
+              }
+              break;
+
+      case 2: // Bridge
+              if (construction->square_pos.x.size() > 0)
+              {
+                int pos_x = construction->square_pos.x[0];
+                int pos_y = construction->square_pos.y[0];
+                std::vector<df::world_construction_square*>& vec_constr = world_data->constructions.map[pos_x >> 4][pos_y >> 4];
+
+                for (unsigned int j = 0; j < vec_constr.size(); ++j)
+                {
+                  df::world_construction_square* constr_square = vec_constr[j];
+                  if (constr_square == nullptr) continue;
+                  if (constr_square->construction_id != construction->id) continue;
+                  if ((constr_square->region_pos.x != pos_x) || (constr_square->region_pos.y != pos_y)) continue;
+
+                  df::world_construction_square_bridgest* bridge = static_cast<df::world_construction_square_bridgest*>(constr_square);
+                  capture_construction_square(constr_square, bridge->item_type == 0, squares, points);
+                  break;
+                }
+              }
+              break;
+
+      default: break;
+    }
+
+    snapshot_construction.square_count = (uint32_t)squares.size() - snapshot_construction.first_square;
+    constructions.push_back(snapshot_construction);
+  }
+}
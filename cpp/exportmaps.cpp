@@ -19,11 +19,15 @@
 // You can always find the latest version of this plugin in Github
 // https://github.com/ragundo/exportmaps
 
-#include <algorithm>
 #include "../include/Mac_compat.h"
+#include "../include/dfhack.h"
+#include "../include/BackgroundExport.h"
+#include "../include/BufferPool.h"
 #include "../include/ExportMaps.h"
 #include "../include/Logger.h"
+#include "../include/RegionDetailsCache.h"
 #include "modules/Filesystem.h"
+#include "modules/Maps.h"
 #include "../../../library/include/DFHackVersion.h"
 #include "../../../library/include/Core.h"
 #include <df/world.h>
@@ -53,18 +57,31 @@ extern unsigned int init_world_site_realization_address;
 extern unsigned int delete_world_site_realization_address;
 
 //----------------------------------------------------------------------------//
-//Local function definitions
+// External functions
 //----------------------------------------------------------------------------//
-std::tuple<unsigned int,
-           unsigned int,
-           unsigned int,
-           std::vector<int>
-          >process_command_line(std::vector <std::string>& options);
+extern bool capture_world_snapshot(const std::string& file_name,
+                                   WorldData& world_data,
+                                   Logger& logger
+                                   );
+
+extern std::tuple<unsigned int,
+                  unsigned int,
+                  unsigned int,
+                  std::vector<int>
+                 >process_command_line(std::vector <std::string>& options,
+                                       ExportOptions& export_options);
 
 //----------------------------------------------------------------------------//
 // Plugin global variables
 //----------------------------------------------------------------------------//
-MapsExporter maps_exporter;
+MapsExporter          maps_exporter;
+BackgroundExport      background_export;
+RegionDetailsCache    region_details_cache;
+
+// World data of a background export that generates the region details from
+// plugin_onupdate, owned by background_export
+FrameSlicedWorldData* frame_sliced_data = nullptr;
+unsigned int          tiles_per_frame   = 0;
 
 
 //----------------------------------------------------------------------------//
@@ -89,12 +106,40 @@ DFhackCExport command_result plugin_enable(color_ostream &out, bool enable)
 //----------------------------------------------------------------------------//
 DFhackCExport command_result plugin_shutdown (color_ostream& con)
 {
+    // The background export uses the map buffers. Without plugin_onupdate
+    // it would never get the rest of its region details
+    if (frame_sliced_data != nullptr)
+        frame_sliced_data->cancel();
+    if (background_export.is_running())
+        con << "Waiting for the background export to finish" << std::endl;
+    background_export.wait();
+    frame_sliced_data = nullptr;
+    region_details_cache.close();
+
+    // Free the map buffers kept between exports
+    BufferPool::release();
     return CR_OK;
 }
 
 //----------------------------------------------------------------------------//
 DFhackCExport command_result plugin_onupdate ( color_ostream& out )
 {
+    // Generate the next region details of the background export, DF is
+    // paused while the plugins are updated
+    if (frame_sliced_data != nullptr)
+    {
+        if (background_export.is_running())
+            frame_sliced_data->generate(tiles_per_frame);
+        else
+        {
+            // Frees the world data
+            background_export.wait();
+            frame_sliced_data = nullptr;
+            region_details_cache.close();
+            s_enabled = false;
+            out << "Background export done, see the results with exportmaps -status" << std::endl;
+        }
+    }
     return CR_OK;
 }
 
@@ -106,15 +151,6 @@ DFhackCExport command_result exportmaps (color_ostream& con,                   /
                                          std::vector <std::string>& parameters // Parameters received by the console
                                         )
 {
-  // Pause DF or it will crash for sure
-  CoreSuspender pause;
-
-  // Init the loger object
-  Logger logger(con);
-
-  // And associate it with the map exportes
-  maps_exporter.set_logger(&logger);
-
   // Process command line arguments
   std::tuple<unsigned int,
              unsigned int,
@@ -126,7 +162,9 @@ DFhackCExport command_result exportmaps (color_ostream& con,                   /
   // tuple.second is a uint ehere each bit ON means a raw map type to be generated
   // tuple.third is a uint ehere each bit ON means a heightmap type to be generated
   // tuple.fourth is a vector with indexes to wrong arguments in the command line
-  command_line = process_command_line(parameters);
+  // export_options is filled with the options that change how the maps are exported
+  ExportOptions export_options;
+  command_line = process_command_line(parameters, export_options);
 
   // Alias to the vector of index to wrong options
   std::vector<int>& unknown_options = std::get<3>(command_line);
@@ -136,22 +174,207 @@ DFhackCExport command_result exportmaps (color_ostream& con,                   /
     if (unknown_options[i] != -1)
       con << "ERROR: unknown command line option: " << parameters[unknown_options[i]] << std::endl;
 
-  // No data can be generated if a world is not loaded, so check it
-  if (df::global::world->world_data == nullptr)
+  // The state of the background export doesn't need DF
+  if (export_options.status)
+  {
+    background_export.status(con);
+    return CR_OK;
+  }
+
+  // The background export uses the map buffers and writes the same files
+  if (background_export.is_running())
   {
-    con << "ERROR: no world loaded" << std::endl;
+    con << "ERROR: a background export is running, check it with exportmaps -status" << std::endl;
     return CR_OK;
   }
 
-  // Choose what maps to export
-  maps_exporter.setup_maps(std::get<0>(command_line), // Graphical maps
-                           std::get<1>(command_line), // Raw maps
-                           std::get<2>(command_line)  // Height maps
-                           );
+  // A finished background export keeps its world data until it's joined
+  background_export.wait();
+  frame_sliced_data = nullptr;
+  region_details_cache.close();
+
+  // A preview is fast enough to be made with the game paused
+  bool background = (export_options.background || (export_options.tiles_per_frame != 0)) &&
+                    !export_options.preview;
+
+  // World data rendered in the background, and snapshot to delete after it
+  WorldData*  background_data = nullptr;
+  std::string remove_file;
+
+  // Maps that read DF while they're generated
+  uint32_t df_only_maps     = std::get<0>(command_line) & DF_ONLY_MAPS;
+  uint32_t df_only_maps_raw = std::get<1>(command_line) & DF_ONLY_MAPS_RAW;
+
+  // DF is only paused while the world data is read
+  {
+    // Pause DF or it will crash for sure
+    CoreSuspender pause;
+
+    // Init the loger object
+    Logger logger(con);
+
+    // And associate it with the map exportes
+    maps_exporter.set_logger(&logger);
+
+    // The map buffers are kept between exports, as the next one will need
+    // the same sizes. Free them if asked to
+    if (export_options.release_buffers)
+    {
+      con << "Released " << (BufferPool::release() >> 20) << " MB of map buffers" << std::endl;
+
+      // Nothing else to do if no maps were requested
+      if ((std::get<0>(command_line) | std::get<1>(command_line) | std::get<2>(command_line)) == 0)
+        return CR_OK;
+    }
+
+    // No data can be generated if a world is not loaded, so check it
+    if (df::global::world->world_data == nullptr)
+    {
+      con << "ERROR: no world loaded" << std::endl;
+      return CR_OK;
+    }
+
+    // A rectangle around the current fortress or adventurer position
+    if (export_options.rect_embark_radius >= 0)
+    {
+      if (!Maps::IsValid())
+      {
+        con << "ERROR: -rect-embark needs a fortress or adventure mode map loaded" << std::endl;
+        return CR_OK;
+      }
+
+      // The map position is in embark tiles, 16 for each world tile, and its
+      // size in blocks, 3 for each embark tile
+      int32_t  region_x, region_y, region_z;
+      uint32_t size_x, size_y, size_z;
+      Maps::getPosition(region_x, region_y, region_z);
+      Maps::getSize(size_x, size_y, size_z);
+
+      int center_x = (region_x + (int)size_x / 6) / 16;
+      int center_y = (region_y + (int)size_y / 6) / 16;
+
+      export_options.rect    = true;
+      export_options.rect_x0 = center_x - export_options.rect_embark_radius;
+      export_options.rect_y0 = center_y - export_options.rect_embark_radius;
+      export_options.rect_x1 = center_x + export_options.rect_embark_radius;
+      export_options.rect_y1 = center_y + export_options.rect_embark_radius;
+    }
+
+    // Copy the world tables read by the maps
+    DFWorldData world_data;
+    maps_exporter.set_world_data(&world_data);
+
+    // Read the region details generated in previous exports of this world from
+    // the cache file, and add there the ones that DF generates now
+    if (export_options.region_cache)
+    {
+      if (region_details_cache.open(world_data.world_folder() + "-exportmaps.rdcache",
+                                    world_data.world_width(),
+                                    world_data.world_height()
+                                    ))
+        world_data.set_region_details_cache(&region_details_cache);
+      else
+        con << "WARNING: the region details cache file can't be created" << std::endl;
+    }
+
+    if (!background)
+    {
+      // Capture the world data for offline rendering
+      if (!export_options.snapshot_file.empty())
+        capture_world_snapshot(export_options.snapshot_file, world_data, logger);
+
+      // Generate the maps, in several sweeps of the world if they don't fit in
+      // the memory budget, using the logger object for updating the progress
+      // to the DFHack console
+      maps_exporter.export_maps(std::get<0>(command_line), // Graphical maps
+                                std::get<1>(command_line), // Raw maps
+                                std::get<2>(command_line), // Height maps
+                                export_options,            // How to export them
+                                logger
+                                );
+    }
+    else if (export_options.tiles_per_frame != 0)
+    {
+      // The region details are generated from plugin_onupdate while the game
+      // runs, and these maps can only be drawn with the game paused
+      if (df_only_maps | df_only_maps_raw)
+        con << "WARNING: sites, trading, nobility and diplomacy maps are skipped with -tiles-per-frame" << std::endl;
+
+      frame_sliced_data = new FrameSlicedWorldData(2 * (size_t)export_options.tiles_per_frame);
+      if (region_details_cache.is_open())
+        frame_sliced_data->set_region_details_cache(&region_details_cache);
+      background_data = frame_sliced_data;
+    }
+    else
+    {
+      // All the world data read by the maps, including the region details of
+      // every world tile, is copied to a snapshot while the game is paused
+      std::string snapshot_file = export_options.snapshot_file;
+      if (snapshot_file.empty())
+      {
+        snapshot_file = world_data.world_folder() + "-exportmaps-background.snap";
+        remove_file   = snapshot_file;
+      }
+
+      SnapshotWorldData* captured_data = new SnapshotWorldData;
+      if (!capture_world_snapshot(snapshot_file, world_data, logger) ||
+          !captured_data->open(snapshot_file))
+      {
+        con << "ERROR: the world data can't be captured to " << snapshot_file << std::endl;
+        delete captured_data;
+        return CR_OK;
+      }
+      background_data = captured_data;
+
+      // The sites, trading, nobility and diplomacy maps read the sites and
+      // entities from DF, so they're generated now, reading the region details
+      // from the snapshot instead of generating them again. They're not
+      // tracked by -incremental, as the rest of the maps are exported apart
+      if (df_only_maps | df_only_maps_raw)
+      {
+        ExportOptions df_only_options = export_options;
+        df_only_options.incremental = false;
+
+        maps_exporter.set_world_data(captured_data);
+        maps_exporter.export_maps(df_only_maps,
+                                  df_only_maps_raw,
+                                  0,
+                                  df_only_options,
+                                  logger
+                                  );
+        maps_exporter.set_world_data(nullptr);
+      }
+    }
+
+    // The cache is still being filled by a frame sliced export
+    if (region_details_cache.is_open() && (frame_sliced_data == nullptr))
+    {
+      con << "Region details cache: " << region_details_cache.hits()   << " world tiles read, "
+                                      << region_details_cache.stores() << " generated by DF" << std::endl;
+      region_details_cache.close();
+    }
+  }
 
-  // Begin generating data for the threads(consumers) and use the logger
-  // object for updating the progress to the DFHack console
-  maps_exporter.generate_maps(logger);
+  // The game runs again while the rest of the maps are generated
+  if (background)
+  {
+    background_export.start(background_data,
+                            remove_file,
+                            std::get<0>(command_line) & ~DF_ONLY_MAPS,
+                            std::get<1>(command_line) & ~DF_ONLY_MAPS_RAW,
+                            std::get<2>(command_line),
+                            export_options
+                            );
+
+    // plugin_onupdate is only called while the plugin is enabled
+    if (frame_sliced_data != nullptr)
+    {
+      tiles_per_frame = export_options.tiles_per_frame;
+      s_enabled       = true;
+      con << "Generating " << tiles_per_frame << " world tiles per frame" << std::endl;
+    }
+    con << "Rendering the maps in the background, check the progress with exportmaps -status" << std::endl;
+  }
 
   // Done
   return CR_OK;
@@ -205,248 +428,3 @@ DFhackCExport command_result plugin_init (color_ostream& con,
 
     return CR_OK;
 }
-
-//----------------------------------------------------------------------------//
-// Process the command line arguments
-// returns a tuple, where
-// tuple.first is a uint bit each bit meaning a graphical map type to be generated
-// tuple.second is a uint bit each bit meaning a raw map type to be generated
-// tuple.third is a vector with index to wrong arguments
-//----------------------------------------------------------------------------//
-std::tuple<unsigned int, unsigned int, unsigned int, std::vector<int> >
-process_command_line(std::vector <std::string>& options)
-{
-  unsigned int     maps_to_generate     = 0; // Graphical maps to generate
-  unsigned int     maps_to_generate_raw = 0; // Raw maps to generate
-  unsigned int     maps_to_generate_hm  = 0; // Heightmaps to generate
-  std::vector<int> errors(options.size());   // Vector with index to wrong command line options
-
-  // Iterate over all the command line options received
-  for ( unsigned int argv_iterator = 0; argv_iterator < options.size(); ++argv_iterator)
-  {
-    // Get a command line option
-    std::string option = options[argv_iterator];
-
-    // Convert to lowercase
-    std::transform(option.begin(), option.end(), option.begin(), ::tolower);
-
-    // No error in argument until now
-    errors[argv_iterator] = -1;
-
-    // Check command line
-    if (option == "-all-df")                                       // All DF maps
-    {
-		maps_to_generate = -1; continue;
-	}
-
-    if (option == "-all-raw")                                 // All raws maps
-    {
-		maps_to_generate_raw = -1; continue;
-	}
-
-    if (option == "-all-hm")                                  // All raws maps
-    {
-		maps_to_generate_hm = -1; continue;
-	}
-
-    if (option == "-temperature")                                  // map DF style
-    {
-		maps_to_generate |= MapType::TEMPERATURE; continue;
-	}
-
-    if (option == "-rainfall")                                // map DF style
-    {
-		maps_to_generate |= MapType::RAINFALL; continue;
-	}
-
-    if (option == "-region")                                  // map DF style
-    {
-		maps_to_generate |= MapType::REGION; continue;
-	}
-
-    if (option == "-drainage")                                // map DF style
-    {
-		maps_to_generate |= MapType::DRAINAGE; continue;
-	}
-
-    if (option == "-savagery")                                // map DF style
-    {
-		maps_to_generate |= MapType::SAVAGERY; continue;
-	}
-
-    if (option == "-volcanism")                               // map DF style
-    {
-		maps_to_generate |= MapType::VOLCANISM; continue;
-	}
-
-    if (option == "-vegetation")                              // map DF style
-    {
-		maps_to_generate |= MapType::VEGETATION; continue;
-	}
-
-    if (option == "-evilness")                                // map DF style
-    {
-		maps_to_generate |= MapType::EVILNESS; continue;
-	}
-
-    if (option == "-salinity")                                // map DF style
-    {
-		maps_to_generate |= MapType::SALINITY; continue;
-	}
-
-    if (option == "-hydrosphere")                             // map DF style
-    {
-		maps_to_generate |= MapType::HYDROSPHERE; continue;
-	}
-
-    if (option == "-elevation")                               // map DF style
-    {
-		maps_to_generate |= MapType::ELEVATION; continue;
-	}
-
-    if (option == "-elevation-water")                         // map DF style
-    {
-		maps_to_generate |= MapType::ELEVATION_WATER; continue;
-	}
-
-    if (option == "-biome")                                   // map DF style
-    {
-		maps_to_generate |= MapType::BIOME; continue;
-	}
-
-    if (option == "-trading")                                 // map DF style
-    {
-		maps_to_generate |= MapType::TRADING; continue;
-	}
-
-    if (option == "-nobility")                                // map DF style
-     {
-		 maps_to_generate |= MapType::NOBILITY; continue;
-	}
-
-    if (option == "-diplomacy")                               // map DF style
-    {
-		 maps_to_generate |= MapType::DIPLOMACY; continue;
-	}
-
-    if (option == "-sites")                                   // map DF style
-    {
-#ifndef _DARWIN
-		maps_to_generate |= MapType::SITES; 
-#endif
-	
-		continue;
-	}
-
-
-    // Raw maps
-
-    if (option == "-temperature-raw")                         // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::TEMPERATURE_RAW; continue;
-	}
-
-    if (option == "-rainfall-raw")                            // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::RAINFALL_RAW; continue;
-	}
-
-    if (option == "-drainage-raw")                            // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::DRAINAGE_RAW; continue;
-	}
-
-    if (option == "-savagery-raw")                            // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::SAVAGERY_RAW; continue;
-	}
-
-    if (option == "-volcanism-raw")                           // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::VOLCANISM_RAW; continue;
-	}
-
-    if (option == "-vegetation-raw")                          // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::VEGETATION_RAW; continue;
-	}
-
-    if (option == "-evilness-raw")                            // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::EVILNESS_RAW; continue;
-	}
-
-    if (option == "-salinity-raw")                            // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::SALINITY_RAW; continue;
-	}
-
-    if (option == "-hydrosphere-raw")                         // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::HYDROSPHERE_RAW; continue;
-	}
-
-    if (option == "-elevation-raw")                           // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::ELEVATION_RAW; continue;
-	}
-
-    if (option == "-elevation-water-raw")                     // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::ELEVATION_WATER_RAW; continue;
-	}
-
-    if (option == "-biome-raw")                               // map raw data file
-    {
-      maps_to_generate_raw |= MapTypeRaw::BIOME_TYPE_RAW;
-      maps_to_generate_raw |= MapTypeRaw::BIOME_REGION_RAW; 
-	  continue;
-    }
-
-    if (option == "-trading-raw")                             // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::TRADING_RAW; continue;
-	}
-
-    if (option == "-nobility-raw")                            // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::NOBILITY_RAW; continue;
-	}
-
-    if (option == "-diplomacy-raw")                           // map raw data file
-    {
-		maps_to_generate_raw |= MapTypeRaw::DIPLOMACY_RAW; continue;
-	}
-
-    if (option == "-sites-raw")                               // map raw data file
-    {
-#ifndef _DARWIN
-		maps_to_generate_raw |= MapTypeRaw::SITES_RAW; continue;
-#endif
-	}
-
-    // Heightmaps
-
-    if (option == "-elevation-hm")                            // Heighmap style
-    {
-		maps_to_generate_hm |= MapTypeHeightMap::ELEVATION_HM; continue;
-	}
-
-    if (option == "-elevation-water-hm")                      // Heightmap style
-    {
-		maps_to_generate_hm |= MapTypeHeightMap::ELEVATION_WATER_HM; continue;
-	}
-
-    // ERROR - unknown argument
-      errors[argv_iterator] = argv_iterator;
-  }
-  return std::tuple<unsigned int,
-                    unsigned int,
-                    unsigned int,
-                    std::vector<int>
-                   >(maps_to_generate,
-                     maps_to_generate_raw,
-                     maps_to_generate_hm,
-                     errors
-                     );
-}
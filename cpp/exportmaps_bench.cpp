@@ -0,0 +1,585 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../include/Mac_compat.h"
+#include "../include/ExportMaps.h"
+#include "../include/Logger.h"
+#include "../include/WorldData.h"
+#include "../include/WorldGenerator.h"
+
+using namespace exportmaps_plugin;
+
+/*****************************************************************************
+ Allocation counter.
+ Every operator new of the benchmark program goes through here, so the
+ allocations done by a kernel are the difference of the counter
+*****************************************************************************/
+static std::atomic<unsigned long long> allocation_count(0);
+
+void* operator new(size_t size)
+{
+  ++allocation_count;
+  void* p = malloc(size ? size : 1);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+// Sized version, called instead of the one above by C++14 compilers
+void operator delete(void* p, std::size_t) noexcept
+{
+  free(p);
+}
+
+//----------------------------------------------------------------------------//
+// External functions
+//----------------------------------------------------------------------------//
+extern std::pair<int,int> adjust_coordinates_to_region(int x,
+                                                       int y,
+                                                       int delta,
+                                                       int pos_x,
+                                                       int pos_y,
+                                                       int world_width,
+                                                       int world_height
+                                                       );
+
+extern bool temperature_do_work              (MapsExporter* maps_exporter);
+extern bool rainfall_do_work                 (MapsExporter* maps_exporter);
+extern bool drainage_do_work                 (MapsExporter* maps_exporter);
+extern bool savagery_do_work                 (MapsExporter* maps_exporter);
+extern bool volcanism_do_work                (MapsExporter* maps_exporter);
+extern bool vegetation_do_work               (MapsExporter* maps_exporter);
+extern bool evilness_do_work                 (MapsExporter* maps_exporter);
+extern bool salinity_do_work                 (MapsExporter* maps_exporter);
+extern bool hydro_do_work                    (MapsExporter* maps_exporter);
+extern bool elevation_do_work                (MapsExporter* maps_exporter);
+extern bool elevation_water_do_work          (MapsExporter* maps_exporter);
+extern bool biome_do_work                    (MapsExporter* maps_exporter);
+extern bool region_do_work                   (MapsExporter* maps_exporter);
+
+extern bool temperature_raw_do_work          (MapsExporter* maps_exporter);
+extern bool rainfall_raw_do_work             (MapsExporter* maps_exporter);
+extern bool drainage_raw_do_work             (MapsExporter* maps_exporter);
+extern bool savagery_raw_do_work             (MapsExporter* maps_exporter);
+extern bool volcanism_raw_do_work            (MapsExporter* maps_exporter);
+extern bool vegetation_raw_do_work           (MapsExporter* maps_exporter);
+extern bool evilness_raw_do_work             (MapsExporter* maps_exporter);
+extern bool salinity_raw_do_work             (MapsExporter* maps_exporter);
+extern bool hydro_raw_do_work                (MapsExporter* maps_exporter);
+extern bool elevation_raw_do_work            (MapsExporter* maps_exporter);
+extern bool elevation_water_raw_do_work      (MapsExporter* maps_exporter);
+extern bool biome_type_raw_do_work           (MapsExporter* maps_exporter);
+extern bool biome_region_raw_do_work         (MapsExporter* maps_exporter);
+
+extern bool elevation_heightmap_do_work      (MapsExporter* maps_exporter, int max_world_elevation);
+extern bool elevation_water_heightmap_do_work(MapsExporter* maps_exporter, int max_world_elevation);
+
+// The heightmap kernels receive the scale from their thread
+static bool elevation_hm_do_work(MapsExporter* maps_exporter)
+{
+  return elevation_heightmap_do_work(maps_exporter, maps_exporter->get_world_data()->max_elevation());
+}
+
+static bool elevation_water_hm_do_work(MapsExporter* maps_exporter)
+{
+  return elevation_water_heightmap_do_work(maps_exporter, maps_exporter->get_world_data()->max_elevation());
+}
+
+/*****************************************************************************
+ Benchmark definitions
+*****************************************************************************/
+
+// A consumer kernel and the map it draws
+struct KernelBenchmark
+{
+  const char* name;
+  uint32_t    maps;                          // MapType bit
+  uint32_t    maps_raw;                      // MapTypeRaw bit
+  uint32_t    maps_hm;                       // MapTypeHeightMap bit
+  int         bytes_per_pixel;               // Size of a pixel of the map
+  bool        (*do_work)(MapsExporter*);     // Consumer kernel
+};
+
+static const KernelBenchmark kernels[] =
+{
+  { "temperature",           MapType::TEMPERATURE,     0,                               0,                                    4, temperature_do_work               },
+  { "rainfall",              MapType::RAINFALL,        0,                               0,                                    4, rainfall_do_work                  },
+  { "drainage",              MapType::DRAINAGE,        0,                               0,                                    4, drainage_do_work                  },
+  { "savagery",              MapType::SAVAGERY,        0,                               0,                                    4, savagery_do_work                  },
+  { "volcanism",             MapType::VOLCANISM,       0,                               0,                                    4, volcanism_do_work                 },
+  { "vegetation",            MapType::VEGETATION,      0,                               0,                                    4, vegetation_do_work                },
+  { "evilness",              MapType::EVILNESS,        0,                               0,                                    4, evilness_do_work                  },
+  { "salinity",              MapType::SALINITY,        0,                               0,                                    4, salinity_do_work                  },
+  { "hydrosphere",           MapType::HYDROSPHERE,     0,                               0,                                    4, hydro_do_work                     },
+  { "elevation",             MapType::ELEVATION,       0,                               0,                                    4, elevation_do_work                 },
+  { "elevation-water",       MapType::ELEVATION_WATER, 0,                               0,                                    4, elevation_water_do_work           },
+  { "biome",                 MapType::BIOME,           0,                               0,                                    4, biome_do_work                     },
+  { "region",                MapType::REGION,          0,                               0,                                    4, region_do_work                    },
+
+  { "temperature-raw",       0,                        MapTypeRaw::TEMPERATURE_RAW,     0,                                    2, temperature_raw_do_work           },
+  { "rainfall-raw",          0,                        MapTypeRaw::RAINFALL_RAW,        0,                                    2, rainfall_raw_do_work              },
+  { "drainage-raw",          0,                        MapTypeRaw::DRAINAGE_RAW,        0,                                    2, drainage_raw_do_work              },
+  { "savagery-raw",          0,                        MapTypeRaw::SAVAGERY_RAW,        0,                                    2, savagery_raw_do_work              },
+  { "volcanism-raw",         0,                        MapTypeRaw::VOLCANISM_RAW,       0,                                    2, volcanism_raw_do_work             },
+  { "vegetation-raw",        0,                        MapTypeRaw::VEGETATION_RAW,      0,                                    2, vegetation_raw_do_work            },
+  { "evilness-raw",          0,                        MapTypeRaw::EVILNESS_RAW,        0,                                    2, evilness_raw_do_work              },
+  { "salinity-raw",          0,                        MapTypeRaw::SALINITY_RAW,        0,                                    2, salinity_raw_do_work              },
+  { "hydrosphere-raw",       0,                        MapTypeRaw::HYDROSPHERE_RAW,     0,                                    2, hydro_raw_do_work                 },
+  { "elevation-raw",         0,                        MapTypeRaw::ELEVATION_RAW,       0,                                    2, elevation_raw_do_work             },
+  { "elevation-water-raw",   0,                        MapTypeRaw::ELEVATION_WATER_RAW, 0,                                    2, elevation_water_raw_do_work       },
+  { "biome-type-raw",        0,                        MapTypeRaw::BIOME_TYPE_RAW,      0,                                    2, biome_type_raw_do_work            },
+  { "biome-region-raw",      0,                        MapTypeRaw::BIOME_REGION_RAW,    0,                                    2, biome_region_raw_do_work          },
+
+  { "elevation-hm",          0,                        0,                               MapTypeHeightMap::ELEVATION_HM,       2, elevation_hm_do_work              },
+  { "elevation-water-hm",    0,                        0,                               MapTypeHeightMap::ELEVATION_WATER_HM, 2, elevation_water_hm_do_work        }
+};
+
+// Measures of a benchmark
+struct BenchmarkResult
+{
+  std::string        name;
+  double             seconds;                // Best time of all the repetitions
+  unsigned long long pixels;                 // Pixels processed
+  double             bytes;                  // Bytes written
+  unsigned long long allocations;            // Allocations of the best repetition
+  unsigned long long tiles;                  // World tiles processed
+
+  double ns_per_pixel()    const { return pixels  ? seconds * 1e9 / pixels : 0.0; }
+  double mb_per_s()        const { return seconds > 0.0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0; }
+  double allocs_per_tile() const { return tiles   ? (double)allocations / tiles : 0.0; }
+};
+
+typedef std::chrono::steady_clock BenchmarkClock;
+
+// Results of the helpers are stored here, so the compiler can't remove the calls
+static volatile int benchmark_sink;
+
+static double elapsed_seconds(BenchmarkClock::time_point start)
+{
+  return std::chrono::duration<double>(BenchmarkClock::now() - start).count();
+}
+
+//----------------------------------------------------------------------------//
+// Keep the best repetition
+//----------------------------------------------------------------------------//
+static void keep_best(BenchmarkResult& best, const BenchmarkResult& result)
+{
+  if ((best.seconds <= 0.0) || (result.seconds < best.seconds))
+    best = result;
+}
+
+//----------------------------------------------------------------------------//
+// Run a consumer kernel over the whole world in this thread, pushing each
+// world tile to its queue and processing it right away. The time of the
+// kernel and the time of encoding the map to disk are measured apart
+//----------------------------------------------------------------------------//
+static void run_kernel(const KernelBenchmark& kernel,
+                       WorldData& world_data,
+                       Logger& logger,
+                       BenchmarkResult& work,
+                       BenchmarkResult& encode
+                       )
+{
+  int world_width  = world_data.world_width();
+  int world_height = world_data.world_height();
+  unsigned long long tiles  = (unsigned long long)world_width * world_height;
+  unsigned long long pixels = tiles * 16 * 16;
+
+  MapsExporter maps_exporter;
+  maps_exporter.set_logger(&logger);
+  maps_exporter.set_world_data(&world_data);
+  maps_exporter.setup_maps(kernel.maps, kernel.maps_raw, kernel.maps_hm, ExportOptions());
+
+  SnapshotRegionDetails rd;
+  double             seconds     = 0.0;
+  unsigned long long allocations = 0;
+
+  for (int y = 0; y < world_height; ++y)
+    for (int x = 0; x < world_width; ++x)
+    {
+      if (!world_data.region_details(x, y, rd))
+        continue;
+
+      unsigned long long allocations_before = allocation_count;
+      BenchmarkClock::time_point start = BenchmarkClock::now();
+
+      maps_exporter.push_data(rd, x, y);
+      kernel.do_work(&maps_exporter);
+
+      seconds     += elapsed_seconds(start);
+      allocations += allocation_count - allocations_before;
+    }
+
+  // Let the kernel see the end marker, as the consumer thread does
+  maps_exporter.push_end();
+  kernel.do_work(&maps_exporter);
+
+  work.name        = kernel.name;
+  work.seconds     = seconds;
+  work.pixels      = pixels;
+  work.bytes       = (double)pixels * kernel.bytes_per_pixel;
+  work.allocations = allocations;
+  work.tiles       = tiles;
+
+  unsigned long long allocations_before = allocation_count;
+  BenchmarkClock::time_point start = BenchmarkClock::now();
+
+  maps_exporter.write_maps_to_disk(logger);
+
+  encode.name        = std::string(kernel.name) + "/write_to_disk";
+  encode.seconds     = elapsed_seconds(start);
+  encode.pixels      = pixels;
+  encode.bytes       = work.bytes;
+  encode.allocations = allocation_count - allocations_before;
+  encode.tiles       = tiles;
+
+  maps_exporter.cleanup();
+}
+
+//----------------------------------------------------------------------------//
+// adjust_coordinates_to_region for every pixel of the world
+//----------------------------------------------------------------------------//
+static BenchmarkResult run_adjust_coordinates(WorldData& world_data)
+{
+  int world_width  = world_data.world_width();
+  int world_height = world_data.world_height();
+
+  SnapshotRegionDetails rd;
+  double             seconds     = 0.0;
+  unsigned long long allocations = 0;
+
+  for (int y = 0; y < world_height; ++y)
+    for (int x = 0; x < world_width; ++x)
+    {
+      if (!world_data.region_details(x, y, rd))
+        continue;
+
+      unsigned long long allocations_before = allocation_count;
+      BenchmarkClock::time_point start = BenchmarkClock::now();
+
+      for (int i = 0; i < 16; ++i)
+        for (int j = 0; j < 16; ++j)
+        {
+          std::pair<int,int> adjusted = adjust_coordinates_to_region(i,
+                                                                     j,
+                                                                     rd.biome[i][j],
+                                                                     x,
+                                                                     y,
+                                                                     world_width,
+                                                                     world_height
+                                                                     );
+          benchmark_sink = adjusted.first + adjusted.second;
+        }
+
+      seconds     += elapsed_seconds(start);
+      allocations += allocation_count - allocations_before;
+    }
+
+  BenchmarkResult result;
+  result.name        = "adjust_coordinates_to_region";
+  result.seconds     = seconds;
+  result.tiles       = (unsigned long long)world_width * world_height;
+  result.pixels      = result.tiles * 16 * 16;
+  result.bytes       = (double)result.pixels * sizeof(std::pair<int,int>);
+  result.allocations = allocations;
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+// Biome type lookup for every pixel of the world. Stands for get_biome_type,
+// that computes the same value reading DF memory
+//----------------------------------------------------------------------------//
+static BenchmarkResult run_biome_type(WorldData& world_data)
+{
+  int world_width  = world_data.world_width();
+  int world_height = world_data.world_height();
+
+  unsigned long long allocations_before = allocation_count;
+  BenchmarkClock::time_point start = BenchmarkClock::now();
+
+  // Each pixel reads the biome of its world tile, as the kernels do
+  for (int y = 0; y < world_height; ++y)
+    for (int x = 0; x < world_width; ++x)
+      for (int k = 0; k < 16 * 16; ++k)
+        benchmark_sink = world_data.biome_type(x, y);
+
+  BenchmarkResult result;
+  result.name        = "biome_type";
+  result.seconds     = elapsed_seconds(start);
+  result.tiles       = (unsigned long long)world_width * world_height;
+  result.pixels      = result.tiles * 16 * 16;
+  result.bytes       = (double)result.pixels * sizeof(int);
+  result.allocations = allocation_count - allocations_before;
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+// ExportedMapRaw::write_data for every pixel of the world
+//----------------------------------------------------------------------------//
+static BenchmarkResult run_raw_write_data(WorldData& world_data)
+{
+  int world_width  = world_data.world_width();
+  int world_height = world_data.world_height();
+  const char* file_name = "exportmaps-bench-write-data.raw";
+
+  BenchmarkResult result;
+  result.name   = "ExportedMapRaw::write_data";
+  result.tiles  = (unsigned long long)world_width * world_height;
+  result.pixels = result.tiles * 16 * 16;
+  result.bytes  = (double)result.pixels * 2;
+
+  {
+    MapWindow window = { 0, 0, world_width, world_height };
+    ExportedMapRaw map(file_name, window, MapTypeRaw::TEMPERATURE_RAW);
+
+    unsigned long long allocations_before = allocation_count;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+
+    for (int y = 0; y < world_height; ++y)
+      for (int x = 0; x < world_width; ++x)
+        for (int py = 0; py < 16; ++py)
+          for (int px = 0; px < 16; ++px)
+            map.write_data(x, y, px, py, px + py);
+
+    result.seconds     = elapsed_seconds(start);
+    result.allocations = allocation_count - allocations_before;
+  }
+
+  remove(file_name);
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+// Write the results as JSON, one object per benchmark keyed by its name, so
+// two runs can be compared with a diff
+//----------------------------------------------------------------------------//
+static bool write_json(const std::string& file_name,
+                       const std::string& world_source,
+                       WorldData& world_data,
+                       const std::vector<BenchmarkResult>& results
+                       )
+{
+  std::ofstream out(file_name.c_str());
+  if (!out)
+    return false;
+
+  out << std::fixed << std::setprecision(3);
+  out << "{\n";
+  out << "  \"world\": {\n";
+  out << "    \"source\": \"" << world_source << "\",\n";
+  out << "    \"width\": "    << world_data.world_width()  << ",\n";
+  out << "    \"height\": "   << world_data.world_height() << "\n";
+  out << "  },\n";
+  out << "  \"benchmarks\": {\n";
+
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const BenchmarkResult& r = results[i];
+    out << "    \"" << r.name << "\": { "
+        << "\"ns_per_pixel\": "    << r.ns_per_pixel()    << ", "
+        << "\"mb_per_s\": "        << r.mb_per_s()        << ", "
+        << "\"allocs_per_tile\": " << r.allocs_per_tile() << " }"
+        << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+
+  out << "  }\n";
+  out << "}\n";
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Run the benchmarks selected by filter over a snapshot, print them and
+// write them as JSON if json_file is not empty
+//----------------------------------------------------------------------------//
+static int run_benchmarks(const std::string& snapshot_file, // World to benchmark
+                          const std::string& world_source,  // Description of the world
+                          const std::string& filter,        // Part of the names to run, or empty
+                          int repeat,                       // Repetitions of each benchmark
+                          const std::string& json_file      // JSON output or empty
+                          )
+{
+  SnapshotWorldData world_data;
+  if (!world_data.open(snapshot_file))
+  {
+    std::cerr << "ERROR: " << snapshot_file << " is not a valid world snapshot" << std::endl;
+    return 1;
+  }
+
+  // The maps progress messages are not wanted
+  std::ostream null_stream(nullptr);
+  Logger logger(null_stream);
+
+  std::vector<BenchmarkResult> results;
+
+  for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k)
+  {
+    if (!filter.empty() && (std::string(kernels[k].name).find(filter) == std::string::npos))
+      continue;
+
+    BenchmarkResult best_work;   best_work.seconds   = 0.0;
+    BenchmarkResult best_encode; best_encode.seconds = 0.0;
+
+    for (int r = 0; r < repeat; ++r)
+    {
+      BenchmarkResult work, encode;
+      run_kernel(kernels[k], world_data, logger, work, encode);
+      keep_best(best_work,   work);
+      keep_best(best_encode, encode);
+    }
+
+    results.push_back(best_work);
+    results.push_back(best_encode);
+  }
+
+  struct { const char* name; BenchmarkResult (*run)(WorldData&); } helpers[] =
+  {
+    { "adjust_coordinates_to_region", run_adjust_coordinates },
+    { "biome_type",                   run_biome_type         },
+    { "ExportedMapRaw::write_data",   run_raw_write_data     }
+  };
+
+  for (size_t h = 0; h < sizeof(helpers) / sizeof(helpers[0]); ++h)
+  {
+    if (!filter.empty() && (std::string(helpers[h].name).find(filter) == std::string::npos))
+      continue;
+
+    BenchmarkResult best; best.seconds = 0.0;
+    for (int r = 0; r < repeat; ++r)
+      keep_best(best, helpers[h].run(world_data));
+    results.push_back(best);
+  }
+
+  // Table for the console
+  std::cout << "World: " << world_source << " (" << world_data.world_width() << "x" << world_data.world_height() << ")" << std::endl;
+  std::cout << std::left  << std::setw(40) << "benchmark"
+            << std::right << std::setw(12) << "ns/pixel"
+            << std::setw(12) << "MB/s"
+            << std::setw(14) << "allocs/tile" << std::endl;
+
+  std::cout << std::fixed << std::setprecision(2);
+  for (size_t i = 0; i < results.size(); ++i)
+    std::cout << std::left  << std::setw(40) << results[i].name
+              << std::right << std::setw(12) << results[i].ns_per_pixel()
+              << std::setw(12) << results[i].mb_per_s()
+              << std::setw(14) << results[i].allocs_per_tile() << std::endl;
+
+  if (!json_file.empty() && !write_json(json_file, world_source, world_data, results))
+  {
+    std::cerr << "ERROR: can't write " << json_file << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------//
+// Benchmark main function.
+// Runs every consumer kernel, encoder and helper over a world snapshot, or a
+// synthetic world if none is given, and reports ns/pixel, MB/s and
+// allocations per world tile
+//----------------------------------------------------------------------------//
+int main(int argc, char* argv[])
+{
+  std::string snapshot_file;
+  std::string json_file;
+  std::string filter;
+  int         repeat = 3;
+  WorldGeneratorOptions world_options;
+  world_options.world_width  = 64;
+  world_options.world_height = 64;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string option = argv[i];
+
+    if ((option == "-size") && (i + 2 < argc))
+    {
+      world_options.world_width  = atoi(argv[++i]);
+      world_options.world_height = atoi(argv[++i]);
+    }
+    else if ((option == "-seed") && (i + 1 < argc))
+      world_options.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else if ((option == "-repeat") && (i + 1 < argc))
+      repeat = std::max(atoi(argv[++i]), 1);
+    else if ((option == "-json") && (i + 1 < argc))
+      json_file = argv[++i];
+    else if ((option == "-filter") && (i + 1 < argc))
+      filter = argv[++i];
+    else if ((option[0] != '-') && snapshot_file.empty())
+      snapshot_file = option;
+    else
+    {
+      std::cerr << "Usage: exportmaps-bench [<snapshot file>] [-size <width> <height>] [-seed <n>]" << std::endl;
+      std::cerr << "                        [-repeat <n>] [-filter <name>] [-json <file>]" << std::endl;
+      return 1;
+    }
+  }
+
+  // Without a snapshot, benchmark a synthetic world
+  std::string world_source = snapshot_file;
+  bool        generated    = false;
+  if (snapshot_file.empty())
+  {
+    if ((world_options.world_width  < 1) || (world_options.world_width  > 32767) ||
+        (world_options.world_height < 1) || (world_options.world_height > 32767))
+    {
+      std::cerr << "ERROR: the world size must be between 1 and 32767" << std::endl;
+      return 1;
+    }
+
+    snapshot_file = "exportmaps-bench.snap";
+    WorldGenerator generator(world_options);
+    if (!generator.write(snapshot_file))
+    {
+      std::cerr << "ERROR: can't create " << snapshot_file << std::endl;
+      return 1;
+    }
+
+    std::stringstream source;
+    source << "synthetic seed " << world_options.seed;
+    world_source = source.str();
+    generated    = true;
+  }
+
+  // The snapshot is unmapped when run_benchmarks returns, so it can be removed
+  int exit_code = run_benchmarks(snapshot_file, world_source, filter, repeat, json_file);
+
+  if (generated)
+    remove(snapshot_file.c_str());
+
+  return exit_code;
+}
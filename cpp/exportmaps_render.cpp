@@ -0,0 +1,117 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "../include/Mac_compat.h"
+#include "../include/ExportMaps.h"
+#include "../include/Logger.h"
+#include "../include/WorldData.h"
+
+using namespace exportmaps_plugin;
+
+//----------------------------------------------------------------------------//
+// External functions
+//----------------------------------------------------------------------------//
+extern std::tuple<unsigned int,
+                  unsigned int,
+                  unsigned int,
+                  std::vector<int>
+                 >process_command_line(std::vector <std::string>& options,
+                                       ExportOptions& export_options);
+
+//----------------------------------------------------------------------------//
+// Headless renderer main function.
+// Renders the maps from a world snapshot captured with exportmaps -snapshot,
+// without DF running. Accepts the same options as the plugin, except the
+// maps that need live DF data
+//----------------------------------------------------------------------------//
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Usage: exportmaps-render <snapshot file> <exportmaps options>" << std::endl;
+    return 1;
+  }
+
+  // Progress goes to the standard output
+  Logger logger(std::cout);
+
+  SnapshotWorldData world_data;
+  if (!world_data.open(argv[1]))
+  {
+    std::cerr << "ERROR: " << argv[1] << " is not a valid world snapshot" << std::endl;
+    return 1;
+  }
+
+  // Process command line arguments, the same way the plugin does
+  std::vector<std::string> parameters(argv + 2, argv + argc);
+  ExportOptions export_options;
+
+  std::tuple<unsigned int,
+             unsigned int,
+             unsigned int,
+             std::vector<int>
+            > command_line = process_command_line(parameters, export_options);
+
+  // Warn the user about unknown options
+  std::vector<int>& unknown_options = std::get<3>(command_line);
+  for (unsigned int i = 0; i < unknown_options.size(); ++i)
+    if (unknown_options[i] != -1)
+      std::cerr << "ERROR: unknown command line option: " << parameters[unknown_options[i]] << std::endl;
+
+  if (!export_options.snapshot_file.empty())
+    std::cerr << "WARNING: -snapshot is ignored when rendering a snapshot" << std::endl;
+
+  if (export_options.rect_embark_radius >= 0)
+    std::cerr << "WARNING: -rect-embark needs DF running and is ignored, use -rect" << std::endl;
+
+  if (export_options.background || export_options.status || (export_options.tiles_per_frame != 0))
+    std::cerr << "WARNING: -background, -tiles-per-frame and -status are only used inside DF and are ignored" << std::endl;
+
+  if (export_options.region_cache)
+    std::cerr << "WARNING: -region-cache is ignored, the snapshot already has the region details" << std::endl;
+
+  // The snapshot doesn't have the data needed by these maps
+  unsigned int maps     = std::get<0>(command_line);
+  unsigned int maps_raw = std::get<1>(command_line);
+
+  if (((maps != (unsigned int)-1) && (maps & DF_ONLY_MAPS)) ||
+      ((maps_raw != (unsigned int)-1) && (maps_raw & DF_ONLY_MAPS_RAW)))
+    std::cerr << "WARNING: sites, trading, nobility and diplomacy maps need DF running and are skipped" << std::endl;
+
+  maps     &= ~DF_ONLY_MAPS;
+  maps_raw &= ~DF_ONLY_MAPS_RAW;
+
+  MapsExporter maps_exporter;
+  maps_exporter.set_logger(&logger);
+  maps_exporter.set_world_data(&world_data);
+
+  // Same generation path as the plugin, reading the world data from the snapshot
+  return maps_exporter.export_maps(maps,                       // Graphical maps
+                                   maps_raw,                   // Raw maps
+                                   std::get<2>(command_line),  // Height maps
+                                   export_options,             // How to export them
+                                   logger
+                                   ) ? 0 : 1;
+}
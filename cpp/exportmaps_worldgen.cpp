@@ -0,0 +1,122 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#include <stdlib.h>
+#include <iostream>
+#include <string>
+
+#include "../include/WorldGenerator.h"
+
+using namespace exportmaps_plugin;
+
+//----------------------------------------------------------------------------//
+// Read the integer value of an option. Returns false if it's missing or not
+// a number
+//----------------------------------------------------------------------------//
+static bool read_value(int argc, char* argv[], int& i, long& value)
+{
+  if (i + 1 >= argc)
+    return false;
+
+  char* end = nullptr;
+  value = strtol(argv[i + 1], &end, 10);
+  if ((end == argv[i + 1]) || (*end != 0))
+    return false;
+
+  ++i;
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Synthetic world generator main function.
+// Writes a world snapshot that can be rendered with exportmaps-render
+//----------------------------------------------------------------------------//
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: exportmaps-worldgen <snapshot file> [-size <width> <height>] [-seed <n>]" << std::endl;
+    std::cerr << "                           [-sites <n>] [-entities <n>] [-roads <n>]" << std::endl;
+    return 1;
+  }
+
+  WorldGeneratorOptions options;
+
+  for (int i = 2; i < argc; ++i)
+  {
+    std::string option = argv[i];
+    long value  = 0;
+    long value2 = 0;
+    bool ok     = false;
+
+    if (option == "-size")
+    {
+      ok = read_value(argc, argv, i, value) && read_value(argc, argv, i, value2);
+      options.world_width  = (int)value;
+      options.world_height = (int)value2;
+    }
+    else if (option == "-seed")
+    {
+      ok = read_value(argc, argv, i, value);
+      options.seed = (uint32_t)value;
+    }
+    else if (option == "-sites")
+    {
+      ok = read_value(argc, argv, i, value) && (value >= 0);
+      options.num_sites = (int)value;
+    }
+    else if (option == "-entities")
+    {
+      ok = read_value(argc, argv, i, value) && (value >= 0);
+      options.num_entities = (int)value;
+    }
+    else if (option == "-roads")
+    {
+      ok = read_value(argc, argv, i, value) && (value >= 0);
+      options.num_roads = (int)value;
+    }
+
+    if (!ok)
+    {
+      std::cerr << "ERROR: wrong command line option: " << option << std::endl;
+      return 1;
+    }
+  }
+
+  // The region details store the world position as int16
+  if ((options.world_width  < 1) || (options.world_width  > 32767) ||
+      (options.world_height < 1) || (options.world_height > 32767))
+  {
+    std::cerr << "ERROR: the world size must be between 1 and 32767" << std::endl;
+    return 1;
+  }
+
+  WorldGenerator generator(options);
+  if (!generator.write(argv[1]))
+  {
+    std::cerr << "ERROR: can't create " << argv[1] << std::endl;
+    return 1;
+  }
+
+  std::cout << "Synthetic world " << options.world_width << "x" << options.world_height
+            << " (seed " << options.seed << ") written to " << argv[1] << std::endl;
+  return 0;
+}
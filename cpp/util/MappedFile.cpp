@@ -0,0 +1,305 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <stdio.h>
+
+#include "../../include/util/MappedFile.h"
+
+using namespace exportmaps_plugin;
+
+//----------------------------------------------------------------------------//
+// Constructor
+//----------------------------------------------------------------------------//
+MappedFile::MappedFile()
+  : _data(nullptr),
+    _size(0),
+#ifdef WIN32
+    _file(INVALID_HANDLE_VALUE),
+    _mapping(nullptr)
+#else
+    _fd(-1)
+#endif
+{
+}
+
+//----------------------------------------------------------------------------//
+// Destructor
+// Unmap the file if it's still mapped
+//----------------------------------------------------------------------------//
+MappedFile::~MappedFile()
+{
+  this->close();
+}
+
+//----------------------------------------------------------------------------//
+// Create a file of the given size and map it in memory
+//----------------------------------------------------------------------------//
+bool MappedFile::open(const std::string& filename, // Name of the file to create
+                      size_t size                  // Size in bytes of the file
+                      )
+{
+  this->close();
+
+  if (size == 0)
+    return false;
+
+  _filename = filename;
+
+#ifdef WIN32
+  _file = CreateFileA(filename.c_str(),
+                      GENERIC_READ | GENERIC_WRITE,
+                      0,
+                      nullptr,
+                      CREATE_ALWAYS,
+                      FILE_ATTRIBUTE_NORMAL,
+                      nullptr
+                      );
+  if (_file == INVALID_HANDLE_VALUE)
+    return false;
+
+  // The mapping sets the file size
+  unsigned long long file_size = size;
+  _mapping = CreateFileMappingA(_file,
+                                nullptr,
+                                PAGE_READWRITE,
+                                (DWORD)(file_size >> 32),
+                                (DWORD)(file_size & 0xFFFFFFFF),
+                                nullptr
+                                );
+  if (_mapping == nullptr)
+  {
+    CloseHandle(_file);
+    _file = INVALID_HANDLE_VALUE;
+    DeleteFileA(filename.c_str());
+    return false;
+  }
+
+  _data = (unsigned char*)MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, size);
+  if (_data == nullptr)
+  {
+    CloseHandle(_mapping);
+    CloseHandle(_file);
+    _mapping = nullptr;
+    _file    = INVALID_HANDLE_VALUE;
+    DeleteFileA(filename.c_str());
+    return false;
+  }
+#else
+  _fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (_fd == -1)
+    return false;
+
+  // Grow the file to its final size before mapping it
+  if (ftruncate(_fd, (off_t)size) != 0)
+  {
+    ::close(_fd);
+    _fd = -1;
+    unlink(filename.c_str());
+    return false;
+  }
+
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (ptr == MAP_FAILED)
+  {
+    ::close(_fd);
+    _fd = -1;
+    unlink(filename.c_str());
+    return false;
+  }
+  _data = (unsigned char*)ptr;
+#endif
+
+  _size = size;
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Map an existing file for reading
+//----------------------------------------------------------------------------//
+bool MappedFile::open_read(const std::string& filename // Name of the file to map
+                           )
+{
+  this->close();
+
+  _filename = filename;
+
+#ifdef WIN32
+  _file = CreateFileA(filename.c_str(),
+                      GENERIC_READ,
+                      FILE_SHARE_READ,
+                      nullptr,
+                      OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL,
+                      nullptr
+                      );
+  if (_file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(_file, &file_size) || (file_size.QuadPart == 0))
+  {
+    this->close();
+    return false;
+  }
+
+  _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (_mapping == nullptr)
+  {
+    this->close();
+    return false;
+  }
+
+  _data = (unsigned char*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+  if (_data == nullptr)
+  {
+    this->close();
+    return false;
+  }
+  _size = (size_t)file_size.QuadPart;
+#else
+  _fd = ::open(filename.c_str(), O_RDONLY);
+  if (_fd == -1)
+    return false;
+
+  struct stat file_info;
+  if ((fstat(_fd, &file_info) != 0) || (file_info.st_size == 0))
+  {
+    this->close();
+    return false;
+  }
+
+  void* ptr = mmap(nullptr, (size_t)file_info.st_size, PROT_READ, MAP_SHARED, _fd, 0);
+  if (ptr == MAP_FAILED)
+  {
+    this->close();
+    return false;
+  }
+  _data = (unsigned char*)ptr;
+  _size = (size_t)file_info.st_size;
+#endif
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Map an existing file for reading and writing
+//----------------------------------------------------------------------------//
+bool MappedFile::open_update(const std::string& filename // Name of the file to map
+                             )
+{
+  this->close();
+
+  _filename = filename;
+
+#ifdef WIN32
+  _file = CreateFileA(filename.c_str(),
+                      GENERIC_READ | GENERIC_WRITE,
+                      0,
+                      nullptr,
+                      OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL,
+                      nullptr
+                      );
+  if (_file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(_file, &file_size) || (file_size.QuadPart == 0))
+  {
+    this->close();
+    return false;
+  }
+
+  _mapping = CreateFileMappingA(_file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+  if (_mapping == nullptr)
+  {
+    this->close();
+    return false;
+  }
+
+  _data = (unsigned char*)MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, 0);
+  if (_data == nullptr)
+  {
+    this->close();
+    return false;
+  }
+  _size = (size_t)file_size.QuadPart;
+#else
+  _fd = ::open(filename.c_str(), O_RDWR);
+  if (_fd == -1)
+    return false;
+
+  struct stat file_info;
+  if ((fstat(_fd, &file_info) != 0) || (file_info.st_size == 0))
+  {
+    this->close();
+    return false;
+  }
+
+  void* ptr = mmap(nullptr, (size_t)file_info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (ptr == MAP_FAILED)
+  {
+    this->close();
+    return false;
+  }
+  _data = (unsigned char*)ptr;
+  _size = (size_t)file_info.st_size;
+#endif
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+// Unmap the file. The OS writes the modified pages back to disk.
+// If remove is true the file is deleted
+//----------------------------------------------------------------------------//
+void MappedFile::close(bool remove)
+{
+#ifdef WIN32
+  bool was_open = (_file != INVALID_HANDLE_VALUE);
+
+  if (_data != nullptr)              UnmapViewOfFile(_data);
+  if (_mapping != nullptr)           CloseHandle(_mapping);
+  if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+  _mapping = nullptr;
+  _file    = INVALID_HANDLE_VALUE;
+#else
+  bool was_open = (_fd != -1);
+
+  if (_data != nullptr) munmap(_data, _size);
+  if (_fd != -1)        ::close(_fd);
+  _fd = -1;
+#endif
+
+  if (was_open && remove)
+    ::remove(_filename.c_str());
+
+  _data = nullptr;
+  _size = 0;
+}
@@ -0,0 +1,122 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef BACKGROUND_EXPORT_H
+#define BACKGROUND_EXPORT_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <tinythread.h>
+
+#include "ExportOptions.h"
+
+namespace exportmaps_plugin
+{
+  class WorldData;
+
+  /*****************************************************************************
+   Export that renders and writes the maps in a thread of its own while the
+   game keeps running.
+   The world data is read from a snapshot captured while DF was paused, like
+   exportmaps-render does, or from a FrameSlicedWorldData that gets the
+   region details from the DF thread a few at a time, so the export thread
+   never reads DF memory. The lines logged by the export are kept until they
+   are shown by status(), as the DFHack console of the command that started
+   it is gone by then.
+   Only one background export can run at a time.
+  *****************************************************************************/
+  class BackgroundExport
+  {
+  public:
+    enum State
+    {
+      IDLE,     // Never started
+      RUNNING,
+      FINISHED,
+      FAILED
+    };
+
+  private:
+    tthread::thread*         _thread;          // Export thread or nullptr
+    tthread::mutex           _mutex;           // Protects the state and the log
+    State                    _state;
+    int64_t                  _start_time;      // Tracer::now() when started
+    int64_t                  _end_time;        // Tracer::now() when finished
+    std::vector<std::string> _lines;           // Lines logged not shown yet by status()
+    std::string              _progress;        // Last progress line
+
+    // What to export
+    WorldData*               _world_data;      // Owned, deleted by wait()
+    std::string              _remove_file;     // Deleted by wait() if not empty
+    uint32_t                 _maps;
+    uint32_t                 _maps_raw;
+    uint32_t                 _maps_hm;
+    ExportOptions            _options;
+
+    static void run(void* data);
+
+  public:
+    BackgroundExport();
+    ~BackgroundExport();
+
+    //----------------------------------------------------------------------------//
+    // Start rendering the maps in the background. The world data is owned by
+    // this object until wait() deletes it, along with remove_file.
+    // Returns false if another background export is running
+    //----------------------------------------------------------------------------//
+    bool start(WorldData* world_data,          // World data to render
+               const std::string& remove_file, // Snapshot to delete when done, or ""
+               uint32_t maps,                  // Graphical maps to generate
+               uint32_t maps_raw,              // Raw maps to generate
+               uint32_t maps_hm,               // Height maps to generate
+               const ExportOptions& options    // How to export them
+               );
+
+    //----------------------------------------------------------------------------//
+    // Return true while the export thread is working
+    //----------------------------------------------------------------------------//
+    bool is_running();
+
+    //----------------------------------------------------------------------------//
+    // Write the state of the export, the lines logged since the last call
+    // and the current progress
+    //----------------------------------------------------------------------------//
+    void status(std::ostream& out);
+
+    //----------------------------------------------------------------------------//
+    // Wait until the export thread ends and free its world data. Only from
+    // the thread that started it, as it may be reading the world data too
+    //----------------------------------------------------------------------------//
+    void wait();
+
+    //----------------------------------------------------------------------------//
+    // Called by the export thread for each line logged. Lines ended with '\r'
+    // are progress lines, and only the last one is kept
+    //----------------------------------------------------------------------------//
+    void add_line(const std::string& line,
+                  bool progress
+                  );
+  };
+}
+
+#endif // BACKGROUND_EXPORT_H
@@ -0,0 +1,92 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace exportmaps_plugin
+{
+  /*****************************************************************************
+   Keeps the big byte buffers of the maps (images, tile pyramid levels,
+   raw container layers) between exports, indexed by their size.
+   The world size doesn't change while a game is loaded, so the next export
+   finds buffers of the same sizes already allocated and paged in, instead
+   of asking the OS for hundreds of MB again.
+   The buffers of the sizes an export didn't use are freed when it ends, so
+   the sizes of a -rect export don't stay around forever. The rest stay in
+   the pool until release() is called.
+  *****************************************************************************/
+  class BufferPool
+  {
+  public:
+    //----------------------------------------------------------------------------//
+    // Give buffer exactly size bytes, all of them zero. A pooled buffer of
+    // that size is used if there is any, otherwise a new one is allocated
+    //----------------------------------------------------------------------------//
+    static void acquire(std::vector<unsigned char>& buffer, // Buffer to fill, its previous contents are recycled
+                        size_t size                         // Size in bytes
+                        );
+
+    //----------------------------------------------------------------------------//
+    // Move the storage of buffer to the pool. buffer is left empty
+    //----------------------------------------------------------------------------//
+    static void recycle(std::vector<unsigned char>& buffer // Buffer no longer used
+                        );
+
+    //----------------------------------------------------------------------------//
+    // Free pooled buffers, biggest first, until the pool holds at most
+    // max_bytes. Returns the number of bytes freed
+    //----------------------------------------------------------------------------//
+    static uint64_t trim(uint64_t max_bytes // Bytes that can remain in the pool
+                         );
+
+    //----------------------------------------------------------------------------//
+    // Free all the pooled buffers. Returns the number of bytes freed
+    //----------------------------------------------------------------------------//
+    static uint64_t release()
+    {
+      return trim(0);
+    }
+
+    //----------------------------------------------------------------------------//
+    // Forget the sizes acquired so far, at the start of an export
+    //----------------------------------------------------------------------------//
+    static void start_export();
+
+    //----------------------------------------------------------------------------//
+    // Free the pooled buffers of the sizes not acquired since start_export(),
+    // at the end of an export. Nothing is freed if no buffer was acquired, as
+    // a preview or an up to date incremental export doesn't use them.
+    // Returns the number of bytes freed
+    //----------------------------------------------------------------------------//
+    static uint64_t evict_unused();
+
+    //----------------------------------------------------------------------------//
+    // Bytes held by the pool, not in use by any map
+    //----------------------------------------------------------------------------//
+    static uint64_t pooled_bytes();
+  };
+}
+
+#endif // BUFFER_POOL_H
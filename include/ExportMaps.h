@@ -30,10 +30,9 @@
 //#include <chrono>
 #include <memory>
 
-#include "dfhack.h"
-
 #include "ExportedMap.h"
 #include "Producer.h"
 #include "RegionDetails.h"
+#include "Tracer.h"
 
 #endif // EXPORTMAPS_H
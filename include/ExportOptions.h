@@ -0,0 +1,77 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef EXPORT_OPTIONS_H
+#define EXPORT_OPTIONS_H
+
+#include <string>
+
+namespace exportmaps_plugin
+{
+  /*****************************************************************************
+   Options received from the command line that change how the maps are
+   exported, but not which maps are generated
+  *****************************************************************************/
+  struct ExportOptions
+  {
+    bool raw_container;          // Write all the raw maps in a single container file
+    bool raw_container_zlib;     // Compress the container blocks with zlib
+    bool tiles;                  // Write the graphical maps as tile pyramids
+    std::string snapshot_file;   // Capture the world data to this file if not empty
+    std::string trace_file;      // Write the timing of each export stage to this file if not empty
+    unsigned int mem_budget_mb;  // Memory the maps can use, in MB. 0 = no limit
+    bool release_buffers;        // Free the buffers kept from previous exports
+    bool preview;                // Render the maps at one pixel per world tile
+    bool rect;                   // Only generate the maps inside a rectangle of the world
+    int  rect_x0;                // Corners of the rectangle, in world coordinates
+    int  rect_y0;
+    int  rect_x1;
+    int  rect_y1;
+    int  rect_embark_radius;     // Rectangle around the current embark, in world tiles. -1 = none
+    bool incremental;            // Only generate what changed since the previous export
+    bool region_cache;           // Keep the region details generated by DF in a cache file
+    bool background;             // Render the maps after resuming the game
+    bool status;                 // Show the state of the background export
+    unsigned int tiles_per_frame; // Background export generating this many region details per frame. 0 = none
+
+    ExportOptions()
+      : raw_container(false),
+        raw_container_zlib(false),
+        tiles(false),
+        mem_budget_mb(0),
+        release_buffers(false),
+        preview(false),
+        rect(false),
+        rect_x0(0),
+        rect_y0(0),
+        rect_x1(0),
+        rect_y1(0),
+        rect_embark_radius(-1),
+        incremental(false),
+        region_cache(false),
+        background(false),
+        status(false),
+        tiles_per_frame(0)
+    {}
+  };
+}
+
+#endif // EXPORT_OPTIONS_H
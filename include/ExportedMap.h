@@ -28,6 +28,7 @@
 #include <vector>
 
 #include "./util/lodepng.h"
+#include "./util/MappedFile.h"
 
 #include "MapTypes.h"
 
@@ -50,23 +51,44 @@ namespace exportmaps_plugin
   protected:
     std::vector<unsigned char>  _image;    // The array of bytes
     std::string                 _filename; // The name of the file where the map will be saved
-    int                         _width;    // World width in world coordinates
-    int                         _height;   // World height in world coordinates
+    int                         _width;    // Map width in embark coordinates
+    int                         _height;   // Map height in embark coordinates
+    int                         _origin_x; // Embark coordinate x of the first column of the map
+    int                         _origin_y; // Embark coordinate y of the first row of the map
     MapType                     _type;     // Graphical map type
     MapTypeRaw                  _type_raw; // Raw map type
     MapTypeHeightMap            _type_hm;  // Heightmap type
 
+    //----------------------------------------------------------------------------//
+    // Index in the map of a pixel given in embark coordinates.
+    // Returns false if the pixel is out of the map
+    //----------------------------------------------------------------------------//
+    bool pixel_index(int px,        // x coordinate in embark coordinates
+                     int py,        // y coordinate in embark coordinates
+                     size_t& index  // index of the pixel in the map
+                     )
+    {
+      px -= _origin_x;
+      py -= _origin_y;
+      if ((px < 0) || (py < 0) || (px >= _width) || (py >= _height))
+        return false;
+
+      index = (size_t)py * _width + px;
+      return true;
+    }
+
   public:
     ExportedMapBase();
 
     ExportedMapBase(const std::string filename, // The name of the file where the map will be saved
-                    int world_width,            // World width in world coordinates
-                    int world_height,           // World height in world coordinates
+                    const MapWindow& window,    // Part of the world covered by the map
                     MapType type,               // Graphical map type or NONE
                     MapTypeRaw type_raw,        // Raw map type or NONE_RAW
                     MapTypeHeightMap type_hm    // Height map type or NONE_HM
                     );
 
+    virtual ~ExportedMapBase();
+
     //----------------------------------------------------------------------------//
     // Write a pixel in the map using world coordinates and offsets
     //----------------------------------------------------------------------------//
@@ -107,6 +129,26 @@ namespace exportmaps_plugin
     //----------------------------------------------------------------------------//
     virtual int write_to_disk() = 0;
 
+    //----------------------------------------------------------------------------//
+    // Write a map to disk as a pyramid of 256x256 tiles.
+    // Maps that can't be split in tiles are written as a single file
+    //----------------------------------------------------------------------------//
+    virtual int write_tiles_to_disk(unsigned int num_threads // Number of encoding threads
+                                    );
+
+    //----------------------------------------------------------------------------//
+    // Fill the map with a file written by a previous export of the same map,
+    // so only the world tiles that changed have to be drawn again.
+    // Returns false if the file can't be read or is of a different size
+    //----------------------------------------------------------------------------//
+    virtual bool load_previous(const std::string& filename // File of the previous export
+                               );
+
+    //----------------------------------------------------------------------------//
+    // Return the name of the file where the map will be saved
+    //----------------------------------------------------------------------------//
+    const std::string& get_filename();
+
     //----------------------------------------------------------------------------//
     // Return the type of a graphical map
     //----------------------------------------------------------------------------//
@@ -137,8 +179,7 @@ namespace exportmaps_plugin
   public:
     ExportedMapDF();
     ExportedMapDF(const std::string filename, // The name of the file where the map will be saved
-                  int world_width,            // World width in world coordinates
-                  int world_height,           // World height in world coordinates
+                  const MapWindow& window,    // Part of the world covered by the map
                   MapType type                // Graphical map type
                   );
     //----------------------------------------------------------------------------//
@@ -180,22 +221,62 @@ namespace exportmaps_plugin
     // Write a map to disk
     //----------------------------------------------------------------------------//
     int write_to_disk();
+
+    //----------------------------------------------------------------------------//
+    // Write a map to disk as a z/x/y pyramid of 256x256 PNG tiles, in a
+    // directory named as the PNG file with a "-tiles" suffix
+    //----------------------------------------------------------------------------//
+    int write_tiles_to_disk(unsigned int num_threads // Number of encoding threads
+                            );
+
+    //----------------------------------------------------------------------------//
+    // Decode a PNG file written by a previous export into the image
+    //----------------------------------------------------------------------------//
+    bool load_previous(const std::string& filename);
   };
 
   /*****************************************************************************
    Subclass for raw maps
+   The output file is created with its final size and mapped in memory, so
+   the samples are written directly to it as little endian int16 values.
+   If the file can't be mapped, the samples are kept in memory and written
+   to disk at the end.
+   A raw map can also be a layer of a RawContainer. Then the container
+   provides the storage and writes the file, and the samples are stored
+   using the narrowest type that fits the range of values of the map
   *****************************************************************************/
 
   class ExportedMapRaw : public ExportedMapBase
   {
+    MappedFile          _file;        // Output file mapped in memory
+    unsigned char*      _samples;     // Start of the samples in the mapped file or nullptr
+    RawSampleType       _sample_type; // Type of each sample
+    class RawContainer* _container;   // Container where this map is stored or nullptr
+
   public:
     ExportedMapRaw();
     ExportedMapRaw(const std::string filename, // The name of the file where the map will be saved
-                   int world_width,            // World width in world coordinates
-                   int world_height,           // World height in world coordinates
+                   const MapWindow& window,    // Part of the world covered by the map
                    MapTypeRaw type_raw         // Raw map type
                    );
 
+    ExportedMapRaw(class RawContainer* container, // Container where the map will be stored
+                   const std::string layer_name,  // Name of the layer in the container
+                   const MapWindow& window,       // Part of the world covered by the map
+                   MapTypeRaw type_raw,           // Raw map type
+                   int min_value,                 // Minimum value that will be written
+                   int max_value                  // Maximum value that will be written
+                   );
+
+    ~ExportedMapRaw();
+
+    //----------------------------------------------------------------------------//
+    // Use an external buffer (a layer of a container) to store the samples
+    //----------------------------------------------------------------------------//
+    void attach_samples(unsigned char* samples,  // Start of the buffer
+                        RawSampleType sample_type // Type of each sample in the buffer
+                        );
+
     //----------------------------------------------------------------------------//
     // Write a pixel in the map using world coordinates and offsets.
     // Do nothing as this is a raw map.
@@ -238,10 +319,17 @@ namespace exportmaps_plugin
     // Write a map to disk
     //----------------------------------------------------------------------------//
     int write_to_disk();
+
+    //----------------------------------------------------------------------------//
+    // Copy the samples of a raw file written by a previous export
+    //----------------------------------------------------------------------------//
+    bool load_previous(const std::string& filename);
   };
 
   /*****************************************************************************
    Subclass for Heightmaps
+   Heightmaps are stored as a single 16 bit grey channel (2 bytes per pixel)
+   so the full elevation range is kept without losing precision
   *****************************************************************************/
 
   class ExportedMapHM : public ExportedMapBase
@@ -249,8 +337,7 @@ namespace exportmaps_plugin
   public:
     ExportedMapHM();
     ExportedMapHM(const std::string filename, // The name of the file where the map will be saved
-                  int world_width,            // World width in world coordinates
-                  int world_height,           // World height in world coordinates
+                  const MapWindow& window,    // Part of the world covered by the map
                   MapTypeHeightMap type       // Heightmap type
                   );
     //----------------------------------------------------------------------------//
@@ -279,19 +366,23 @@ namespace exportmaps_plugin
                                 RGB_color& color_border  // border pixels color
                                 );
     //----------------------------------------------------------------------------//
-    // Write data to a RAW map.
-    // Do nothing as this is a graphical map
+    // Write a 16 bit height value (0..65535) to the heightmap
     //----------------------------------------------------------------------------//
-    void write_data(int pos_x,
-                    int pos_y,
-                    int px,
-                    int py,
-                    int value
+    void write_data(int pos_x,         // x coordinate in world coordinates
+                    int pos_y,         // y coordinate in world coordinates
+                    int px,            // offset 0..15 respect to pos_x = embark coordinate x
+                    int py,            // offset 0..15 respect to pos_y = embark coordinate y
+                    int value          // height value to be written
                     );
     //----------------------------------------------------------------------------//
-    // Write a map to disk
+    // Write a map to disk as a 16 bit grayscale PNG
     //----------------------------------------------------------------------------//
     int write_to_disk();
+
+    //----------------------------------------------------------------------------//
+    // Decode a 16 bit grayscale PNG written by a previous export into the image
+    //----------------------------------------------------------------------------//
+    bool load_previous(const std::string& filename);
   };
 
 
@@ -21,21 +21,53 @@
 
 #ifndef EXPORTMAPS_LOGGER_H
 #define EXPORTMAPS_LOGGER_H
-#include "../../../library/include/ColorText.h"
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <tinythread.h>
 
 
+//----------------------------------------------------------------------------//
+// Console logger that can be used from any thread.
+// Each thread builds its current line on its own and queues it when the line
+// ends (log_line, log_endl or log_cr) without taking any lock. Only the
+// thread that created the logger writes to the console, at most every
+// FLUSH_INTERVAL, so the export is never waiting for the console.
+// A line ended with log_cr is a status line: if a newer status line is
+// queued after it, it's never written, as it would be overwritten anyway.
+//----------------------------------------------------------------------------//
 class Logger
 {
 public:
-  Logger(DFHack::color_ostream& out);
+  // Nanoseconds between writes to the console (10 per second)
+  static const int64_t FLUSH_INTERVAL = 100000000;
+
+  Logger(std::ostream& out);
+  ~Logger();
   void log(std::string st);
   void log_line(std::string st);
   void log_cr();
   void log_endl();
   void log_number(unsigned int i);
   void log_number(unsigned int i, unsigned int length);
+
+  // Write all the queued lines now. Only from the thread that created the logger
+  void flush();
+
 protected:
-  DFHack::color_ostream& _out;
+  struct Message
+  {
+    std::string text;    // Line, including its final '\n' or '\r'
+    Message*    next;
+  };
+
+  std::ostream&          _out;
+  std::atomic<Message*>  _pending;    // Queued lines, the newest first
+  tthread::thread::id    _owner;      // Thread that writes to the console
+  int64_t                _last_flush; // When the console was written the last time
+
+  void end_line(char terminator);
 };
 
 #endif //EXPORTMAPS_LOGGER_H
@@ -0,0 +1,220 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+
+#ifndef MAP_REGISTRY_H
+#define MAP_REGISTRY_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <queue>
+
+#include "MapTypes.h"
+#include "RegionDetails.h"
+#include "PipelineMetrics.h"
+
+namespace exportmaps_plugin
+{
+  class Producer;
+  class ExportedMapBase;
+  class ExportedMapDF;
+
+  /*****************************************************************************
+   Every map that can be exported. The registry lists them in this order,
+   which is the order in which the maps are set up, fed, started and written
+  *****************************************************************************/
+  enum MapId
+  {
+    // DF maps
+    MAP_TEMPERATURE,
+    MAP_RAINFALL,
+    MAP_REGION,
+    MAP_DRAINAGE,
+    MAP_SAVAGERY,
+    MAP_VOLCANISM,
+    MAP_VEGETATION,
+    MAP_EVILNESS,
+    MAP_SALINITY,
+    MAP_HYDRO,
+    MAP_ELEVATION,
+    MAP_ELEVATION_WATER,
+    MAP_BIOME,
+    MAP_GEOLOGY,
+    MAP_TRADING,
+    MAP_NOBILITY,
+    MAP_DIPLOMACY,
+    MAP_SITES,
+
+    // Raw maps
+    MAP_BIOME_TYPE_RAW,
+    MAP_BIOME_REGION_RAW,
+    MAP_DRAINAGE_RAW,
+    MAP_ELEVATION_RAW,
+    MAP_ELEVATION_WATER_RAW,
+    MAP_EVILNESS_RAW,
+    MAP_HYDRO_RAW,
+    MAP_RAINFALL_RAW,
+    MAP_SALINITY_RAW,
+    MAP_SAVAGERY_RAW,
+    MAP_TEMPERATURE_RAW,
+    MAP_VOLCANISM_RAW,
+    MAP_VEGETATION_RAW,
+
+    // Heightmaps
+    MAP_ELEVATION_HM,
+    MAP_ELEVATION_WATER_HM,
+
+    MAP_COUNT
+  };
+
+  // Fields of the region map read by the maps whose pixels only depend on the
+  // region map entry that the biome index of each pixel points to
+  enum RegionMapField : uint32_t
+  {
+    FIELD_BIOME_TYPE  = 1u << 0,
+    FIELD_REGION_ID   = 1u << 1,
+    FIELD_TEMPERATURE = 1u << 2,
+    FIELD_RAINFALL    = 1u << 3,
+    FIELD_DRAINAGE    = 1u << 4,
+    FIELD_SAVAGERY    = 1u << 5,
+    FIELD_VOLCANISM   = 1u << 6,
+    FIELD_VEGETATION  = 1u << 7,
+    FIELD_EVILNESS    = 1u << 8,
+    FIELD_SALINITY    = 1u << 9
+  };
+
+  // raw_max of a raw map that stores region ids: the last region of the world
+  static const int RAW_MAX_LAST_REGION = -1;
+
+  /*****************************************************************************
+   Compile time part of the registry: the record pushed into the queue of
+   each map and the class of its map, used by the producer and the consumer
+   of the map through MapsExporter::push, pop and get_map
+  *****************************************************************************/
+  template<MapId id> struct MapTraits;
+
+  template<> struct MapTraits<MAP_TEMPERATURE>         { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_RAINFALL>            { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_REGION>              { typedef RegionDetailsElevationWater record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_DRAINAGE>            { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_SAVAGERY>            { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_VOLCANISM>           { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_VEGETATION>          { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_EVILNESS>            { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_SALINITY>            { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_HYDRO>               { typedef RegionDetailsElevationWater record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_ELEVATION>           { typedef RegionDetailsElevation      record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_ELEVATION_WATER>     { typedef RegionDetailsElevationWater record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_BIOME>               { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_GEOLOGY>             { typedef RegionDetailsGeology        record_type; typedef ExportedMapDF   map_class; };
+  template<> struct MapTraits<MAP_TRADING>             { typedef RegionDetailsElevationWater record_type; typedef ExportedMapDF   map_class; };
+  template<> struct MapTraits<MAP_NOBILITY>            { typedef RegionDetailsElevationWater record_type; typedef ExportedMapDF   map_class; };
+  template<> struct MapTraits<MAP_DIPLOMACY>           { typedef RegionDetailsElevationWater record_type; typedef ExportedMapDF   map_class; };
+  template<> struct MapTraits<MAP_SITES>               { typedef RegionDetailsElevationWater record_type; typedef ExportedMapDF   map_class; };
+
+  template<> struct MapTraits<MAP_BIOME_TYPE_RAW>      { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_BIOME_REGION_RAW>    { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_DRAINAGE_RAW>        { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_ELEVATION_RAW>       { typedef RegionDetailsElevation      record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_ELEVATION_WATER_RAW> { typedef RegionDetailsElevationWater record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_EVILNESS_RAW>        { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_HYDRO_RAW>           { typedef RegionDetailsElevationWater record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_RAINFALL_RAW>        { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_SALINITY_RAW>        { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_SAVAGERY_RAW>        { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_TEMPERATURE_RAW>     { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_VOLCANISM_RAW>       { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_VEGETATION_RAW>      { typedef RegionDetailsBiome          record_type; typedef ExportedMapBase map_class; };
+
+  template<> struct MapTraits<MAP_ELEVATION_HM>        { typedef RegionDetailsElevation      record_type; typedef ExportedMapBase map_class; };
+  template<> struct MapTraits<MAP_ELEVATION_WATER_HM>  { typedef RegionDetailsElevationWater record_type; typedef ExportedMapBase map_class; };
+
+  /*****************************************************************************
+   Queue of the records waiting for the consumer of a map. The producer and
+   the consumer access it with the mutex of the MapsExporter locked
+  *****************************************************************************/
+  class MapQueueBase
+  {
+  public:
+    virtual ~MapQueueBase() {}
+    virtual bool empty() const = 0;
+    virtual void clear() = 0;
+  };
+
+  template<class T>
+  class MapQueue : public MapQueueBase
+  {
+  public:
+    std::queue<T> records;
+
+    bool empty() const
+    {
+      return records.empty();
+    }
+
+    void clear()
+    {
+      std::queue<T>().swap(records);
+    }
+  };
+
+  /*****************************************************************************
+   Everything the MapsExporter keeps for a map while it's being generated
+  *****************************************************************************/
+  struct MapSlot
+  {
+    std::unique_ptr<Producer>        producer;
+    std::unique_ptr<MapQueueBase>    queue;
+    std::unique_ptr<ExportedMapBase> map;
+    MapMetrics                       metrics;
+    std::atomic<int>                 percentage;  // Of an overlay drawn after the last world tile
+
+    MapSlot();
+    ~MapSlot();
+  };
+
+  /*****************************************************************************
+   Run time part of the registry: how each map is requested, named, fed,
+   generated and checked for changes
+  *****************************************************************************/
+  struct MapInfo
+  {
+    MapKind     kind;
+    uint32_t    bit;                     // Of the map in its MapType, MapTypeRaw or MapTypeHeightMap
+    const char* name;                    // Shown in the metrics and the trace
+    const char* write_span;              // Trace span of writing the map to disk
+    const char* suffix;                  // Of the file names, before the extension
+    uint32_t    details;                 // MapDetails read by the consumer
+    uint32_t    region_map_fields;       // RegionMapField read through the biome index, if
+                                         // the pixels of the map depend on nothing else
+    uint32_t    fingerprint_fields;      // Bits of the TileFingerprints::Field the map reads
+    bool        overlay;                 // Draws sites and routes across many world tiles
+    int         raw_min;                 // Range of the values written to a raw map
+    int         raw_max;
+    void      (*consumer)(void* arg);    // Thread function, nullptr if not part of this build
+    void      (*create)(MapSlot& slot);  // Create the producer and the queue of the map
+  };
+
+  const MapInfo& map_info(MapId id);
+}
+
+#endif // MAP_REGISTRY_H
@@ -71,12 +71,43 @@ namespace exportmaps_plugin
     DIPLOMACY_RAW       = 1u << 16
   };
 
+  // Maps that read DF data not stored in the world snapshots (historical
+  // entities, site realizations), so they can only be generated with DF running
+  static const uint32_t DF_ONLY_MAPS     = SITES | TRADING | NOBILITY | DIPLOMACY;
+  static const uint32_t DF_ONLY_MAPS_RAW = SITES_RAW | TRADING_RAW | NOBILITY_RAW | DIPLOMACY_RAW;
+
   enum MapTypeHeightMap : uint32_t
   {
     NONE_HM            = 0u,
     ELEVATION_HM       = 1u <<  0,
     ELEVATION_WATER_HM = 1u <<  1
   };
+
+  // Which of the three map type enums a map belongs to. Same values as
+  // the kinds of the map files stored in the fingerprints file
+  enum MapKind : uint32_t
+  {
+    MAP_KIND_DF  = 0u,  // MapType, a PNG like the DF export
+    MAP_KIND_RAW = 1u,  // MapTypeRaw, binary samples
+    MAP_KIND_HM  = 2u   // MapTypeHeightMap, a 16 bit grey PNG
+  };
+
+  // Rectangle of the world covered by the maps, in world coordinates
+  struct MapWindow
+  {
+    int x;      // First world coordinate x
+    int y;      // First world coordinate y
+    int width;  // Width in world coordinates
+    int height; // Height in world coordinates
+  };
+
+  // Type of each value stored in a raw map
+  enum RawSampleType : uint32_t
+  {
+    SAMPLE_INT16  = 1u, // 2 bytes, signed
+    SAMPLE_UINT8  = 2u, // 1 byte, unsigned
+    SAMPLE_UINT16 = 3u  // 2 bytes, unsigned
+  };
 }
 
 #endif
@@ -0,0 +1,131 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef PIPELINE_METRICS_H
+#define PIPELINE_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "Tracer.h"
+
+namespace exportmaps_plugin
+{
+  /*****************************************************************************
+   Counters of a map consumer, updated while the maps are being generated and
+   read by the producer thread to show the progress.
+   Each counter has a single writer: the producer updates the queue counters
+   and the consumer thread of the map the rest, so relaxed atomics are enough.
+  *****************************************************************************/
+  class MapMetrics
+  {
+  public:
+    const char*           name;             // Map name shown in the console
+    std::atomic<uint64_t> tiles;            // World tiles processed by the consumer
+    std::atomic<uint64_t> queue_high_water; // Maximum number of tiles waiting in the queue
+    std::atomic<int64_t>  busy_time;        // Nanoseconds processing tiles and drawing overlays
+    std::atomic<int64_t>  wait_time;        // Nanoseconds waiting for data in the queue
+    std::atomic<bool>     finished;         // The end marker has been processed
+    int64_t               last_end;         // When the consumer finished its previous tile
+
+    MapMetrics()
+      : name(""),
+        tiles(0),
+        queue_high_water(0),
+        busy_time(0),
+        wait_time(0),
+        finished(false),
+        last_end(0)
+    {}
+
+    //----------------------------------------------------------------------------//
+    // Clear the counters before starting a new consumer thread
+    //----------------------------------------------------------------------------//
+    void reset(const char* map_name // Map name, a string literal
+               )
+    {
+      name = map_name;
+      tiles.store(0);
+      queue_high_water.store(0);
+      busy_time.store(0);
+      wait_time.store(0);
+      finished.store(false);
+      last_end = Tracer::now();
+    }
+
+    //----------------------------------------------------------------------------//
+    // Called by the producer after pushing data into the queue of the map
+    //----------------------------------------------------------------------------//
+    void update_queue_depth(size_t depth // Elements in the queue after the push
+                            )
+    {
+      if (depth > queue_high_water.load(std::memory_order_relaxed))
+        queue_high_water.store(depth, std::memory_order_relaxed);
+    }
+  };
+
+  /*****************************************************************************
+   Updates the metrics of a map with one call to its do_work function.
+   The time since the previous call is the time the consumer waited for data
+  *****************************************************************************/
+  class MapWorkTimer
+  {
+    MapMetrics& _metrics;
+    int64_t     _begin;
+    bool        _end_marker;
+
+  public:
+    explicit MapWorkTimer(MapMetrics& metrics // Metrics of the map being processed
+                          )
+      : _metrics(metrics),
+        _begin(Tracer::now()),
+        _end_marker(false)
+    {
+      _metrics.wait_time.fetch_add(_begin - _metrics.last_end, std::memory_order_relaxed);
+    }
+
+    ~MapWorkTimer()
+    {
+      int64_t end = Tracer::now();
+      _metrics.busy_time.fetch_add(end - _begin, std::memory_order_relaxed);
+      _metrics.last_end = end;
+
+      if (_end_marker)
+        _metrics.finished.store(true);
+      else
+        _metrics.tiles.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------//
+    // The data processed is the end marker, not a world tile
+    //----------------------------------------------------------------------------//
+    void set_end_marker()
+    {
+      _end_marker = true;
+    }
+
+  private:
+    MapWorkTimer(const MapWorkTimer&);
+    MapWorkTimer& operator=(const MapWorkTimer&);
+  };
+}
+
+#endif // PIPELINE_METRICS_H
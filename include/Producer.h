@@ -19,10 +19,10 @@
 // You can always find the latest version of this plugin in Github
 // https://github.com/ragundo/exportmaps
 
+
 #ifndef PRODUCER_H
 #define PRODUCER_H
 
-#include "dfhack.h"
 #include "RegionDetails.h"
 #include "MapsExporter.h"
 
@@ -32,553 +32,45 @@ namespace exportmaps_plugin
   {
 
   public:
-        virtual void produce_data(class MapsExporter& destination, int x, int y, df::world_region_details* ptr_rd);
-        virtual void produce_end (class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerTemperature : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerRainfall : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerRegion : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerDrainage : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerSavagery : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerVolcanism : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerVegetation : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerEvilness : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerSalinity : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerHydro : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
+        virtual ~Producer() {}
 
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerElevation : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerElevationWater : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerBiome : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerGeology : public Producer
-  {
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerTrading : public Producer
-  {
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerNobility : public Producer
-  {
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerDiplomacy : public Producer
-  {
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerSites : public Producer
-  {
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerBiomeRawType : public Producer
-  {
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerBiomeRawRegion : public Producer
-  {
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerDrainageRaw : public Producer
-  {
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerElevationRaw : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerElevationWaterRaw : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details*
-                      ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerEvilnessRaw : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details*
-                      ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerHydroRaw : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerRainfallRaw : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerSalinityRaw : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerSavageryRaw : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerTemperatureRaw : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
+        virtual void produce_data(class MapsExporter& destination, const SharedTileDetails& tile);
+        virtual void produce_end (class MapsExporter& destination);
 
   };
 
   /*****************************************************************************
+   The producer of each map wraps the region details of each world
+   coordinate in the record its consumer reads, and pushes it in the queue
+   of the map. The record type comes from the registry
   *****************************************************************************/
 
-  class ProducerVolcanismRaw : public Producer
+  template<MapId id>
+  class MapProducer : public Producer
   {
 
   public:
     void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
+                      const SharedTileDetails& tile
+                      )
+    {
+      // The record shares the region details with the other maps
+      typename MapTraits<id>::record_type record(tile);
 
-    void produce_end(class MapsExporter& destination);
+      // Push the produced data in the queue
+      destination.push<id>(record);
+    }
 
-  };
+    void produce_end(class MapsExporter& destination)
+    {
+      // The end marker is generated by the default constructor
+      typename MapTraits<id>::record_type record;
 
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerVegetationRaw : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
+      // Push the data to the producer for the consumers
+      destination.push<id>(record);
+    }
 
   };
-
-
-/*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerElevationHeightMap : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-  /*****************************************************************************
-  *****************************************************************************/
-
-  class ProducerElevationWaterHeightMap : public Producer
-  {
-
-  public:
-    void produce_data(class MapsExporter& destination,
-                      int x,
-                      int y,
-                      df::world_region_details* ptr_rd
-                      );
-
-    void produce_end(class MapsExporter& destination);
-  };
-
-
 }
 
 #endif // PRODUCER_H
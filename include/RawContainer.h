@@ -0,0 +1,134 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef RAW_CONTAINER_H
+#define RAW_CONTAINER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "./util/MappedFile.h"
+
+#include "MapTypes.h"
+
+namespace exportmaps_plugin
+{
+  class ExportedMapRaw;
+
+  /*****************************************************************************
+   Single file that stores several raw maps (layers).
+   The file has a header, a descriptor for each layer and then the samples of
+   each layer in its own block, aligned to 4096 bytes so every layer can be
+   memory mapped by external tools.
+   Optionally each layer is split in blocks of rows that are compressed with
+   zlib. In that case a block index is stored for each layer so any block can
+   be read without decompressing the previous ones.
+   The format is described in docs/raw_maps.md
+  *****************************************************************************/
+  class RawContainer
+  {
+    struct Layer
+    {
+      ExportedMapRaw*      map;         // Map that writes its samples to this layer
+      std::string          name;        // Layer name (max 15 characters)
+      MapTypeRaw           type_raw;    // Raw map type
+      RawSampleType        sample_type; // Type of each sample
+      uint32_t             sample_size; // Size of each sample in bytes
+      float                scale;       // Real value = sample * scale + offset
+      float                offset;
+      uint64_t             data_offset; // Offset of the layer data in the file
+      uint64_t             data_size;   // Size of the layer data stored in the file
+      uint64_t             index_offset;// Offset of the block index or 0 if not compressed
+      uint32_t             block_count; // Number of compressed blocks or 0 if not compressed
+      std::vector<unsigned char> samples; // Samples when the file is not mapped
+    };
+
+    std::string        _filename;   // Name of the container file
+    int                _width;      // World width in embark coordinates
+    int                _height;     // World height in embark coordinates
+    bool               _compressed; // Compress the layer blocks with zlib
+    std::vector<Layer> _layers;     // Layers stored in the container
+    MappedFile         _file;       // Container file mapped in memory
+
+  public:
+    RawContainer(const std::string filename, // The name of the container file
+                 int world_width,            // World width in world coordinates
+                 int world_height,           // World height in world coordinates
+                 bool compressed             // Compress the layers with zlib
+                 );
+
+    //----------------------------------------------------------------------------//
+    // Add a new layer to the container. Must be called before create()
+    //----------------------------------------------------------------------------//
+    void add_layer(ExportedMapRaw* map,      // Map that will write to the layer
+                   const std::string name,   // Layer name
+                   MapTypeRaw type_raw,      // Raw map type
+                   int min_value,            // Minimum value of the layer
+                   int max_value,            // Maximum value of the layer
+                   float scale  = 1.0f,      // Scale applied to each sample
+                   float offset = 0.0f       // Offset applied to each sample
+                   );
+
+    //----------------------------------------------------------------------------//
+    // Return the narrowest sample type that can store a range of values
+    //----------------------------------------------------------------------------//
+    static RawSampleType sample_type_for_range(int min_value, int max_value);
+
+    //----------------------------------------------------------------------------//
+    // Allocate the storage of every layer and attach it to its map
+    //----------------------------------------------------------------------------//
+    void create();
+
+    //----------------------------------------------------------------------------//
+    // Write the container to disk
+    //----------------------------------------------------------------------------//
+    int write_to_disk();
+
+    //----------------------------------------------------------------------------//
+    // Number of rows of each compressed block
+    //----------------------------------------------------------------------------//
+    static const int BLOCK_ROWS = 16;
+
+  private:
+    //----------------------------------------------------------------------------//
+    // Size of the file header plus the layer descriptors
+    //----------------------------------------------------------------------------//
+    size_t header_size();
+
+    //----------------------------------------------------------------------------//
+    // Write the file header and the layer descriptors to a buffer
+    //----------------------------------------------------------------------------//
+    void write_header(unsigned char* dest);
+
+    //----------------------------------------------------------------------------//
+    // Write the container keeping the layers uncompressed
+    //----------------------------------------------------------------------------//
+    int write_uncompressed();
+
+    //----------------------------------------------------------------------------//
+    // Write the container compressing each block of the layers
+    //----------------------------------------------------------------------------//
+    int write_compressed();
+  };
+}
+
+#endif // RAW_CONTAINER_H
@@ -19,26 +19,157 @@
 // You can always find the latest version of this plugin in Github
 // https://github.com/ragundo/exportmaps
 
+
 #ifndef REGION_DETAILS_H
 #define REGION_DETAILS_H
 
-#include "dfhack.h"
-#include <df/world_region_details.h>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+#include "WorldSnapshot.h"
+
+// Underground features are only available with DF running
+namespace df { struct world_region_feature; }
+
+// Rivers data from world_region_details
+struct RegionDetailsRiversVertical
+{
+    int16_t x_min[16][17];
+    int16_t elevation[16][17];
+};
+
+struct RegionDetailsRiversHorizontal
+{
+    int16_t y_min[17][16];
+    int16_t elevation[17][16];
+};
+
+namespace exportmaps_plugin
+{
+  // Data of the region details of a world tile read by a map consumer,
+  // besides the world coordinates of the tile
+  enum MapDetails : uint32_t
+  {
+    DETAILS_BIOME           = 1u << 0,  // Biome index of each embark tile
+    DETAILS_ELEVATION       = 1u << 1,  // Elevation of each embark tile
+    DETAILS_RIVERS          = 1u << 2,  // River courses between the embark tiles
+    DETAILS_ELEVATION_WATER = 1u << 3,  // Elevation respecting water of each embark tile
+    DETAILS_HYDRO           = 1u << 4   // Water course of each embark tile
+                                        // The last two are computed from the three above
+  };
+
+  class WorldData;
+
+  // Elevation of an embark tile respecting the rivers and lakes. The maps of
+  // the elevation respecting water derive their values from it
+  struct WaterElevation
+  {
+    int32_t elevation;       // River elevation or lake surface if any, else the terrain elevation
+    int16_t river_elevation; // Lowest elevation of the river crossing the tile
+    int8_t  region_type;     // Type of the region the tile belongs to
+    bool    river;           // A river crosses the tile, not counting oceans, lakes, glaciers and tundra
+  };
+
+  // What the hydrosphere map shows in an embark tile
+  enum HydroClass : uint8_t
+  {
+    HYDRO_MOUNTAIN    = 0,  // No river
+    HYDRO_LAKE        = 1,
+    HYDRO_OCEAN       = 2,
+    HYDRO_LAND        = 3,
+    HYDRO_BROOK       = 4,  // River, by flow
+    HYDRO_SHORE       = 5,
+    HYDRO_MAJOR_RIVER = 6,
+    HYDRO_RIVER       = 7,
+    HYDRO_MINOR_RIVER = 8,
+    HYDRO_STREAM      = 9
+  };
+
+  // Water course of an embark tile. The DF and raw hydrosphere maps derive
+  // their values from it
+  struct Watercourse
+  {
+    int16_t value;       // Of the raw map: 0 no river, 1 shore, 32767 brook, else the river flow
+    uint8_t hydro_class; // HydroClass
+  };
+
+  // Return the water course of an embark tile without a river, from its terrain
+  Watercourse no_river_watercourse(int biome_type,
+                                   int elevation
+                                   );
+
+  /*****************************************************************************
+   The region details of a world tile, as read by the maps being generated.
+   The producer extracts each field once per world tile, only if a requested
+   map reads it, and all the queues share the same record. The fields not
+   extracted are left uninitialized.
+   The elevation respecting water and the water courses are also computed
+   here, so the DF, raw and heightmap versions of their maps don't repeat
+   the work
+  *****************************************************************************/
+  struct TileDetails
+  {
+    int16_t                       pos_x;             // World coordinate x
+    int16_t                       pos_y;             // World coordinate y
+    uint32_t                      details;           // MapDetails extracted
+    int8_t                        biome[17][17];     // DETAILS_BIOME
+    int16_t                       elevation[17][17]; // DETAILS_ELEVATION
+    RegionDetailsRiversVertical   rivers_vertical;   // DETAILS_RIVERS
+    RegionDetailsRiversHorizontal rivers_horizontal; // DETAILS_RIVERS
+    WaterElevation                water[16][16];     // DETAILS_ELEVATION_WATER
+    Watercourse                   hydro[16][16];     // DETAILS_HYDRO
+
+    static std::shared_ptr<const TileDetails> extract(const SnapshotRegionDetails& rd, // region details of the tile
+                                                      uint32_t fields,                 // MapDetails to copy
+                                                      const WorldData* world_data      // needed for DETAILS_ELEVATION_WATER and DETAILS_HYDRO
+                                                      );
+
+    WaterElevation water_elevation(int x,                       // embark tile x
+                                   int y,                       // embark tile y
+                                   int biome_type,              // biome type of the embark tile
+                                   const SnapshotRegion* region // region the embark tile belongs to
+                                   ) const;
+
+    Watercourse watercourse(int x,                             // embark tile x
+                            int y,                             // embark tile y
+                            int biome_type,                    // biome type of the embark tile
+                            const SnapshotRegionMapEntry& rme, // region map entry of the embark tile
+                            int river_flow                     // flow of the river of the world tile or -1
+                            ) const;
+
+  private:
+    void fill_embark_tiles(const WorldData& world_data);
+  };
+
+  typedef std::shared_ptr<const TileDetails> SharedTileDetails;
+}
 
+/*****************************************************************************
+ The records read by the consumers are views of the region details of a world
+ tile shared by all the maps. Copying them doesn't copy the data.
+ A record without region details is the end marker
+*****************************************************************************/
 class RegionDetailsBase
 {
 protected:
-    // world coordinates of the current position
-    int16_t _pos_x;
-    int16_t _pos_y;
+    exportmaps_plugin::SharedTileDetails _tile;
 
 public:
-    RegionDetailsBase() : _pos_x(-1), _pos_y(-1){}
-    RegionDetailsBase(int16_t x, int16_t y) : _pos_x(x), _pos_y(y) {}
+    RegionDetailsBase() {}
+    RegionDetailsBase(const exportmaps_plugin::SharedTileDetails& tile) : _tile(tile) {}
 
-    int16_t get_pos_x(){ return _pos_x; }
-    int16_t get_pos_y(){ return _pos_y; }
-    bool    is_end_marker() { return ((_pos_x == -1) && (_pos_y == -1));}
+    int16_t get_pos_x(){ return _tile ? _tile->pos_x : -1; }
+    int16_t get_pos_y(){ return _tile ? _tile->pos_y : -1; }
+    bool    is_end_marker() { return !_tile; }
+
+    // The producer only extracts the MapDetails that the registry declares
+    // for the requested maps, the other fields are uninitialized
+    bool has_details(uint32_t fields) const
+    {
+        return _tile && ((_tile->details & fields) == fields);
+    }
 };
 
 /*****************************************************************************
@@ -47,30 +178,15 @@ public:
 
 class RegionDetailsElevation : public RegionDetailsBase
 {
-    // Elevation data from world_region_detail
-    int16_t elevation[17][17];
-
 public:
     RegionDetailsElevation() : RegionDetailsBase(){}
 
-    RegionDetailsElevation(df::world_region_details* rd) : RegionDetailsBase(rd->pos.x, rd->pos.y)
-    {
-        // Copy DF data to plugin
-        for (auto i = 0; i < 17; ++i)
-            for (auto j = 0; j < 17; ++j)
-                this->elevation[i][j] = rd->elevation[i][j];
-    }
+    RegionDetailsElevation(const exportmaps_plugin::SharedTileDetails& tile) : RegionDetailsBase(tile) {}
 
-    RegionDetailsElevation(const RegionDetailsElevation& rdd) : RegionDetailsBase(rdd._pos_x, rdd._pos_y)
-    {
-        // Copy DF data to plugin
-        for (auto i = 0; i < 17; ++i)
-            for (auto j = 0; j < 17; ++j)
-                this->elevation[i][j] = rdd.elevation[i][j];
-    }
     int16_t get_elevation(int x, int y)
     {
-        return elevation[x][y];
+        assert(has_details(exportmaps_plugin::DETAILS_ELEVATION));
+        return _tile->elevation[x][y];
     }
 };
 
@@ -80,78 +196,70 @@ public:
 
 class RegionDetailsElevationWater : public RegionDetailsBase
 {
-    // Elevation data from world_region_details
-    int16_t elevation[17][17];
+public:
+    RegionDetailsElevationWater() : RegionDetailsBase(){}
 
-    // Biome data from world_region_details
-    int16_t biome[17][17];
+    RegionDetailsElevationWater(const exportmaps_plugin::SharedTileDetails& tile) : RegionDetailsBase(tile) {}
 
-    // Rivers data from world_region_details
-    df::world_region_details::T_rivers_vertical   rivers_vertical;
-    df::world_region_details::T_rivers_horizontal rivers_horizontal;
+    // With all the data of the region details
+    RegionDetailsElevationWater(const exportmaps_plugin::SnapshotRegionDetails& rd)
+      : RegionDetailsBase(exportmaps_plugin::TileDetails::extract(rd,
+                                                                  exportmaps_plugin::DETAILS_BIOME     |
+                                                                  exportmaps_plugin::DETAILS_ELEVATION |
+                                                                  exportmaps_plugin::DETAILS_RIVERS,
+                                                                  nullptr
+                                                                  )
+                          )
+    {}
 
-public:
-    RegionDetailsElevationWater() : RegionDetailsBase(){}
+    int16_t get_elevation(int x, int y)
+    {
+        assert(has_details(exportmaps_plugin::DETAILS_ELEVATION));
+        return _tile->elevation[x][y];
+    }
 
-    RegionDetailsElevationWater(df::world_region_details* rd) : RegionDetailsBase(rd->pos.x, rd->pos.y)
+    int16_t get_biome_index(int x, int y)
     {
-        // Copy elevation and biome data
-        for (auto i = 0; i < 17; ++i)
-            for (auto j = 0; j < 17; ++j)
-            {
-                this->elevation[i][j] = rd->elevation[i][j];
-                this->biome[i][j]     = rd->biome[i][j];
-            }
-
-        // copy rivers data
-        memcpy((void*)&rivers_horizontal,
-               (void*)&rd->rivers_horizontal,
-               sizeof(df::world_region_details::T_rivers_horizontal));
-
-        memcpy((void*)&rivers_vertical,
-               (void*)&rd->rivers_vertical,
-               sizeof(df::world_region_details::T_rivers_vertical));
+        assert(has_details(exportmaps_plugin::DETAILS_BIOME));
+        return _tile->biome[x][y];
+    }
 
+    const RegionDetailsRiversHorizontal& get_rivers_horizontal()
+    {
+        assert(has_details(exportmaps_plugin::DETAILS_RIVERS));
+        return _tile->rivers_horizontal;
     }
 
-    RegionDetailsElevationWater(const RegionDetailsElevationWater& rd) : RegionDetailsBase(rd._pos_x, rd._pos_y)
+    const RegionDetailsRiversVertical& get_rivers_vertical()
     {
-        // Copy elevation and biome data
-        for (auto i = 0; i < 17; ++i)
-            for (auto j = 0; j < 17; ++j)
-            {
-                this->elevation[i][j] = rd.elevation[i][j];
-                this->biome[i][j]     = rd.biome[i][j];
-            }
-
-        // copy rivers data
-        memcpy((void*)&rivers_horizontal,
-               (void*)&(rd.rivers_horizontal),
-               sizeof(df::world_region_details::T_rivers_horizontal));
-
-        memcpy((void*)&rivers_vertical,
-               (void*)&(rd.rivers_vertical),
-               sizeof(df::world_region_details::T_rivers_vertical));
+        assert(has_details(exportmaps_plugin::DETAILS_RIVERS));
+        return _tile->rivers_vertical;
     }
 
-    int16_t get_elevation(int x, int y)
+    // Computed once per world tile by the producer
+    const exportmaps_plugin::WaterElevation& get_water_elevation(int x, int y)
     {
-        return elevation[x][y];
+        assert(has_details(exportmaps_plugin::DETAILS_ELEVATION_WATER));
+        return _tile->water[x][y];
     }
 
-    int16_t get_biome_index(int x, int y)
+    exportmaps_plugin::WaterElevation water_elevation(int x, int y, int biome_type, const exportmaps_plugin::SnapshotRegion* region)
     {
-        return biome[x][y];
+        assert(has_details(exportmaps_plugin::DETAILS_BIOME | exportmaps_plugin::DETAILS_ELEVATION | exportmaps_plugin::DETAILS_RIVERS));
+        return _tile->water_elevation(x, y, biome_type, region);
     }
 
-    const df::world_region_details::T_rivers_horizontal& get_rivers_horizontal()
+    // Computed once per world tile by the producer
+    const exportmaps_plugin::Watercourse& get_watercourse(int x, int y)
     {
-        return rivers_horizontal;
+        assert(has_details(exportmaps_plugin::DETAILS_HYDRO));
+        return _tile->hydro[x][y];
     }
 
-    const df::world_region_details::T_rivers_vertical& get_rivers_vertical()
+    exportmaps_plugin::Watercourse watercourse(int x, int y, int biome_type, const exportmaps_plugin::SnapshotRegionMapEntry& rme, int river_flow)
     {
-        return rivers_vertical;
+        assert(has_details(exportmaps_plugin::DETAILS_BIOME | exportmaps_plugin::DETAILS_ELEVATION | exportmaps_plugin::DETAILS_RIVERS));
+        return _tile->watercourse(x, y, biome_type, rme, river_flow);
     }
 };
 
@@ -161,31 +269,15 @@ public:
 
 class RegionDetailsBiome : public RegionDetailsBase
 {
-    // Biome data from world_region_detail
-    int16_t biome[17][17];
-
 public:
     RegionDetailsBiome(){}
 
-    RegionDetailsBiome(df::world_region_details* rd) : RegionDetailsBase(rd->pos.x, rd->pos.y)
-    {
-        // Copy DF data to plugin
-        for (auto i = 0; i < 17; ++i)
-            for (auto j = 0; j < 17; ++j)
-                this->biome[i][j] = rd->biome[i][j];
-    }
-
-    RegionDetailsBiome(const RegionDetailsBiome& rdd) : RegionDetailsBase(rdd._pos_x, rdd._pos_y)
-    {
-        // Copy DF data to plugin
-        for (auto i = 0; i < 17; ++i)
-            for (auto j = 0; j < 17; ++j)
-                this->biome[i][j] = rdd.biome[i][j];
-    }
+    RegionDetailsBiome(const exportmaps_plugin::SharedTileDetails& tile) : RegionDetailsBase(tile) {}
 
     int16_t get_biome_index(int x, int y)
     {
-        return biome[x][y];
+        assert(has_details(exportmaps_plugin::DETAILS_BIOME));
+        return _tile->biome[x][y];
     }
 };
 
@@ -194,56 +286,26 @@ public:
 
 class RegionDetailsGeology : public RegionDetailsBase
 {
-    // Biome data from world_region_details
-    int16_t biome[17][17];
-
-    // Elevation data from world_region_details
-    int16_t elevation[17][17];
-
     // Underground features
     std::vector<df::world_region_feature* > features[16][16];
 
 public:
     RegionDetailsGeology(){}
 
-    RegionDetailsGeology(df::world_region_details* rd) : RegionDetailsBase(rd->pos.x, rd->pos.y)
-    {
-        // Copy DF data to plugin
-        for (auto i = 0; i < 17; ++i)
-            for (auto j = 0; j < 17; ++j)
-            {
-                this->biome[i][j] = rd->biome[i][j];
-                this->elevation[i][j] = rd->elevation[i][j];
-            }
-
-        for (auto i = 0; i < 16; ++i)
-            for (auto j = 0; j < 16; ++j)
-                this->features[i][j] = rd->features[i][j];
-    }
-
-    RegionDetailsGeology(const RegionDetailsGeology& rdd) : RegionDetailsBase(rdd._pos_x, rdd._pos_y)
-    {
-        // Copy DF data to plugin
-        for (auto i = 0; i < 17; ++i)
-            for (auto j = 0; j < 17; ++j)
-            {
-                this->biome[i][j] = rdd.biome[i][j];
-                this->elevation[i][j] = rdd.elevation[i][j];
-            }
-
-        for (auto i = 0; i < 16; ++i)
-            for (auto j = 0; j < 16; ++j)
-                this->features[i][j] = rdd.features[i][j];
-    }
+    // The underground features are not part of the world data, so they
+    // are left empty
+    RegionDetailsGeology(const exportmaps_plugin::SharedTileDetails& tile) : RegionDetailsBase(tile) {}
 
     int16_t get_biome_index(int x, int y)
     {
-        return biome[x][y];
+        assert(has_details(exportmaps_plugin::DETAILS_BIOME));
+        return _tile->biome[x][y];
     }
 
     int16_t get_elevation(int x, int y)
     {
-        return elevation[x][y];
+        assert(has_details(exportmaps_plugin::DETAILS_ELEVATION));
+        return _tile->elevation[x][y];
     }
 
     const std::vector<df::world_region_feature* >& get_features(int x, int y)
@@ -0,0 +1,118 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef REGION_DETAILS_CACHE_H
+#define REGION_DETAILS_CACHE_H
+
+#include <stdint.h>
+#include <string>
+
+#include "WorldSnapshot.h"
+#include "util/MappedFile.h"
+
+namespace exportmaps_plugin
+{
+  class WorldData;
+
+  /*****************************************************************************
+   Region details generated by DF, kept in a file mapped in memory between
+   exports of the same world.
+   The file has a slot for every world tile with the snapshot record of its
+   region details, that only has the fields read by the maps, and a key
+   computed from the region map of the tile and its 8 neighbors, which is
+   what DF generates the region details from. A slot is only used while the
+   key matches, so the tiles of a world that changed, or of another world
+   with the same save folder, are generated again and replace the old ones.
+  *****************************************************************************/
+  class RegionDetailsCache
+  {
+    // Start of the file (32 bytes)
+    struct Header
+    {
+      char     magic[8];       // "EXPMAPRD"
+      uint32_t version;
+      uint32_t record_size;    // sizeof(SnapshotRegionDetails)
+      int32_t  world_width;
+      int32_t  world_height;
+      uint32_t details_offset; // Offset of the first record, page aligned
+      uint32_t reserved;
+    };
+
+    MappedFile             _file;
+    int                    _world_width;
+    int                    _world_height;
+    uint32_t*              _keys;    // One for each world tile, by rows. 0 = empty slot
+    SnapshotRegionDetails* _details; // One for each world tile, by rows
+    unsigned int           _hits;    // Tiles read from the cache
+    unsigned int           _stores;  // Tiles written to the cache
+
+  public:
+    RegionDetailsCache();
+
+    //----------------------------------------------------------------------------//
+    // Map the cache file of a world, creating it if it doesn't exist or was
+    // made for a world of another size. Returns false if it can't be mapped
+    //----------------------------------------------------------------------------//
+    bool open(const std::string& filename, // Cache file
+              int world_width,             // World size in world coordinates
+              int world_height
+              );
+
+    //----------------------------------------------------------------------------//
+    // Unmap the cache file
+    //----------------------------------------------------------------------------//
+    void close();
+
+    bool is_open() const { return _file.is_open(); }
+
+    //----------------------------------------------------------------------------//
+    // Key of the region details of a world tile. Never 0
+    //----------------------------------------------------------------------------//
+    static uint32_t tile_key(const WorldData& world_data, // World tables
+                             int x,                       // world coordinate x
+                             int y                        // world coordinate y
+                             );
+
+    //----------------------------------------------------------------------------//
+    // Copy the region details of a world tile from the cache.
+    // Returns false if they aren't cached or were cached with another key
+    //----------------------------------------------------------------------------//
+    bool lookup(int x,                    // world coordinate x
+                int y,                    // world coordinate y
+                uint32_t key,             // tile_key() of the world tile
+                SnapshotRegionDetails& rd // destination
+                );
+
+    //----------------------------------------------------------------------------//
+    // Save the region details of a world tile in the cache
+    //----------------------------------------------------------------------------//
+    void store(int x,                          // world coordinate x
+               int y,                          // world coordinate y
+               uint32_t key,                   // tile_key() of the world tile
+               const SnapshotRegionDetails& rd // region details generated by DF
+               );
+
+    unsigned int hits()   const { return _hits;   }
+    unsigned int stores() const { return _stores; }
+  };
+}
+
+#endif // REGION_DETAILS_CACHE_H
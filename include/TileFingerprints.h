@@ -0,0 +1,144 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+#ifndef TILE_FINGERPRINTS_H
+#define TILE_FINGERPRINTS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace exportmaps_plugin
+{
+  class WorldData;
+
+  /*****************************************************************************
+   Fingerprints of the world data read by the maps, used by -incremental to
+   find what changed since the previous export.
+   Each world tile has a 32 bit hash for every group of fields of the region
+   map that some map reads, so a change in the vegetation doesn't mark the
+   tile as changed for the elevation maps. The sites, entities and
+   constructions drawn over the sites, trading, nobility and diplomacy maps
+   get a single hash for the whole world.
+   The fingerprints are saved with the name of the file written for each
+   map, so the next export knows which file to update.
+  *****************************************************************************/
+  class TileFingerprints
+  {
+  public:
+    // Groups of region map fields with their own hash
+    enum Field
+    {
+      FIELD_TERRAIN = 0, // Elevation, biome type, lake and river data
+      FIELD_BIOME_TYPE,
+      FIELD_REGION,      // Region id and type, biome type
+      FIELD_TEMPERATURE,
+      FIELD_RAINFALL,
+      FIELD_DRAINAGE,
+      FIELD_SAVAGERY,
+      FIELD_VOLCANISM,
+      FIELD_VEGETATION,
+      FIELD_EVILNESS,
+      FIELD_SALINITY,
+      FIELD_COUNT
+    };
+
+    // Kind of map of a file record
+    enum MapKind
+    {
+      KIND_DF  = 0,
+      KIND_RAW = 1,
+      KIND_HM  = 2
+    };
+
+  private:
+    // File written for a map in the export that saved the fingerprints
+    struct MapFile
+    {
+      uint32_t    kind; // MapKind
+      uint32_t    bit;  // MapType, MapTypeRaw or MapTypeHeightMap bit
+      std::string name;
+    };
+
+    int                   _width;    // World width in world coordinates
+    int                   _height;   // World height in world coordinates
+    std::vector<uint32_t> _hashes;   // FIELD_COUNT planes of one hash per world tile, by rows
+    uint64_t              _overlays; // Hash of sites, entities and constructions
+    std::vector<MapFile>  _files;
+
+  public:
+    TileFingerprints();
+
+    //----------------------------------------------------------------------------//
+    // Hash a block of bytes (FNV-1a), continuing from a previous hash
+    //----------------------------------------------------------------------------//
+    static uint64_t hash_bytes(const void* data,                     // Bytes to hash
+                               size_t size,                          // Number of bytes
+                               uint64_t hash = 14695981039346656037ULL // Previous hash or the initial value
+                               );
+
+    //----------------------------------------------------------------------------//
+    // Compute the fingerprints of every world tile. The file records are
+    // cleared, as only the maps exported with these fingerprints are valid
+    //----------------------------------------------------------------------------//
+    void compute(WorldData& world_data);
+
+    //----------------------------------------------------------------------------//
+    // Read the fingerprints saved by a previous export.
+    // Returns false if the file doesn't exist or is not valid
+    //----------------------------------------------------------------------------//
+    bool load(const std::string& filename);
+
+    //----------------------------------------------------------------------------//
+    // Write the fingerprints and the file records. Returns false on error
+    //----------------------------------------------------------------------------//
+    bool save(const std::string& filename) const;
+
+    //----------------------------------------------------------------------------//
+    // Return true if both fingerprints are of worlds of the same size
+    //----------------------------------------------------------------------------//
+    bool same_size(const TileFingerprints& other) const
+    {
+      return (_width == other._width) && (_height == other._height);
+    }
+
+    int width()  const { return _width;  }
+    int height() const { return _height; }
+
+    uint32_t hash(Field field, int x, int y) const
+    {
+      return _hashes[((size_t)field * _height + y) * _width + x];
+    }
+
+    uint64_t overlays() const { return _overlays; }
+
+    //----------------------------------------------------------------------------//
+    // Name of the file written for a map, or nullptr if there's none
+    //----------------------------------------------------------------------------//
+    const std::string* file(MapKind kind, uint32_t bit) const;
+
+    //----------------------------------------------------------------------------//
+    // Set the name of the file written for a map
+    //----------------------------------------------------------------------------//
+    void set_file(MapKind kind, uint32_t bit, const std::string& name);
+  };
+}
+
+#endif // TILE_FINGERPRINTS_H
@@ -0,0 +1,110 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef TILE_PYRAMID_H
+#define TILE_PYRAMID_H
+
+#include <tinythread.h>
+
+#include <string>
+#include <vector>
+
+namespace exportmaps_plugin
+{
+  /*****************************************************************************
+   Writes a RGBA image as a pyramid of 256x256 PNG tiles, using the z/x/y
+   layout of web map viewers (directory/z/x/y.png).
+   The deepest zoom level has the image at full resolution. Each level above
+   it is half the size of the previous one, built with a 2x2 box filter, until
+   the whole image fits in a single tile at zoom 0.
+   Tiles outside the image are padded with transparent pixels.
+  *****************************************************************************/
+  class TilePyramid
+  {
+  public:
+    static const int TILE_SIZE = 256;
+
+  private:
+    struct Level
+    {
+      std::vector<unsigned char> image;  // RGBA pixels of this level
+      int                        width;  // Level width in pixels
+      int                        height; // Level height in pixels
+      int                        tiles_x;// Number of tile columns
+      int                        tiles_y;// Number of tile rows
+    };
+
+    struct Tile
+    {
+      int z;
+      int x;
+      int y;
+    };
+
+    std::string        _directory; // Root directory of the pyramid
+    std::vector<Level> _levels;    // One entry for each zoom level, 0 = whole image in one tile
+    std::vector<Tile>  _tiles;     // All the tiles to be encoded
+    size_t             _next_tile; // Next tile to be encoded by a worker
+    unsigned int       _error;     // First lodepng error found by the workers
+    tthread::mutex     _mutex;     // Protects _next_tile and _error
+
+  public:
+    TilePyramid(const std::string directory,        // Root directory of the pyramid
+                std::vector<unsigned char>& image,  // RGBA pixels at full resolution, moved into the pyramid
+                int width,                          // Image width in pixels
+                int height                          // Image height in pixels
+                );
+
+    //----------------------------------------------------------------------------//
+    // The images of all the levels go back to the buffer pool
+    //----------------------------------------------------------------------------//
+    ~TilePyramid();
+
+    //----------------------------------------------------------------------------//
+    // Encode all the tiles, spreading them over several threads
+    // Returns 0 if all the tiles were written or the first lodepng error
+    //----------------------------------------------------------------------------//
+    unsigned int write_to_disk(unsigned int num_threads // Number of encoding threads
+                               );
+
+  private:
+    //----------------------------------------------------------------------------//
+    // Build a level from the next deeper one using a 2x2 box filter
+    //----------------------------------------------------------------------------//
+    static void downsample(const Level& source, // Deeper level
+                           Level& dest          // Level to be built
+                           );
+
+    //----------------------------------------------------------------------------//
+    // Copy a tile from a level and write it as a PNG
+    //----------------------------------------------------------------------------//
+    unsigned int encode_tile(const Tile& tile,                 // Tile to encode
+                             std::vector<unsigned char>& pixels // Scratch buffer for the tile pixels
+                             );
+
+    //----------------------------------------------------------------------------//
+    // Thread function that encodes tiles until there are no more left
+    //----------------------------------------------------------------------------//
+    static void worker(void* arg);
+  };
+}
+
+#endif // TILE_PYRAMID_H
@@ -0,0 +1,119 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace exportmaps_plugin
+{
+  /*****************************************************************************
+   Records timed spans of the export stages and writes them in the Chrome
+   trace event format (chrome://tracing, Perfetto).
+   Each thread records its spans in its own buffer, so threads never wait
+   for each other while tracing. The buffers are only read by write(),
+   once all the consumer threads have finished.
+   When tracing is not enabled a span costs a single atomic load.
+  *****************************************************************************/
+  class Tracer
+  {
+    static std::atomic<bool> _enabled;  // Spans are only recorded when true
+
+  public:
+    //----------------------------------------------------------------------------//
+    // Discard any previous spans and start recording
+    //----------------------------------------------------------------------------//
+    static void start();
+
+    //----------------------------------------------------------------------------//
+    // Stop recording and write all the spans as Chrome trace JSON.
+    // The recorded spans are freed. Returns false if the file can't be written
+    //----------------------------------------------------------------------------//
+    static bool write(const std::string& file_name // JSON file
+                      );
+
+    static bool is_enabled()
+    {
+      return _enabled.load(std::memory_order_relaxed);
+    }
+
+    //----------------------------------------------------------------------------//
+    // Nanoseconds since an arbitrary point, only meaningful as a difference
+    //----------------------------------------------------------------------------//
+    static int64_t now()
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    //----------------------------------------------------------------------------//
+    // Store a span in the buffer of the calling thread.
+    // name must be a string literal, as only the pointer is kept
+    //----------------------------------------------------------------------------//
+    static void record(const char* name, // Span name
+                       int64_t begin,    // now() at the start of the span
+                       int64_t end       // now() at the end of the span
+                       );
+
+    //----------------------------------------------------------------------------//
+    // Name shown for the calling thread in the trace viewer (string literal).
+    // Only the first name given to a thread is used
+    //----------------------------------------------------------------------------//
+    static void set_thread_name(const char* name);
+  };
+
+  /*****************************************************************************
+   Records a span from its construction to the end of the enclosing scope
+  *****************************************************************************/
+  class TraceSpan
+  {
+    const char* _name;  // nullptr if tracing was disabled when the span began
+    int64_t     _begin;
+
+  public:
+    explicit TraceSpan(const char* name // Span name, a string literal
+                       )
+      : _name(nullptr),
+        _begin(0)
+    {
+      if (Tracer::is_enabled())
+      {
+        _name  = name;
+        _begin = Tracer::now();
+      }
+    }
+
+    ~TraceSpan()
+    {
+      if (_name != nullptr)
+        Tracer::record(_name, _begin, Tracer::now());
+    }
+
+  private:
+    TraceSpan(const TraceSpan&);
+    TraceSpan& operator=(const TraceSpan&);
+  };
+}
+
+#endif // TRACER_H
@@ -0,0 +1,221 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef WORLD_DATA_H
+#define WORLD_DATA_H
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <tinythread.h>
+
+#include "WorldSnapshot.h"
+
+namespace exportmaps_plugin
+{
+  class RegionDetailsCache;
+
+  /*****************************************************************************
+   World data read by the terrain maps.
+   The consumers don't access DF directly but through this class, so the same
+   code renders the maps from the running game (DFWorldData) or from a world
+   snapshot (SnapshotWorldData).
+   The per world tile tables are stored using the snapshot records, so the
+   accessors used for every pixel are inline and don't depend on where the
+   data comes from. Only the region details, that are generated by DF on
+   demand, need a virtual call for each world tile.
+  *****************************************************************************/
+  class WorldData
+  {
+  protected:
+    int                           _world_width;  // World width in world coordinates
+    int                           _world_height; // World height in world coordinates
+    SnapshotWorldInfo             _world_info;   // Save folder, date and max elevation
+    const SnapshotRegionMapEntry* _region_map;   // One entry for each world tile, by rows
+    const SnapshotRegion*         _regions;      // Indexed by region id
+    size_t                        _region_count; // Number of world regions
+    const int32_t*                _river_flow;   // One entry for each world tile or nullptr
+
+    WorldData();
+
+  public:
+    virtual ~WorldData() {}
+
+    //----------------------------------------------------------------------------//
+    // Copy the region details of a world tile to rd.
+    // Returns false if they are not available
+    //----------------------------------------------------------------------------//
+    virtual bool region_details(int x,                    // world coordinate x
+                                int y,                    // world coordinate y
+                                SnapshotRegionDetails& rd // destination
+                                ) = 0;
+
+    //----------------------------------------------------------------------------//
+    // Hash of the sites, entities and constructions drawn over the maps, used
+    // to know if they changed since a previous export
+    //----------------------------------------------------------------------------//
+    virtual uint64_t overlay_fingerprint() = 0;
+
+    int world_width()  const { return _world_width;  }
+    int world_height() const { return _world_height; }
+
+    const SnapshotWorldInfo& world_info() const { return _world_info; }
+
+    std::string world_folder() const { return std::string(_world_info.world_folder); }
+    int         year()          const { return _world_info.year;  }
+    int         month()         const { return _world_info.month; }
+    int         day()           const { return _world_info.day;   }
+    int         max_elevation() const { return _world_info.max_elevation; }
+
+    const SnapshotRegionMapEntry& region_map(int x, int y) const
+    {
+      return _region_map[(size_t)y * _world_width + x];
+    }
+
+    int biome_type(int x, int y) const
+    {
+      return region_map(x, y).biome_type;
+    }
+
+    int num_regions() const { return (int)_region_count; }
+
+    // Return nullptr if the region doesn't exist
+    const SnapshotRegion* region(int region_id) const
+    {
+      if ((region_id < 0) || ((size_t)region_id >= _region_count)) return nullptr;
+      return &_regions[region_id];
+    }
+
+    // Flow of the river that crosses a world tile, or -1 if there's no river
+    int river_flow(int x, int y) const
+    {
+      if ((_river_flow == nullptr) ||
+          (x < 0) || (x >= _world_width) ||
+          (y < 0) || (y >= _world_height))
+        return -1;
+      return _river_flow[(size_t)y * _world_width + x];
+    }
+  };
+
+  /*****************************************************************************
+   World data read from a snapshot file
+  *****************************************************************************/
+  class SnapshotWorldData : public WorldData
+  {
+    WorldSnapshot _snapshot;
+
+  public:
+    //----------------------------------------------------------------------------//
+    // Open a snapshot file. Returns false if it's not a valid snapshot
+    //----------------------------------------------------------------------------//
+    bool open(const std::string& filename);
+
+    bool region_details(int x,
+                        int y,
+                        SnapshotRegionDetails& rd
+                        );
+
+    uint64_t overlay_fingerprint();
+  };
+
+  /*****************************************************************************
+   World data read from DF. The world tables are copied when the object is
+   created, so DF must be paused while it's being used
+  *****************************************************************************/
+  class DFWorldData : public WorldData
+  {
+    std::vector<SnapshotRegionMapEntry> _region_map_data;
+    std::vector<SnapshotRegion>         _regions_data;
+    std::vector<int32_t>                _river_flow_data;
+    RegionDetailsCache*                 _cache; // Region details kept between exports or nullptr
+
+  public:
+    DFWorldData();
+
+    //----------------------------------------------------------------------------//
+    // Read the region details from a cache before asking DF to generate them,
+    // and save there the ones generated. nullptr stops using it
+    //----------------------------------------------------------------------------//
+    void set_region_details_cache(RegionDetailsCache* cache) { _cache = cache; }
+
+    bool region_details(int x,
+                        int y,
+                        SnapshotRegionDetails& rd
+                        );
+
+    uint64_t overlay_fingerprint();
+  };
+
+  /*****************************************************************************
+   World data read from DF while the game runs.
+   DF can only generate region details while the game is paused, so they are
+   generated by generate(), called from the DF thread every frame, a few
+   world tiles at a time. They're generated ahead of the tile the export is
+   waiting for, in the order the world is swept, and region_details() waits
+   until its tile is ready. The tiles generated ahead that the export skips
+   are discarded, and all of them when the export starts another sweep. The rest of the world tables are copied when the object
+   is created, with DF paused
+  *****************************************************************************/
+  class FrameSlicedWorldData : public DFWorldData
+  {
+    struct Tile
+    {
+      size_t                index;   // y * world width + x
+      unsigned int          sweep;   // _sweep when it was generated
+      bool                  ok;      // DF generated them
+      SnapshotRegionDetails details;
+    };
+
+    tthread::mutex    _mutex;      // Protects all the fields below
+    std::deque<Tile>  _ready;      // Generated and not read yet, in sweep order
+    size_t            _capacity;   // Most tiles in _ready
+    size_t            _wanted;     // Tile the export is waiting for
+    size_t            _next;       // Next tile to generate
+    unsigned int      _sweep;      // Sweeps of the world started by the export
+    bool              _started;    // The export asked for its first tile
+    bool              _cancelled;  // No more tiles will be generated
+    const void*       _df_world;   // DF world data when created
+    uint64_t          _overlays;   // Overlay fingerprint, computed with DF paused
+
+  public:
+    FrameSlicedWorldData(size_t capacity // Most tiles generated ahead
+                         );
+
+    //----------------------------------------------------------------------------//
+    // Generate up to count tiles. Only from the DF thread, with the game paused
+    //----------------------------------------------------------------------------//
+    void generate(unsigned int count);
+
+    //----------------------------------------------------------------------------//
+    // Stop generating tiles. The export gets no more region details and ends
+    //----------------------------------------------------------------------------//
+    void cancel();
+
+    bool region_details(int x,
+                        int y,
+                        SnapshotRegionDetails& rd
+                        );
+
+    uint64_t overlay_fingerprint();
+  };
+}
+
+#endif // WORLD_DATA_H
@@ -0,0 +1,134 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef WORLD_GENERATOR_H
+#define WORLD_GENERATOR_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "WorldSnapshot.h"
+
+namespace exportmaps_plugin
+{
+  /*****************************************************************************
+   Parameters of a synthetic world
+  *****************************************************************************/
+  struct WorldGeneratorOptions
+  {
+    int      world_width;        // World width in world coordinates
+    int      world_height;       // World height in world coordinates
+    uint32_t seed;               // Same seed and sizes, same world
+    int      num_sites;          // Number of world sites
+    int      num_entities;       // Number of historical entities
+    int      num_roads;          // Number of roads between sites
+
+    WorldGeneratorOptions()
+      : world_width(257),
+        world_height(257),
+        seed(1),
+        num_sites(-1),           // -1 means chosen from the world size
+        num_entities(-1),
+        num_roads(-1)
+    {}
+  };
+
+  /*****************************************************************************
+   Deterministic generator of synthetic worlds in snapshot format.
+   It's used to test the maps with worlds bigger than the ones DF creates and
+   without keeping real saves around.
+   Every field is computed from fractal value noise sampled in embark
+   coordinates, so the region details of neighbour world tiles match at their
+   borders. Rivers are traced downhill from the mountains to the sea. Regions
+   are the cells of a jittered grid, so their number is known before the file
+   is created and the per world tile sections are written straight into the
+   mapped file
+  *****************************************************************************/
+  class WorldGenerator
+  {
+    WorldGeneratorOptions _options;
+
+    // A region seed. The world tiles take the region of the nearest seed
+    struct RegionSeed
+    {
+      int x;                     // World coordinates of the seed
+      int y;
+      int biome_type;            // Biome at the seed, gives the region type
+    };
+
+    std::vector<RegionSeed> _region_seeds;  // One for each grid cell
+    int                     _region_cols;   // Grid size in cells
+    int                     _region_rows;
+
+  public:
+    WorldGenerator(const WorldGeneratorOptions& options);
+
+    //----------------------------------------------------------------------------//
+    // Generate the world and write it as a snapshot file.
+    // Returns false if the file can't be created
+    //----------------------------------------------------------------------------//
+    bool write(const std::string& filename);
+
+  private:
+    void generate_sites(std::vector<SnapshotSite>& sites);
+
+    void generate_entities(const std::vector<SnapshotSite>& sites,
+                           std::vector<SnapshotEntity>& entities,
+                           std::vector<SnapshotEntitySiteLink>& links
+                           );
+
+    void generate_roads(const std::vector<SnapshotSite>& sites,
+                        std::vector<SnapshotConstruction>& constructions,
+                        std::vector<SnapshotConstructionSquare>& squares,
+                        std::vector<SnapshotConstructionPoint>& points
+                        );
+
+    void trace_rivers(SnapshotRegionMapEntry* region_map,
+                      int32_t* river_flow,
+                      std::vector<uint8_t>& river_sides
+                      );
+
+    void fill_region_map_entry(int x,                     // world coordinate x
+                               int y,                     // world coordinate y
+                               SnapshotRegionMapEntry& rme
+                               ) const;
+
+    void fill_region_details(int x,                       // world coordinate x
+                             int y,                       // world coordinate y
+                             const SnapshotRegionMapEntry& rme,
+                             unsigned int river_sides,    // RIVER_SIDE bits
+                             SnapshotRegionDetails& rd
+                             ) const;
+
+    // Fields, sampled in embark coordinates
+    int elevation(int ex, int ey) const;
+    int field(int ex, int ey, int scale, uint32_t salt) const;
+
+    int region_id(int x, int y, int biome_type) const;
+    int region_type(int biome_type) const;
+    int biome_type(const SnapshotRegionMapEntry& rme) const;
+
+    double fractal_noise(int ex, int ey, int scale, uint32_t salt) const;
+  };
+}
+
+#endif // WORLD_GENERATOR_H
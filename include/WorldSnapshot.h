@@ -0,0 +1,296 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef WORLD_SNAPSHOT_H
+#define WORLD_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "./util/MappedFile.h"
+
+namespace exportmaps_plugin
+{
+  /*****************************************************************************
+   World snapshot file format.
+   A snapshot stores every piece of DF data that the consumers read, so the
+   maps can be rendered later without DF running.
+   The file has a header, a table of sections and then the sections, each one
+   starting at a 4096 bytes boundary. Every section is an array of fixed size
+   records stored in little endian format, so the file can be mapped in memory
+   and the records used directly.
+   Lists of variable size (site links of an entity, squares of a construction)
+   are stored in their own section and referenced by first index and count.
+   The format is described in docs/snapshot.md
+  *****************************************************************************/
+
+  static const char     SNAPSHOT_MAGIC[8]  = {'E','X','P','M','A','P','W','S'};
+  static const uint32_t SNAPSHOT_VERSION   = 2;
+
+  enum SnapshotSectionId : uint32_t
+  {
+    SECTION_REGION_MAP           = 1, // SnapshotRegionMapEntry for each world tile
+    SECTION_REGIONS              = 2, // SnapshotRegion for each world region
+    SECTION_REGION_DETAILS       = 3, // SnapshotRegionDetails for each world tile
+    SECTION_SITES                = 4, // SnapshotSite for each world site
+    SECTION_ENTITIES             = 5, // SnapshotEntity for each historical entity
+    SECTION_ENTITY_SITE_LINKS    = 6, // SnapshotEntitySiteLink
+    SECTION_CONSTRUCTIONS        = 7, // SnapshotConstruction for each world construction
+    SECTION_CONSTRUCTION_SQUARES = 8, // SnapshotConstructionSquare
+    SECTION_CONSTRUCTION_POINTS  = 9, // SnapshotConstructionPoint
+    SECTION_WORLD_INFO           = 10,// A single SnapshotWorldInfo
+    SECTION_RIVER_FLOW           = 11 // int32_t for each world tile, -1 if there's no river
+  };
+
+  // Region map flags used by the maps, independent of the DF bit positions
+  enum SnapshotRegionFlags : uint32_t
+  {
+    REGION_FLAG_HAS_RIVER = 1u << 0,
+    REGION_FLAG_IS_BROOK  = 1u << 1,
+    REGION_FLAG_IS_LAKE   = 1u << 2
+  };
+
+  // File header (64 bytes)
+  struct SnapshotHeader
+  {
+    char     magic[8];           // EXPMAPWS
+    uint32_t version;            // SNAPSHOT_VERSION
+    uint32_t header_size;        // sizeof(SnapshotHeader)
+    uint32_t world_width;        // World width in world coordinates
+    uint32_t world_height;       // World height in world coordinates
+    uint32_t section_count;      // Number of entries in the section table
+    uint32_t section_entry_size; // sizeof(SnapshotSection)
+    uint8_t  unused[32];
+  };
+
+  // Entry of the section table (32 bytes)
+  struct SnapshotSection
+  {
+    uint32_t id;                 // SnapshotSectionId
+    uint32_t record_size;        // Size in bytes of each record
+    uint64_t record_count;       // Number of records
+    uint64_t offset;             // Offset of the first record in the file
+    uint64_t unused;
+  };
+
+  // region_map data of a world tile (32 bytes)
+  struct SnapshotRegionMapEntry
+  {
+    int32_t  region_id;
+    int16_t  biome_type;         // Biome type as returned by get_biome_type
+    int16_t  elevation;
+    int16_t  temperature;
+    int16_t  rainfall;
+    int16_t  drainage;
+    int16_t  savagery;
+    int16_t  volcanism;
+    int16_t  vegetation;
+    int16_t  evilness;
+    int16_t  salinity;
+    int16_t  geo_index;
+    int16_t  flags_size;         // Size in bytes of the DF flags bit array
+    uint32_t flags;              // SnapshotRegionFlags
+  };
+
+  // World region data (8 bytes)
+  struct SnapshotRegion
+  {
+    int32_t  type;
+    int32_t  lake_surface;
+  };
+
+  // region_details data of a world tile (3048 bytes)
+  struct SnapshotRegionDetails
+  {
+    int16_t  pos_x;
+    int16_t  pos_y;
+    int16_t  elevation[17][17];
+    int8_t   biome[17][17];
+    int8_t   unused;
+    int16_t  rivers_vertical_x_min[16][17];
+    int16_t  rivers_vertical_elevation[16][17];
+    int16_t  rivers_horizontal_y_min[17][16];
+    int16_t  rivers_horizontal_elevation[17][16];
+  };
+
+  // World site (24 bytes)
+  struct SnapshotSite
+  {
+    int32_t  id;
+    int16_t  type;
+    int16_t  flags_size;         // Size in bytes of the DF flags bit array
+    uint32_t flags;              // First 32 bits of the DF flags bit array
+    int16_t  global_min_x;
+    int16_t  global_min_y;
+    int16_t  global_max_x;
+    int16_t  global_max_y;
+    int32_t  population;         // Sum of the inhabitants of the site
+  };
+
+  // Historical entity (16 bytes)
+  struct SnapshotEntity
+  {
+    int32_t  id;
+    int32_t  type;
+    uint32_t first_site_link;    // Index in SECTION_ENTITY_SITE_LINKS
+    uint32_t site_link_count;
+  };
+
+  // Link between an entity and a site (8 bytes)
+  struct SnapshotEntitySiteLink
+  {
+    int32_t  target;             // Site id
+    uint32_t flags;              // DF entity_site_link flags
+  };
+
+  // World construction: road, tunnel, bridge or wall (16 bytes)
+  struct SnapshotConstruction
+  {
+    int32_t  id;
+    int32_t  type;               // 0 road, 1 tunnel, 2 bridge, 3 wall
+    uint32_t first_square;       // Index in SECTION_CONSTRUCTION_SQUARES
+    uint32_t square_count;
+  };
+
+  // World tile crossed by a construction (16 bytes)
+  struct SnapshotConstructionSquare
+  {
+    int16_t  region_x;           // World coordinates of the square
+    int16_t  region_y;
+    int16_t  stone;              // 1 if the construction is made of stone
+    int16_t  unused;
+    uint32_t first_point;        // Index in SECTION_CONSTRUCTION_POINTS
+    uint32_t point_count;
+  };
+
+  // Embark tile of a construction square (4 bytes)
+  struct SnapshotConstructionPoint
+  {
+    int16_t  embark_x;           // 0..15
+    int16_t  embark_y;           // 0..15
+  };
+
+  // World information used to name the maps and scale the heightmaps (80 bytes)
+  struct SnapshotWorldInfo
+  {
+    char     world_folder[64];   // Save folder name, ending with zeros
+    int32_t  year;               // Current date
+    int32_t  month;              // 1..12
+    int32_t  day;                // 1..28
+    int32_t  max_elevation;      // Height of the highest mountain peak
+  };
+
+  /*****************************************************************************
+   Read only access to a snapshot file mapped in memory
+  *****************************************************************************/
+  class WorldSnapshot
+  {
+    MappedFile                    _file;           // Snapshot file mapped in memory
+    const SnapshotHeader*         _header;         // Start of the file or nullptr
+    const SnapshotRegionMapEntry* _region_map;     // Start of SECTION_REGION_MAP
+    const SnapshotRegionDetails*  _region_details; // Start of SECTION_REGION_DETAILS
+
+  public:
+    WorldSnapshot();
+
+    //----------------------------------------------------------------------------//
+    // Map a snapshot file and check its header and sections.
+    // Returns false if the file can't be read or is not a valid snapshot
+    //----------------------------------------------------------------------------//
+    bool open(const std::string& filename);
+
+    //----------------------------------------------------------------------------//
+    // Unmap the snapshot file
+    //----------------------------------------------------------------------------//
+    void close();
+
+    int world_width()  const { return _header->world_width;  }
+    int world_height() const { return _header->world_height; }
+
+    //----------------------------------------------------------------------------//
+    // Return the records of a section and their number, or nullptr if the
+    // section is not present
+    //----------------------------------------------------------------------------//
+    const void* section(SnapshotSectionId id, // Section to find
+                        size_t& count         // Number of records
+                        ) const;
+
+    //----------------------------------------------------------------------------//
+    // Direct access to the per world tile sections. Both are stored by rows
+    //----------------------------------------------------------------------------//
+    const SnapshotRegionMapEntry& region_map(int x, int y) const
+    {
+      return _region_map[(size_t)y * _header->world_width + x];
+    }
+
+    const SnapshotRegionDetails& region_details(int x, int y) const
+    {
+      return _region_details[(size_t)y * _header->world_width + x];
+    }
+
+  private:
+    const SnapshotSection* find_section(SnapshotSectionId id) const;
+  };
+
+  /*****************************************************************************
+   Creates a snapshot file.
+   All the sections are declared first with their number of records. Then the
+   file is created with its final size and mapped in memory, so the records
+   can be filled directly in any order
+  *****************************************************************************/
+  class WorldSnapshotWriter
+  {
+    MappedFile                   _file;     // Snapshot file mapped in memory
+    std::vector<SnapshotSection> _sections; // Sections declared so far
+
+  public:
+    //----------------------------------------------------------------------------//
+    // Declare a section before creating the file
+    //----------------------------------------------------------------------------//
+    void add_section(SnapshotSectionId id, // Section id
+                     size_t record_size,   // Size of each record
+                     size_t record_count   // Number of records
+                     );
+
+    //----------------------------------------------------------------------------//
+    // Create the file with all the declared sections and write its header.
+    // Returns false if the file can't be created
+    //----------------------------------------------------------------------------//
+    bool create(const std::string& filename, // Snapshot file
+                int world_width,             // World width in world coordinates
+                int world_height             // World height in world coordinates
+                );
+
+    //----------------------------------------------------------------------------//
+    // Return the first record of a section, to be filled by the caller
+    //----------------------------------------------------------------------------//
+    void* records(SnapshotSectionId id);
+
+    //----------------------------------------------------------------------------//
+    // Unmap the file. If remove is true the unfinished file is deleted
+    //----------------------------------------------------------------------------//
+    void close(bool remove = false);
+  };
+}
+
+#endif // WORLD_SNAPSHOT_H
@@ -0,0 +1,103 @@
+/*
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+// You can always find the latest version of this plugin in Github
+// https://github.com/ragundo/exportmaps
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+#include <string>
+
+namespace exportmaps_plugin
+{
+  /*****************************************************************************
+   A file of a fixed size mapped in memory.
+   The file is created (or truncated) with the requested size and its contents
+   can be written directly through the pointer returned by data(). The OS
+   writes the pages back to disk when the file is unmapped.
+   An existing file can also be mapped read only, or for reading and
+   writing to update it in place.
+  *****************************************************************************/
+  class MappedFile
+  {
+    std::string    _filename; // Name of the file mapped
+    unsigned char* _data;     // Start of the mapped memory or nullptr
+    size_t         _size;     // Size in bytes of the file
+#ifdef WIN32
+    void*          _file;     // Windows file handle
+    void*          _mapping;  // Windows file mapping handle
+#else
+    int            _fd;       // POSIX file descriptor
+#endif
+
+  public:
+    MappedFile();
+    ~MappedFile();
+
+    //----------------------------------------------------------------------------//
+    // Create a file of the given size and map it in memory.
+    // Returns false if the file could not be created or mapped
+    //----------------------------------------------------------------------------//
+    bool open(const std::string& filename, // Name of the file to create
+              size_t size                  // Size in bytes of the file
+              );
+
+    //----------------------------------------------------------------------------//
+    // Map an existing file in memory for reading.
+    // Returns false if the file does not exist, is empty or could not be mapped
+    //----------------------------------------------------------------------------//
+    bool open_read(const std::string& filename // Name of the file to map
+                   );
+
+    //----------------------------------------------------------------------------//
+    // Map an existing file in memory for reading and writing, keeping its size.
+    // Returns false if the file does not exist, is empty or could not be mapped
+    //----------------------------------------------------------------------------//
+    bool open_update(const std::string& filename // Name of the file to map
+                     );
+
+    //----------------------------------------------------------------------------//
+    // Unmap the file. If remove is true the file is deleted from disk
+    //----------------------------------------------------------------------------//
+    void close(bool remove = false);
+
+    //----------------------------------------------------------------------------//
+    // Return true if the file is currently mapped in memory
+    //----------------------------------------------------------------------------//
+    bool is_open() const { return _data != nullptr; }
+
+    //----------------------------------------------------------------------------//
+    // Return a pointer to the mapped memory
+    //----------------------------------------------------------------------------//
+    unsigned char* data() const { return _data; }
+
+    //----------------------------------------------------------------------------//
+    // Return the size of the mapped file in bytes
+    //----------------------------------------------------------------------------//
+    size_t size() const { return _size; }
+
+  private:
+    // Not copyable, as it owns the mapping
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+  };
+}
+
+#endif // MAPPED_FILE_H